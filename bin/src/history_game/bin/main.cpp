@@ -4,6 +4,7 @@
 #include <random>
 #include <map>
 #include <set>
+#include <algorithm>
 #include <filesystem>
 #include <cpioo/managed_entity.hpp>
 #include <spdlog/spdlog.h>
@@ -18,17 +19,15 @@
 #include <history_game/systems/utility/log_init.h>
 #include <history_game/systems/utility/serialization.h>
 #include <history_game/systems/simulation/simulation_runner.h>
+#include <history_game/systems/relationship/social_graph.h>
 #include <history_game/datamodel/memory/perception_buffer.h>
+#include <history_game/datamodel/pool/pool_stats.h>
 
 namespace history_game::bin {
 
-// Helper to create a unique ID with a prefix
-std::string createId(const std::string& prefix) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(1000, 9999);
-    
-    return prefix + "_" + std::to_string(dis(gen));
+// Helper to create a unique ID with a prefix from an entity's handle
+std::string createId(const std::string& prefix, datamodel::entity::EntityHandle handle) {
+    return prefix + "_" + std::to_string(handle.index());
 }
 
 // Create a position with random coordinates
@@ -43,15 +42,18 @@ datamodel::world::Position createRandomPosition(float x_min, float x_max, float
 }
 
 // Create an entity with a random position
-datamodel::entity::Entity::ref_type createEntity(const std::string& id_prefix, float x_min, float x_max, float y_min, float y_max) {
-    datamodel::entity::Entity entity(createId(id_prefix), createRandomPosition(x_min, x_max, y_min, y_max));
+datamodel::entity::Entity::ref_type createEntity(datamodel::entity::EntityRegistry& registry, const std::string& id_prefix,
+                                                 float x_min, float x_max, float y_min, float y_max) {
+    auto handle = registry.issue();
+    datamodel::entity::Entity entity(createId(id_prefix, handle), createRandomPosition(x_min, x_max, y_min, y_max), handle);
     return datamodel::entity::Entity::storage::make_entity(std::move(entity));
 }
 
 // Create an NPC with basic drives
-datamodel::npc::NPC::ref_type createNPC(const std::string& id_prefix, float x_min, float x_max, float y_min, float y_max) {
+datamodel::npc::NPC::ref_type createNPC(datamodel::entity::EntityRegistry& registry, const std::string& id_prefix,
+                                        float x_min, float x_max, float y_min, float y_max) {
     // Create the entity
-    auto entity = createEntity(id_prefix, x_min, x_max, y_min, y_max);
+    auto entity = createEntity(registry, id_prefix, x_min, x_max, y_min, y_max);
     
     // Create NPCIdentity
     datamodel::npc::NPCIdentity identity(entity);
@@ -62,7 +64,7 @@ datamodel::npc::NPC::ref_type createNPC(const std::string& id_prefix, float x_mi
     static std::mt19937 gen(rd());
     std::uniform_real_distribution<> intensity_dis(10.0f, 40.0f);
     
-    std::vector<datamodel::npc::Drive> drives = {
+    datamodel::npc::DriveSet drives = {
         datamodel::npc::Drive(datamodel::npc::drive::Sustenance{}, intensity_dis(gen)),
         datamodel::npc::Drive(datamodel::npc::drive::Shelter{}, intensity_dis(gen)),
         datamodel::npc::Drive(datamodel::npc::drive::Belonging{}, intensity_dis(gen)),
@@ -80,12 +82,13 @@ datamodel::npc::NPC::ref_type createNPC(const std::string& id_prefix, float x_mi
 }
 
 // Create a food object
-datamodel::object::WorldObject::ref_type createFoodObject(const std::string& id_prefix, 
+datamodel::object::WorldObject::ref_type createFoodObject(datamodel::entity::EntityRegistry& registry,
+                                      const std::string& id_prefix, 
                                       float x_min, float x_max, 
                                       float y_min, float y_max,
                                       const datamodel::npc::NPCIdentity::ref_type& creator) {
     // Create the entity
-    auto entity = createEntity(id_prefix, x_min, x_max, y_min, y_max);
+    auto entity = createEntity(registry, id_prefix, x_min, x_max, y_min, y_max);
     
     // Create the object
     datamodel::object::WorldObject obj(entity, datamodel::object::object_category::Food{}, creator);
@@ -93,12 +96,13 @@ datamodel::object::WorldObject::ref_type createFoodObject(const std::string& id_
 }
 
 // Create a structure object
-datamodel::object::WorldObject::ref_type createStructureObject(const std::string& id_prefix, 
+datamodel::object::WorldObject::ref_type createStructureObject(datamodel::entity::EntityRegistry& registry,
+                                           const std::string& id_prefix, 
                                            float x_min, float x_max, 
                                            float y_min, float y_max,
                                            const datamodel::npc::NPCIdentity::ref_type& creator) {
     // Create the entity
-    auto entity = createEntity(id_prefix, x_min, x_max, y_min, y_max);
+    auto entity = createEntity(registry, id_prefix, x_min, x_max, y_min, y_max);
     
     // Create the object
     datamodel::object::WorldObject obj(entity, datamodel::object::object_category::Structure{}, creator);
@@ -127,10 +131,13 @@ int main() {
     // Create a larger world space
     const float WORLD_SIZE = 1000.0f;
     
+    // Issues the handles of the simulation's entities, and takes back those leaving the world
+    datamodel::entity::EntityRegistry entity_registry;
+    
     // Create 100 NPCs distributed across the world space
     std::vector<datamodel::npc::NPC::ref_type> npcs;
     for (int i = 0; i < 100; ++i) {
-        npcs.push_back(createNPC("npc", 0.0f, WORLD_SIZE, 0.0f, WORLD_SIZE));
+        npcs.push_back(createNPC(entity_registry, "npc", 0.0f, WORLD_SIZE, 0.0f, WORLD_SIZE));
     }
     
     // Create some initial objects
@@ -145,14 +152,14 @@ int main() {
     for (int i = 0; i < 50; ++i) {
         // Randomly select an NPC to be the creator
         int npc_idx = npc_dis(gen);
-        objects.push_back(createFoodObject("food", 0.0f, WORLD_SIZE, 0.0f, WORLD_SIZE, npcs[npc_idx]->identity));
+        objects.push_back(createFoodObject(entity_registry, "food", 0.0f, WORLD_SIZE, 0.0f, WORLD_SIZE, npcs[npc_idx]->getIdentity()));
     }
     
     // Add structure objects (50) spread across the world space
     for (int i = 0; i < 50; ++i) {
         // Randomly select an NPC to be the creator
         int npc_idx = npc_dis(gen);
-        objects.push_back(createStructureObject("shelter", 0.0f, WORLD_SIZE, 0.0f, WORLD_SIZE, npcs[npc_idx]->identity));
+        objects.push_back(createStructureObject(entity_registry, "shelter", 0.0f, WORLD_SIZE, 0.0f, WORLD_SIZE, npcs[npc_idx]->getIdentity()));
     }
     
     // Create the initial world state
@@ -169,18 +176,18 @@ int main() {
     // Add all NPCs to the entity list
     for (const auto& npc : npcs) {
         systems::utility::json npc_json;
-        npc_json["id"] = npc->identity->entity->id;
+        npc_json["id"] = npc->getIdentity()->entity->id;
         npc_json["type"] = "NPC";
         
         // Add position data
         systems::utility::json position;
-        position["x"] = npc->identity->entity->position.x;
-        position["y"] = npc->identity->entity->position.y;
+        position["x"] = npc->getIdentity()->entity->position.x;
+        position["y"] = npc->getIdentity()->entity->position.y;
         npc_json["position"] = position;
         
         // Add drives data
         systems::utility::json drives_json = systems::utility::json::array();
-        for (const auto& drive : npc->drives) {
+        for (const auto& drive : npc->getDrives()) {
             systems::utility::json drive_json;
             drive_json["type"] = systems::drives::drive_dynamics_system::get_drive_name(drive.type);
             drive_json["value"] = drive.intensity;
@@ -237,6 +244,38 @@ int main() {
         2      // Min sequence length
     );
     
+    // Population-wide index of the behaviors NPCs remember
+    systems::memory::SequenceTrie sequence_trie;
+    
+    // Detects NPCs doing the same thing in the same place and time window
+    systems::perception::ConvergenceDetector convergence_detector;
+    
+    // Remembers how observations impacted each NPC
+    systems::drives::ImpactCache impact_cache;
+    
+    // Applies the NPCs' interactions to their relationships
+    systems::relationship::RelationshipUpdater relationship_updater;
+    
+    // Frees the world versions each tick leaves behind
+    systems::simulation::WorldReclaimer world_reclaimer;
+    
+    // Population-wide view of the relationships, synced at every decay step
+    systems::relationship::SocialGraph social_graph(relationship_updater.parameters().decay);
+    
+    // Report the storage allocations of every tick as it runs
+    uint64_t allocations_so_far = 0;
+    auto report_allocations = [&allocations_so_far](const datamodel::world::World::ref_type&, uint64_t tick) {
+        uint64_t allocations = 0;
+        uint64_t live = 0;
+        for (const auto& pool : datamodel::pool::pool_system::getStats()) {
+            allocations += pool.allocations;
+            live += pool.live;
+        }
+        spdlog::debug("Tick {}: {} allocations, {} objects live",
+                      tick, allocations - allocations_so_far, live);
+        allocations_so_far = allocations;
+    };
+    
     // Run the simulation for 200 ticks (2 generations)
     // Shorter run for development to avoid long build times
     datamodel::world::World::ref_type final_world = systems::simulation::runSimulation(
@@ -244,18 +283,27 @@ int main() {
         200,  // 200 ticks for development
         params, 
         100.0f, // Increased perception range for larger world
-        &sim_logger // Pass the serialization logger
+        &sim_logger, // Pass the serialization logger
+        report_allocations,
+        &sequence_trie,
+        &convergence_detector,
+        &impact_cache,
+        &relationship_updater,
+        &world_reclaimer,
+        &social_graph,
+        &entity_registry
     );
+    world_reclaimer.drain();
     
     // Log simulation end event
     current_time = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::system_clock::now().time_since_epoch()).count();
     sim_logger.logEvent(systems::utility::createSimulationEndEvent(
         current_time, 
-        final_world->clock->current_tick,
-        final_world->clock->current_generation,
-        final_world->npcs.size(), 
-        final_world->objects.size()));
+        final_world->getClock()->current_tick,
+        final_world->getClock()->current_generation,
+        final_world->getNPCs().size(), 
+        final_world->getObjects().size()));
     
     // Close the serialization logger
     sim_logger.shutdown();
@@ -265,10 +313,66 @@ int main() {
     
     // Print final state summary
     spdlog::info("Simulation completed");
-    spdlog::info("Final tick: {}", final_world->clock->current_tick);
-    spdlog::info("Final generation: {}", final_world->clock->current_generation);
-    spdlog::info("NPCs: {}", final_world->npcs.size());
-    spdlog::info("Objects: {}", final_world->objects.size());
+    spdlog::info("Final tick: {}", final_world->getClock()->current_tick);
+    spdlog::info("Final generation: {}", final_world->getClock()->current_generation);
+    spdlog::info("NPCs: {}", final_world->getNPCs().size());
+    spdlog::info("Objects: {}", final_world->getObjects().size());
+    
+    // Print memory budget evictions
+    const auto& evictions = systems::memory::memory_budget_system::getEvictionStats();
+    spdlog::info("Evicted memories: {} episodes, {} behaviors, {} relationships ({} bytes)",
+                 evictions.episodes.load(), evictions.observed_behaviors.load(),
+                 evictions.relationships.load(), evictions.bytes.load());
+    
+    // Print remembered behavior statistics
+    spdlog::info("Remembered behaviors: {} sequences in {} trie nodes",
+                 sequence_trie.sequenceCount(), sequence_trie.nodeCount());
+    
+    // Print convergence statistics
+    spdlog::info("Convergences: {} detected, {} still active",
+                 convergence_detector.totalConvergences(), convergence_detector.activeCount());
+    
+    // Print impact cache statistics
+    spdlog::info("Impact cache: {} hits, {} misses", impact_cache.hits(), impact_cache.misses());
+    
+    // Print relationship statistics
+    spdlog::info("Relationships: {} formed, {} updated",
+                 relationship_updater.createdCount(), relationship_updater.updatedCount());
+    
+    // Print world reclamation statistics
+    spdlog::info("Reclaimed worlds: {} in {} batches, {:.1f} ms {}",
+                 world_reclaimer.reclaimedCount(), world_reclaimer.batchCount(),
+                 world_reclaimer.reclaimTime().count() / 1e6,
+                 systems::simulation::WorldReclaimer::BACKGROUND ? "in the background" : "between ticks");
+    
+    // Print social graph statistics, rereading only the NPCs changed since the last decay step
+    social_graph.sync(final_world);
+    auto degrees = social_graph.getDegrees();
+    spdlog::info("Social graph: {} NPCs, {} ties, {} components, {} communities",
+                 social_graph.nodeCount(), social_graph.edgeCount(),
+                 systems::relationship::social_graph_system::countLabels(social_graph.getConnectedComponents()),
+                 systems::relationship::social_graph_system::countLabels(social_graph.getCommunities()));
+    if (social_graph.nodeCount() > 0) {
+        auto central = std::max_element(degrees.strength.begin(), degrees.strength.end()) - degrees.strength.begin();
+        spdlog::info("Most familiar NPC: {} (known by {} NPCs)",
+                     social_graph.getNodeId(central), degrees.in[central]);
+    }
+    
+    // Print storage statistics
+    spdlog::info("Storage pools:");
+    uint64_t ticks = std::max<uint64_t>(final_world->getClock()->current_tick, 1);
+    for (const auto& pool : datamodel::pool::pool_system::getStats()) {
+        spdlog::info("  {}: {} live, {} peak, {} chunks of {}, {:.1f}% used, {:.1f} allocations/tick, {:.1f} shared/tick",
+                     pool.name, pool.live, pool.peak, pool.chunks, pool.chunk_size,
+                     pool.utilization() * 100.0f, static_cast<double>(pool.allocations) / ticks,
+                     static_cast<double>(pool.shared) / ticks);
+    }
+    if (datamodel::pool::hash_cons_system::ENABLED) {
+        auto contention = datamodel::pool::hash_cons_system::getContention();
+        spdlog::info("Hash-consing: {} lookups, {} waited for a shard lock ({:.2f}%)",
+                     contention.lookups, contention.contended,
+                     contention.lookups ? 100.0 * contention.contended / contention.lookups : 0.0);
+    }
     
     // Print summary statistics instead of individual NPCs
     spdlog::info("NPC Population Summary:");
@@ -285,21 +389,21 @@ int main() {
     std::map<std::string, float> total_drive_values;
     std::map<std::string, int> drive_counts;
     
-    for (const auto& npc : final_world->npcs) {
+    for (const auto& npc : final_world->getNPCs()) {
         // Count actions
-        if (npc->identity->current_action) {
-            std::string action_name = systems::behavior::action_selection_system::get_action_name(npc->identity->current_action.value());
+        if (npc->getIdentity()->current_action) {
+            std::string action_name = systems::behavior::action_selection_system::get_action_name(npc->getIdentity()->current_action.value());
             action_counts[action_name]++;
         } else {
             no_action_count++;
         }
         
         // Count perceptions and memories
-        total_perceptions += npc->perception->recent_perceptions.size();
-        total_episodes += npc->episodic_memory.size();
+        total_perceptions += npc->getPerception()->recent_perceptions.size();
+        total_episodes += npc->getEpisodicMemory().size();
         
         // Sum drive values
-        for (const auto& drive : npc->drives) {
+        for (const auto& drive : npc->getDrives()) {
             std::string drive_name = systems::drives::drive_dynamics_system::get_drive_name(drive.type);
             total_drive_values[drive_name] += drive.intensity;
             drive_counts[drive_name]++;
@@ -310,16 +414,16 @@ int main() {
     spdlog::info("Action Distribution:");
     for (const auto& [action, count] : action_counts) {
         spdlog::info("  {}: {} NPCs ({:.1f}%)", 
-                    action, count, (count * 100.0f) / final_world->npcs.size());
+                    action, count, (count * 100.0f) / final_world->getNPCs().size());
     }
     if (no_action_count > 0) {
         spdlog::info("  No Action: {} NPCs ({:.1f}%)", 
-                    no_action_count, (no_action_count * 100.0f) / final_world->npcs.size());
+                    no_action_count, (no_action_count * 100.0f) / final_world->getNPCs().size());
     }
     
     // Print memory statistics
-    float avg_perceptions = total_perceptions / static_cast<float>(final_world->npcs.size());
-    float avg_episodes = total_episodes / static_cast<float>(final_world->npcs.size());
+    float avg_perceptions = total_perceptions / static_cast<float>(final_world->getNPCs().size());
+    float avg_episodes = total_episodes / static_cast<float>(final_world->getNPCs().size());
     spdlog::info("Memory Statistics:");
     spdlog::info("  Average perception buffer size: {:.2f}", avg_perceptions);
     spdlog::info("  Average episodic memories: {:.2f}", avg_episodes);
@@ -334,43 +438,43 @@ int main() {
     
     // Print 5 random NPCs for a more detailed view
     spdlog::info("\nDetailed view of 5 random NPCs:");
-    std::uniform_int_distribution<> sample_dis(0, final_world->npcs.size() - 1);
+    std::uniform_int_distribution<> sample_dis(0, final_world->getNPCs().size() - 1);
     
     std::set<int> sampled_indices;
-    while (sampled_indices.size() < 5 && sampled_indices.size() < final_world->npcs.size()) {
+    while (sampled_indices.size() < 5 && sampled_indices.size() < final_world->getNPCs().size()) {
         sampled_indices.insert(sample_dis(gen));
     }
     
     for (int idx : sampled_indices) {
-        const auto& npc = final_world->npcs[idx];
+        const auto& npc = final_world->getNPCs()[idx];
         spdlog::info("NPC {}: Position ({:.2f}, {:.2f})", 
-                    npc->identity->entity->id,
-                    npc->identity->entity->position.x,
-                    npc->identity->entity->position.y);
+                    npc->getIdentity()->entity->id,
+                    npc->getIdentity()->entity->position.x,
+                    npc->getIdentity()->entity->position.y);
         
         // Print drive levels
-        for (const auto& drive : npc->drives) {
+        for (const auto& drive : npc->getDrives()) {
             std::string drive_name = systems::drives::drive_dynamics_system::get_drive_name(drive.type);
             spdlog::info("  Drive {}: {:.2f}", drive_name, drive.intensity);
         }
         
         // Print memory stats
-        spdlog::info("  Perception buffer: {} entries", npc->perception->recent_perceptions.size());
-        spdlog::info("  Episodic memories: {} episodes", npc->episodic_memory.size());
+        spdlog::info("  Perception buffer: {} entries", npc->getPerception()->recent_perceptions.size());
+        spdlog::info("  Episodic memories: {} episodes", npc->getEpisodicMemory().size());
         
         // Print current action if any
-        if (npc->identity->current_action) {
-            std::string action_name = systems::behavior::action_selection_system::get_action_name(npc->identity->current_action.value());
+        if (npc->getIdentity()->current_action) {
+            std::string action_name = systems::behavior::action_selection_system::get_action_name(npc->getIdentity()->current_action.value());
             
-            if (npc->identity->target_entity) {
+            if (npc->getIdentity()->target_entity) {
                 spdlog::info("  Current action: {} targeting entity {}", 
                             action_name, 
-                            npc->identity->target_entity.value()->id);
+                            npc->getIdentity()->target_entity.value()->id);
             }
-            else if (npc->identity->target_object) {
+            else if (npc->getIdentity()->target_object) {
                 spdlog::info("  Current action: {} targeting object {}", 
                             action_name, 
-                            npc->identity->target_object.value()->entity->id);
+                            npc->getIdentity()->target_object.value()->entity->id);
             }
             else {
                 spdlog::info("  Current action: {}", action_name);
@@ -0,0 +1,138 @@
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <algorithm>
+#include <type_traits>
+#include <cpioo/managed_entity.hpp>
+#include <spdlog/spdlog.h>
+
+#include <history_game/datamodel/pool/ref_count.h>
+
+namespace history_game::bin {
+
+// Object managed by the benchmarked storages
+struct Payload {
+    const uint64_t value;
+
+    explicit Payload(uint64_t payload_value) : value(payload_value) {}
+};
+
+template<typename RefCount>
+using PayloadStorage = cpioo::managed_entity::storage<Payload, 10, RefCount>;
+
+template<typename RefCount>
+constexpr bool IS_DEFERRED = std::is_same_v<RefCount, datamodel::pool::DeferredRefCount>;
+
+// Copies between two flushes of deferred counts, standing for a tick
+constexpr size_t COPIES_PER_FLUSH = 65536;
+
+// Copy and drop references to the objects, as a system reading the world does
+template<typename RefCount>
+uint64_t copyReferences(
+    const std::vector<typename PayloadStorage<RefCount>::ref_type>& objects,
+    size_t iterations
+) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        typename PayloadStorage<RefCount>::ref_type copy(objects[i % objects.size()]);
+        sum += copy->value;
+        if constexpr (IS_DEFERRED<RefCount>) {
+            if ((i + 1) % COPIES_PER_FLUSH == 0) {
+                datamodel::pool::ref_count_system::flushChanges();
+            }
+        }
+    }
+    return sum;
+}
+
+template<typename RefCount>
+std::vector<typename PayloadStorage<RefCount>::ref_type> createObjects(size_t count) {
+    std::vector<typename PayloadStorage<RefCount>::ref_type> objects;
+    objects.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        objects.push_back(PayloadStorage<RefCount>::make_entity(i));
+    }
+    return objects;
+}
+
+// Nanoseconds per copy when every thread copies references to objects it created
+template<typename RefCount>
+double benchmarkOwnObjects(size_t threads, size_t objects, size_t iterations) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([objects, iterations] {
+            auto own = createObjects<RefCount>(objects);
+            volatile uint64_t sink = copyReferences<RefCount>(own, iterations);
+            (void)sink;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    // The objects dropped as the threads exit are freed by the flushes
+    if constexpr (IS_DEFERRED<RefCount>) {
+        datamodel::pool::ref_count_system::settleChanges();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (threads * iterations);
+}
+
+// Nanoseconds per copy when every thread copies references to the same objects
+template<typename RefCount>
+double benchmarkSharedObjects(size_t threads, size_t objects, size_t iterations) {
+    auto shared = createObjects<RefCount>(objects);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&shared, iterations] {
+            volatile uint64_t sink = copyReferences<RefCount>(shared, iterations);
+            (void)sink;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if constexpr (IS_DEFERRED<RefCount>) {
+        datamodel::pool::ref_count_system::flushChanges();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double result = std::chrono::duration<double, std::nano>(elapsed).count() / (threads * iterations);
+
+    if constexpr (IS_DEFERRED<RefCount>) {
+        shared.clear();
+        datamodel::pool::ref_count_system::settleChanges();
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) :
+        std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000000;
+    const size_t OBJECTS = 1024;
+
+    spdlog::info("Reference counting benchmark: {} threads, {} copies each", threads, iterations);
+
+    // Plain counts are only safe while each thread keeps to its own objects;
+    // deferred counts include their flushes, one every COPIES_PER_FLUSH copies
+    spdlog::info("Own objects:    plain {:.2f} ns, atomic {:.2f} ns, deferred {:.2f} ns",
+                 benchmarkOwnObjects<uint32_t>(threads, OBJECTS, iterations),
+                 benchmarkOwnObjects<datamodel::pool::AtomicRefCount>(threads, OBJECTS, iterations),
+                 benchmarkOwnObjects<datamodel::pool::DeferredRefCount>(threads, OBJECTS, iterations));
+    spdlog::info("Shared objects: atomic {:.2f} ns, deferred {:.2f} ns",
+                 benchmarkSharedObjects<datamodel::pool::AtomicRefCount>(threads, OBJECTS, iterations),
+                 benchmarkSharedObjects<datamodel::pool::DeferredRefCount>(threads, OBJECTS, iterations));
+
+    return 0;
+}
+
+} // namespace history_game::bin
+
+int main(int argc, char** argv) {
+    return history_game::bin::main(argc, argv);
+}
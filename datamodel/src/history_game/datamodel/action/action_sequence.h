@@ -5,6 +5,7 @@
 #include <string>
 #include <cstdint>
 #include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
 #include <history_game/datamodel/memory/memory_entry.h>
 
 namespace history_game::datamodel::action {
@@ -14,10 +15,10 @@ namespace history_game::datamodel::action {
  */
 struct ActionStep {
   // The memory entry for this action step
-  const memory::MemoryEntry::ref_type memory;
+  memory::MemoryEntry::ref_type memory;
   
   // Delay in ticks after the previous step
-  const uint32_t delay_after_previous;
+  uint32_t delay_after_previous;
   
   // Constructor
   ActionStep(
@@ -30,12 +31,12 @@ struct ActionStep {
 /**
  * Represents a sequence of related actions that form a meaningful behavior
  */
-struct ActionSequence {
+struct ActionSequence : pool::Counted<ActionSequence> {
   // Unique identifier for this sequence
-  const std::string id;
+  std::string id;
   
   // The ordered list of action steps
-  const std::vector<ActionStep> steps;
+  std::vector<ActionStep> steps;
   
   // Constructor
   ActionSequence(
@@ -45,7 +46,7 @@ struct ActionSequence {
       steps(std::move(action_steps)) {}
       
   // Define storage type
-  using storage = cpioo::managed_entity::storage<ActionSequence, 10, uint32_t>;
+  using storage = pool::ManagedStorage<ActionSequence>;
   using ref_type = storage::ref_type;
 };
 
@@ -5,6 +5,8 @@
 #include <string_view>
 #include <variant>
 #include <concepts>
+#include <cstddef>
+#include <utility>
 
 namespace history_game::datamodel::action {
 
@@ -79,6 +81,23 @@ using ActionType = std::variant<
   action_type::Follow
 >;
 
+namespace action_type_system {
+
+  template<std::size_t... Indices>
+  inline ActionType fromIndex(std::size_t index, std::index_sequence<Indices...>) {
+    static const ActionType actions[] = { ActionType(std::in_place_index<Indices>)... };
+    return actions[index];
+  }
+
+  /**
+   * The action type with the given index in ActionType
+   */
+  inline ActionType fromIndex(std::size_t index) {
+    return fromIndex(index, std::make_index_sequence<std::variant_size_v<ActionType>>{});
+  }
+
+} // namespace action_type_system
+
 } // namespace history_game::datamodel::action
 
 #endif // HISTORY_GAME_DATAMODEL_ACTION_ACTION_TYPE_H
\ No newline at end of file
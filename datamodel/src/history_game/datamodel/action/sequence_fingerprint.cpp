@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/datamodel/action/sequence_fingerprint.cpp
+#include <history_game/datamodel/action/sequence_fingerprint.h>
+
+namespace history_game::datamodel::action {
+// Empty implementation file
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#ifndef HISTORY_GAME_DATAMODEL_ACTION_SEQUENCE_FINGERPRINT_H
+#define HISTORY_GAME_DATAMODEL_ACTION_SEQUENCE_FINGERPRINT_H
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <history_game/datamodel/action/action_sequence.h>
+
+namespace history_game::datamodel::action {
+
+/**
+ * Compact description of the shape of an action sequence
+ * Two sequences with the same actions on the same kinds of targets, at
+ * roughly the same pace, have the same fingerprint.
+ */
+struct SequenceFingerprint {
+  // Number of MinHash values, split in bands of rows for the similarity index
+  static constexpr size_t NUM_HASHES = 16;
+  static constexpr size_t NUM_BANDS = 4;
+  static constexpr size_t ROWS_PER_BAND = NUM_HASHES / NUM_BANDS;
+
+  // Rolling hash of the whole sequence, for exact matches
+  uint64_t exact;
+
+  // MinHash of the sequence's step pairs, for approximate matches
+  std::array<uint32_t, NUM_HASHES> minhash;
+};
+
+namespace sequence_fingerprint_system {
+
+  /**
+   * Mix a 64 bit value (splitmix64 finalizer)
+   */
+  inline uint64_t mix(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+  }
+
+  /**
+   * Kind of target of a memory entry: none, entity or object
+   */
+  inline uint64_t getTargetKind(const memory::MemoryEntry::ref_type& entry) {
+    return static_cast<uint64_t>(entry->target_kind);
+  }
+
+  /**
+   * Quantize a delay on a logarithmic scale (0, 1, 2-3, 4-7, ...)
+   */
+  inline uint64_t quantizeDelay(uint32_t delay) {
+    uint64_t bucket = 0;
+    while (delay > 0) {
+      delay >>= 1;
+      bucket++;
+    }
+    return bucket;
+  }
+
+  /**
+   * Token describing one step of a sequence
+   */
+  inline uint64_t stepToken(const ActionStep& step) {
+    return (static_cast<uint64_t>(step.memory->actionIndex()) << 16) |
+           (getTargetKind(step.memory) << 8) |
+           quantizeDelay(step.delay_after_previous);
+  }
+
+  /**
+   * Compute the fingerprint of a sequence
+   */
+  inline SequenceFingerprint computeFingerprint(const ActionSequence::ref_type& sequence) {
+    SequenceFingerprint fingerprint;
+
+    // Polynomial rolling hash over the step tokens
+    constexpr uint64_t base = 1099511628211ull;
+    fingerprint.exact = 14695981039346656037ull;
+
+    std::vector<uint64_t> tokens;
+    tokens.reserve(sequence->steps.size());
+    for (const auto& step : sequence->steps) {
+      uint64_t token = stepToken(step);
+      tokens.push_back(token);
+      fingerprint.exact = fingerprint.exact * base + mix(token);
+    }
+
+    // MinHash over consecutive step pairs (single steps for one-step sequences)
+    fingerprint.minhash.fill(std::numeric_limits<uint32_t>::max());
+    auto add_shingle = [&fingerprint](uint64_t shingle) {
+      for (size_t i = 0; i < SequenceFingerprint::NUM_HASHES; ++i) {
+        uint32_t value = static_cast<uint32_t>(mix(shingle ^ mix(i + 1)));
+        if (value < fingerprint.minhash[i]) {
+          fingerprint.minhash[i] = value;
+        }
+      }
+    };
+
+    if (tokens.size() == 1) {
+      add_shingle(mix(tokens[0]));
+    }
+    for (size_t i = 1; i < tokens.size(); ++i) {
+      add_shingle(mix(tokens[i - 1]) ^ (mix(tokens[i]) >> 1));
+    }
+
+    return fingerprint;
+  }
+
+  /**
+   * Estimate the Jaccard similarity of two sequences from their fingerprints
+   */
+  inline float estimateSimilarity(const SequenceFingerprint& a, const SequenceFingerprint& b) {
+    if (a.exact == b.exact) {
+      return 1.0f;
+    }
+
+    size_t matching = 0;
+    for (size_t i = 0; i < SequenceFingerprint::NUM_HASHES; ++i) {
+      if (a.minhash[i] == b.minhash[i]) {
+        matching++;
+      }
+    }
+    return static_cast<float>(matching) / static_cast<float>(SequenceFingerprint::NUM_HASHES);
+  }
+
+  /**
+   * Key of one band of the MinHash values
+   * Sequences that share any band key are candidates for being similar
+   */
+  inline uint64_t bandKey(const SequenceFingerprint& fingerprint, size_t band) {
+    uint64_t key = mix(band);
+    for (size_t row = 0; row < SequenceFingerprint::ROWS_PER_BAND; ++row) {
+      key = mix(key ^ fingerprint.minhash[band * SequenceFingerprint::ROWS_PER_BAND + row]);
+    }
+    return key;
+  }
+
+} // namespace sequence_fingerprint_system
+
+} // namespace history_game::datamodel::action
+
+#endif // HISTORY_GAME_DATAMODEL_ACTION_SEQUENCE_FINGERPRINT_H
@@ -5,6 +5,8 @@
 #include <string>
 #include <history_game/datamodel/npc/npc.h>
 #include <history_game/datamodel/memory/memory_entry.h>
+#include <history_game/datamodel/relationship/relationship.h>
+#include <history_game/datamodel/world/world.h>
 
 namespace history_game::datamodel::drives {
 
@@ -13,22 +15,32 @@ namespace history_game::datamodel::drives {
  */
 struct ActionContext {
   // The NPC experiencing/evaluating the action
-  const npc::NPC::ref_type observer;
+  npc::NPC::ref_type observer;
   
   // The memory entry being evaluated
-  const memory::MemoryEntry::ref_type memory;
+  memory::MemoryEntry::ref_type memory;
+  
+  // The world the memory's actor and target are looked up in
+  const world::World& world;
   
   // Current simulation time
-  const uint64_t current_time;
+  uint64_t current_time;
+  
+  // How the observer's relationships decay
+  relationship::RelationshipDecay decay;
   
   // Constructor
   ActionContext(
     const npc::NPC::ref_type& npc,
     const memory::MemoryEntry::ref_type& memory_entry,
-    uint64_t time
+    const world::World& current_world,
+    uint64_t time,
+    const relationship::RelationshipDecay& relationship_decay
   ) : observer(npc),
       memory(memory_entry),
-      current_time(time) {}
+      world(current_world),
+      current_time(time),
+      decay(relationship_decay) {}
 };
 
 } // namespace history_game::datamodel::drives
@@ -3,7 +3,10 @@
 
 #include <string>
 #include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
 #include <history_game/datamodel/world/position.h>
+#include <history_game/datamodel/entity/entity_handle.h>
+#include <history_game/datamodel/entity/entity_registry.h>
 
 namespace history_game::datamodel::entity {
 
@@ -11,16 +14,24 @@ namespace history_game::datamodel::entity {
  * Base entity struct for all simulation objects
  * Simple data container with const fields
  */
-struct Entity {
-  const std::string id;
-  const world::Position position;
+struct Entity : pool::Counted<Entity> {
+  // Display name (not guaranteed to be unique)
+  std::string id;
+  world::Position position;
   
-  // Constructor for initialization
-  Entity(std::string entity_id, world::Position entity_position) 
-    : id(std::move(entity_id)), position(entity_position) {}
+  // Identity shared by every version of the entity
+  EntityHandle handle;
+  
+  // Constructor for a new entity, with a handle issued by the simulation's registry
+  Entity(std::string entity_id, world::Position entity_position, EntityRegistry& registry)
+    : Entity(std::move(entity_id), entity_position, registry.issue()) {}
+  
+  // Constructor for a new version of an entity, or one with an issued handle
+  Entity(std::string entity_id, world::Position entity_position, EntityHandle entity_handle)
+    : id(std::move(entity_id)), position(entity_position), handle(entity_handle) {}
   
   // Define storage type
-  using storage = cpioo::managed_entity::storage<Entity, 10, uint32_t>;
+  using storage = pool::ManagedStorage<Entity>;
   using ref_type = storage::ref_type;
 };
 
@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/datamodel/entity/entity_handle.cpp
+#include <history_game/datamodel/entity/entity_handle.h>
+
+namespace history_game::datamodel::entity {
+// Empty implementation file
+}
\ No newline at end of file
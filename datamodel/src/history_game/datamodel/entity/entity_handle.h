@@ -0,0 +1,48 @@
+#ifndef HISTORY_GAME_DATAMODEL_ENTITY_ENTITY_HANDLE_H
+#define HISTORY_GAME_DATAMODEL_ENTITY_ENTITY_HANDLE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace history_game::datamodel::entity {
+
+/**
+ * Stable identity of an entity across all of its versions
+ * The low 24 bits are the entity's slot in the registry that issued the
+ * handle, and the high 8 bits count how many times that slot was reused, so a
+ * handle to a released entity never matches whatever took its slot. Slot 0 is
+ * never issued, so the default handle refers to nothing.
+ */
+struct EntityHandle {
+  static constexpr uint32_t INDEX_BITS = 24;
+  static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+  static constexpr uint32_t MAX_GENERATION = 0xffu;
+
+  uint32_t value = 0;
+
+  // Handle that refers to nothing
+  constexpr EntityHandle() = default;
+
+  // Handle for a registry slot
+  constexpr EntityHandle(uint32_t slot, uint32_t generation)
+    : value((slot & INDEX_MASK) | ((generation & MAX_GENERATION) << INDEX_BITS)) {}
+
+  constexpr uint32_t index() const { return value & INDEX_MASK; }
+  constexpr uint32_t generation() const { return value >> INDEX_BITS; }
+  constexpr bool isValid() const { return value != 0; }
+
+  constexpr bool operator==(const EntityHandle& other) const { return value == other.value; }
+  constexpr bool operator!=(const EntityHandle& other) const { return value != other.value; }
+};
+
+} // namespace history_game::datamodel::entity
+
+template<>
+struct std::hash<history_game::datamodel::entity::EntityHandle> {
+  size_t operator()(const history_game::datamodel::entity::EntityHandle& handle) const noexcept {
+    return std::hash<uint32_t>{}(handle.value);
+  }
+};
+
+#endif // HISTORY_GAME_DATAMODEL_ENTITY_ENTITY_HANDLE_H
@@ -0,0 +1,98 @@
+#ifndef HISTORY_GAME_DATAMODEL_ENTITY_ENTITY_REGISTRY_H
+#define HISTORY_GAME_DATAMODEL_ENTITY_ENTITY_REGISTRY_H
+
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <history_game/datamodel/entity/entity_handle.h>
+
+namespace history_game::datamodel::entity {
+
+/**
+ * Issues entity handles
+ * Released slots are reused with the next generation, so the handles of
+ * released entities stay distinct from the ones issued after them. Each
+ * simulation owns one and releases the handles of entities leaving its world.
+ */
+class EntityRegistry {
+public:
+  EntityRegistry() : generations(1, 0), live(1, false) {}
+
+  EntityRegistry(const EntityRegistry&) = delete;
+  EntityRegistry& operator=(const EntityRegistry&) = delete;
+
+  /**
+   * Issue a handle for a new entity
+   */
+  EntityHandle issue() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint32_t slot;
+    if (!free_slots.empty()) {
+      slot = free_slots.back();
+      free_slots.pop_back();
+    } else {
+      if (generations.size() > EntityHandle::INDEX_MASK) {
+        throw std::length_error("EntityRegistry: out of entity handles");
+      }
+      slot = static_cast<uint32_t>(generations.size());
+      generations.push_back(0);
+      live.push_back(false);
+    }
+
+    live[slot] = true;
+    live_count++;
+    return EntityHandle(slot, generations[slot]);
+  }
+
+  /**
+   * Release the handle of an entity that left the world
+   * Its slot is reused with the next generation (wrapping after 256 reuses).
+   */
+  void release(EntityHandle handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!isLiveLocked(handle)) {
+      return;
+    }
+
+    uint32_t slot = handle.index();
+    live[slot] = false;
+    live_count--;
+    generations[slot] = (generations[slot] + 1) & EntityHandle::MAX_GENERATION;
+    free_slots.push_back(slot);
+  }
+
+  /**
+   * Check if a handle refers to an entity that was not released
+   */
+  bool isLive(EntityHandle handle) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return isLiveLocked(handle);
+  }
+
+  /**
+   * Number of handles issued and not released
+   */
+  size_t liveCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return live_count;
+  }
+
+private:
+  bool isLiveLocked(EntityHandle handle) const {
+    uint32_t slot = handle.index();
+    return slot < generations.size() && live[slot] && generations[slot] == handle.generation();
+  }
+
+  std::vector<uint32_t> generations;
+  std::vector<bool> live;
+  std::vector<uint32_t> free_slots;
+  size_t live_count = 0;
+  mutable std::mutex mutex;
+};
+
+} // namespace history_game::datamodel::entity
+
+#endif // HISTORY_GAME_DATAMODEL_ENTITY_ENTITY_REGISTRY_H
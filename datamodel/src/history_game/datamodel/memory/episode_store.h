@@ -0,0 +1,587 @@
+#ifndef HISTORY_GAME_DATAMODEL_MEMORY_EPISODE_STORE_H
+#define HISTORY_GAME_DATAMODEL_MEMORY_EPISODE_STORE_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <iterator>
+#include <algorithm>
+#include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
+#include <history_game/datamodel/memory/memory_entry.h>
+#include <history_game/datamodel/memory/memory_episode.h>
+#include <history_game/datamodel/action/action_sequence.h>
+#include <history_game/datamodel/action/sequence_fingerprint.h>
+
+namespace history_game::datamodel::memory {
+
+/**
+ * Episodes whose sequence signatures fall into the same hash bucket
+ */
+struct EpisodeBucket : pool::Counted<EpisodeBucket> {
+  // Signature of each episode's action sequence
+  std::vector<uint64_t> signatures;
+
+  // The episodes, in the same order as their signatures
+  std::vector<MemoryEpisode::ref_type> episodes;
+
+  // Constructor
+  EpisodeBucket(
+    std::vector<uint64_t> episode_signatures,
+    std::vector<MemoryEpisode::ref_type> bucket_episodes
+  ) : signatures(std::move(episode_signatures)),
+      episodes(std::move(bucket_episodes)) {}
+
+  // Define storage type
+  using storage = pool::ManagedStorage<EpisodeBucket>;
+  using ref_type = storage::ref_type;
+};
+
+/**
+ * Consecutive buckets of an episode table
+ */
+struct EpisodeBucketChunk : pool::Counted<EpisodeBucketChunk> {
+  // The buckets (empty buckets hold nothing)
+  std::vector<std::optional<EpisodeBucket::ref_type>> buckets;
+
+  // Constructor
+  explicit EpisodeBucketChunk(
+    std::vector<std::optional<EpisodeBucket::ref_type>> chunk_buckets
+  ) : buckets(std::move(chunk_buckets)) {}
+
+  // Define storage type
+  using storage = pool::ManagedStorage<EpisodeBucketChunk>;
+  using ref_type = storage::ref_type;
+};
+
+/**
+ * Hash table of episodes keyed by sequence signature
+ * The buckets are grouped in chunks of BUCKETS_PER_CHUNK. Replacing an episode
+ * rebuilds only its bucket and that bucket's chunk; all other chunks are shared
+ * with the previous version of the table.
+ */
+struct EpisodeTable : pool::Counted<EpisodeTable> {
+  static constexpr size_t BUCKETS_PER_CHUNK = 16;
+
+  // Chunks of buckets; bucket b is in chunk b / BUCKETS_PER_CHUNK
+  std::vector<EpisodeBucketChunk::ref_type> chunks;
+
+  // Number of buckets, signatures are mapped to buckets modulo this
+  size_t bucket_count;
+
+  // Total number of episodes in the table
+  size_t count;
+
+  // Constructor
+  EpisodeTable(
+    std::vector<EpisodeBucketChunk::ref_type> table_chunks,
+    size_t table_bucket_count,
+    size_t episode_count
+  ) : chunks(std::move(table_chunks)),
+      bucket_count(table_bucket_count),
+      count(episode_count) {}
+
+  const std::optional<EpisodeBucket::ref_type>& bucket(size_t index) const {
+    return chunks[index / BUCKETS_PER_CHUNK]->buckets[index % BUCKETS_PER_CHUNK];
+  }
+
+  // Define storage type
+  using storage = pool::ManagedStorage<EpisodeTable>;
+  using ref_type = storage::ref_type;
+};
+
+/**
+ * An NPC's episodic memory
+ * Holds one live episode per distinct action sequence, indexed both by exact
+ * sequence and by MinHash bands of the sequence fingerprint for approximate
+ * lookups. Copying the store only copies references to its tables.
+ */
+struct EpisodeStore {
+  // The table holding the episodes, keyed by sequence signature (none while the store is empty)
+  std::optional<EpisodeTable::ref_type> table;
+
+  // One table per fingerprint band, keyed by band key (empty while the store is empty)
+  std::vector<EpisodeTable::ref_type> band_tables;
+
+  // Constructor for an empty store
+  EpisodeStore() : table(std::nullopt) {}
+
+  // Constructor from a list of episodes (later episodes replace earlier ones with the same sequence)
+  EpisodeStore(const std::vector<MemoryEpisode::ref_type>& episodes);
+
+  // Constructor from existing tables (shares their buckets)
+  EpisodeStore(
+    const EpisodeTable::ref_type& episode_table,
+    std::vector<EpisodeTable::ref_type> episode_bands
+  ) : table(episode_table),
+      band_tables(std::move(episode_bands)) {}
+
+  size_t size() const { return table ? table.value()->count : 0; }
+  bool empty() const { return size() == 0; }
+
+  /**
+   * Forward iterator over all episodes, bucket by bucket
+   */
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = MemoryEpisode::ref_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const MemoryEpisode::ref_type*;
+    using reference = const MemoryEpisode::ref_type&;
+
+    const_iterator() : table(nullptr), bucket(0), index(0) {}
+    const_iterator(const EpisodeTable* t, size_t b) : table(t), bucket(b), index(0) {
+      skipEmpty();
+    }
+
+    reference operator*() const { return table->bucket(bucket).value()->episodes[index]; }
+    pointer operator->() const { return &**this; }
+
+    const_iterator& operator++() {
+      ++index;
+      skipEmpty();
+      return *this;
+    }
+    const_iterator operator++(int) { auto copy = *this; ++*this; return copy; }
+
+    bool operator==(const const_iterator& other) const {
+      return bucket == other.bucket && index == other.index;
+    }
+    bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+  private:
+    // Move to the next existing episode, or to the end
+    void skipEmpty() {
+      if (!table) {
+        return;
+      }
+      while (bucket < table->bucket_count &&
+             (!table->bucket(bucket) || index >= table->bucket(bucket).value()->episodes.size())) {
+        ++bucket;
+        index = 0;
+      }
+    }
+
+    const EpisodeTable* table;
+    size_t bucket;
+    size_t index;
+  };
+
+  const_iterator begin() const {
+    return table ? const_iterator(&*table.value(), 0) : const_iterator();
+  }
+  const_iterator end() const {
+    return table ? const_iterator(&*table.value(), table.value()->bucket_count) : const_iterator();
+  }
+};
+
+namespace episode_store_system {
+
+  // Minimum number of buckets of a table
+  constexpr size_t MIN_BUCKETS = 8;
+
+  // Average episodes per bucket before the table grows
+  constexpr size_t MAX_LOAD = 2;
+
+  /**
+   * Get the handle value of the target of a memory entry, or 0 if it has none
+   */
+  inline uint32_t getTargetKey(const MemoryEntry::ref_type& entry) {
+    if (const auto* target_entity = entry->targetEntity()) {
+      return target_entity->value;
+    }
+    if (const auto* target_object = entry->targetObject()) {
+      return target_object->value;
+    }
+    return 0;
+  }
+
+  /**
+   * Canonical signature of an action sequence
+   * Two sequences have the same signature when their steps perform the same
+   * actions on the same targets, regardless of timing.
+   */
+  inline uint64_t sequenceSignature(const action::ActionSequence::ref_type& sequence) {
+    // FNV-1a over (action, target) of each step
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t value) {
+      hash ^= value;
+      hash *= 1099511628211ull;
+    };
+
+    for (const auto& step : sequence->steps) {
+      mix(step.memory->actionIndex());
+      mix(getTargetKey(step.memory));
+    }
+    mix(sequence->steps.size());
+
+    return hash;
+  }
+
+  /**
+   * Check if two sequences are the same under sequenceSignature
+   * (used to confirm a signature match)
+   */
+  inline bool isSameSequence(
+    const action::ActionSequence::ref_type& a,
+    const action::ActionSequence::ref_type& b
+  ) {
+    if (a->steps.size() != b->steps.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < a->steps.size(); ++i) {
+      if (a->steps[i].memory->actionIndex() != b->steps[i].memory->actionIndex() ||
+          getTargetKey(a->steps[i].memory) != getTargetKey(b->steps[i].memory)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Find the episode of a sequence in a table, given the sequence's key in that table
+   */
+  inline std::optional<MemoryEpisode::ref_type> findInTable(
+    const EpisodeTable::ref_type& table,
+    uint64_t key,
+    const action::ActionSequence::ref_type& sequence
+  ) {
+    const auto& bucket = table->bucket(key % table->bucket_count);
+    if (!bucket) {
+      return std::nullopt;
+    }
+
+    const auto& entries = bucket.value();
+    for (size_t i = 0; i < entries->episodes.size(); ++i) {
+      if (entries->signatures[i] == key &&
+          isSameSequence(entries->episodes[i]->action_sequence, sequence)) {
+        return entries->episodes[i];
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  /**
+   * Find the episode recording the same sequence, if any
+   */
+  inline std::optional<MemoryEpisode::ref_type> find(
+    const EpisodeStore& store,
+    const action::ActionSequence::ref_type& sequence
+  ) {
+    if (store.empty()) {
+      return std::nullopt;
+    }
+
+    return findInTable(store.table.value(), sequenceSignature(sequence), sequence);
+  }
+
+  /**
+   * Find the episode most similar to a sequence, if any is similar enough
+   *
+   * An episode of the same sequence is returned right away. Otherwise only the
+   * episodes sharing a fingerprint band with the sequence are compared, by their
+   * estimated similarity, so the cost does not grow with the size of the store.
+   *
+   * @param fingerprint The fingerprint of the sequence
+   */
+  inline std::optional<MemoryEpisode::ref_type> findSimilar(
+    const EpisodeStore& store,
+    const action::ActionSequence::ref_type& sequence,
+    const action::SequenceFingerprint& fingerprint,
+    float similarity_threshold
+  ) {
+    auto exact = find(store, sequence);
+    if (exact || store.empty() || store.band_tables.empty()) {
+      return exact;
+    }
+
+    std::optional<MemoryEpisode::ref_type> best;
+    float best_similarity = similarity_threshold;
+
+    for (size_t band = 0; band < store.band_tables.size(); ++band) {
+      const auto& table = store.band_tables[band];
+      uint64_t key = action::sequence_fingerprint_system::bandKey(fingerprint, band);
+      const auto& bucket = table->bucket(key % table->bucket_count);
+      if (!bucket) {
+        continue;
+      }
+
+      const auto& entries = bucket.value();
+      for (size_t i = 0; i < entries->episodes.size(); ++i) {
+        if (entries->signatures[i] != key) {
+          continue;
+        }
+
+        const auto& candidate = entries->episodes[i];
+        float similarity = action::sequence_fingerprint_system::estimateSimilarity(
+          fingerprint,
+          candidate->fingerprint
+        );
+        if (similarity >= best_similarity) {
+          best.emplace(candidate);
+          best_similarity = similarity;
+        }
+      }
+    }
+
+    return best;
+  }
+
+  /**
+   * Find the episode most similar to a sequence, if any is similar enough
+   */
+  inline std::optional<MemoryEpisode::ref_type> findSimilar(
+    const EpisodeStore& store,
+    const action::ActionSequence::ref_type& sequence,
+    float similarity_threshold
+  ) {
+    return findSimilar(
+      store,
+      sequence,
+      action::sequence_fingerprint_system::computeFingerprint(sequence),
+      similarity_threshold
+    );
+  }
+
+  /**
+   * Build a table from scratch with the given number of buckets
+   */
+  inline EpisodeTable::ref_type buildTable(
+    const std::vector<uint64_t>& signatures,
+    const std::vector<MemoryEpisode::ref_type>& episodes,
+    size_t bucket_count
+  ) {
+    std::vector<std::vector<uint64_t>> bucket_signatures(bucket_count);
+    std::vector<std::vector<MemoryEpisode::ref_type>> bucket_episodes(bucket_count);
+
+    size_t count = 0;
+    for (size_t i = 0; i < episodes.size(); ++i) {
+      size_t b = signatures[i] % bucket_count;
+
+      // A later episode replaces an earlier one of the same sequence
+      bool replaced = false;
+      for (size_t j = 0; j < bucket_episodes[b].size(); ++j) {
+        if (bucket_signatures[b][j] == signatures[i] &&
+            isSameSequence(bucket_episodes[b][j]->action_sequence, episodes[i]->action_sequence)) {
+          std::vector<MemoryEpisode::ref_type> updated;
+          updated.reserve(bucket_episodes[b].size());
+          for (size_t k = 0; k < bucket_episodes[b].size(); ++k) {
+            updated.push_back(k == j ? episodes[i] : bucket_episodes[b][k]);
+          }
+          bucket_episodes[b] = std::move(updated);
+          replaced = true;
+          break;
+        }
+      }
+
+      if (!replaced) {
+        bucket_signatures[b].push_back(signatures[i]);
+        bucket_episodes[b].push_back(episodes[i]);
+        count++;
+      }
+    }
+
+    std::vector<EpisodeBucketChunk::ref_type> chunks;
+    chunks.reserve((bucket_count + EpisodeTable::BUCKETS_PER_CHUNK - 1) / EpisodeTable::BUCKETS_PER_CHUNK);
+    for (size_t first = 0; first < bucket_count; first += EpisodeTable::BUCKETS_PER_CHUNK) {
+      size_t last = std::min(first + EpisodeTable::BUCKETS_PER_CHUNK, bucket_count);
+      std::vector<std::optional<EpisodeBucket::ref_type>> buckets(last - first);
+      for (size_t b = first; b < last; ++b) {
+        if (!bucket_episodes[b].empty()) {
+          EpisodeBucket bucket(std::move(bucket_signatures[b]), std::move(bucket_episodes[b]));
+          buckets[b - first].emplace(EpisodeBucket::storage::make_entity(std::move(bucket)));
+        }
+      }
+      chunks.push_back(EpisodeBucketChunk::storage::make_entity(EpisodeBucketChunk(std::move(buckets))));
+    }
+
+    EpisodeTable table(std::move(chunks), bucket_count, count);
+    return EpisodeTable::storage::make_entity(std::move(table));
+  }
+
+  /**
+   * Number of buckets needed for a number of episodes
+   */
+  inline size_t bucketCountFor(size_t count) {
+    size_t buckets = MIN_BUCKETS;
+    while (count > buckets * MAX_LOAD) {
+      buckets *= 2;
+    }
+    return buckets;
+  }
+
+  /**
+   * Insert an episode into a table under the given key, replacing the
+   * episode of the same sequence if there is one
+   *
+   * Only the affected bucket and its chunk are rebuilt; the other chunks are
+   * shared with the original table, which remains valid. The table doubles its
+   * bucket count when it grows past its load factor.
+   */
+  inline EpisodeTable::ref_type insertIntoTable(
+    const std::optional<EpisodeTable::ref_type>& original,
+    uint64_t key,
+    const MemoryEpisode::ref_type& episode
+  ) {
+    if (!original) {
+      return buildTable({key}, {episode}, MIN_BUCKETS);
+    }
+
+    const auto& table = original.value();
+    size_t b = key % table->bucket_count;
+    const auto& bucket = table->bucket(b);
+
+    std::vector<uint64_t> signatures;
+    std::vector<MemoryEpisode::ref_type> episodes;
+    bool replaced = false;
+
+    if (bucket) {
+      const auto& entries = bucket.value();
+      signatures.reserve(entries->episodes.size() + 1);
+      episodes.reserve(entries->episodes.size() + 1);
+      for (size_t i = 0; i < entries->episodes.size(); ++i) {
+        signatures.push_back(entries->signatures[i]);
+        if (!replaced && entries->signatures[i] == key &&
+            isSameSequence(entries->episodes[i]->action_sequence, episode->action_sequence)) {
+          episodes.push_back(episode);
+          replaced = true;
+        } else {
+          episodes.push_back(entries->episodes[i]);
+        }
+      }
+    }
+
+    if (!replaced) {
+      // Grow the table instead of overloading its buckets
+      if (table->count + 1 > table->bucket_count * MAX_LOAD) {
+        std::vector<uint64_t> all_signatures;
+        std::vector<MemoryEpisode::ref_type> all_episodes;
+        all_signatures.reserve(table->count + 1);
+        all_episodes.reserve(table->count + 1);
+        for (const auto& chunk : table->chunks) {
+          for (const auto& existing : chunk->buckets) {
+            if (existing) {
+              for (size_t i = 0; i < existing.value()->episodes.size(); ++i) {
+                all_signatures.push_back(existing.value()->signatures[i]);
+                all_episodes.push_back(existing.value()->episodes[i]);
+              }
+            }
+          }
+        }
+        all_signatures.push_back(key);
+        all_episodes.push_back(episode);
+        return buildTable(all_signatures, all_episodes, table->bucket_count * 2);
+      }
+
+      signatures.push_back(key);
+      episodes.push_back(episode);
+    }
+
+    // Copy the chunk of the bucket that changed and share every other chunk
+    size_t c = b / EpisodeTable::BUCKETS_PER_CHUNK;
+    const auto& chunk = table->chunks[c];
+    std::vector<std::optional<EpisodeBucket::ref_type>> buckets;
+    buckets.reserve(chunk->buckets.size());
+    for (size_t i = 0; i < chunk->buckets.size(); ++i) {
+      if (i == b % EpisodeTable::BUCKETS_PER_CHUNK) {
+        EpisodeBucket updated(std::move(signatures), std::move(episodes));
+        buckets.emplace_back(EpisodeBucket::storage::make_entity(std::move(updated)));
+      } else {
+        buckets.push_back(chunk->buckets[i]);
+      }
+    }
+
+    std::vector<EpisodeBucketChunk::ref_type> chunks;
+    chunks.reserve(table->chunks.size());
+    for (size_t i = 0; i < table->chunks.size(); ++i) {
+      if (i == c) {
+        chunks.push_back(EpisodeBucketChunk::storage::make_entity(EpisodeBucketChunk(std::move(buckets))));
+      } else {
+        chunks.push_back(table->chunks[i]);
+      }
+    }
+
+    EpisodeTable updated_table(std::move(chunks), table->bucket_count, replaced ? table->count : table->count + 1);
+    return EpisodeTable::storage::make_entity(std::move(updated_table));
+  }
+
+  /**
+   * Insert an episode, replacing the episode of the same sequence if there is one
+   * The original store remains valid and shares all untouched buckets.
+   */
+  inline EpisodeStore insert(
+    const EpisodeStore& store,
+    const MemoryEpisode::ref_type& episode
+  ) {
+    auto table = insertIntoTable(store.table, sequenceSignature(episode->action_sequence), episode);
+
+    const auto& fingerprint = episode->fingerprint;
+    std::vector<EpisodeTable::ref_type> bands;
+    bands.reserve(action::SequenceFingerprint::NUM_BANDS);
+    for (size_t band = 0; band < action::SequenceFingerprint::NUM_BANDS; ++band) {
+      std::optional<EpisodeTable::ref_type> band_table;
+      if (band < store.band_tables.size()) {
+        band_table.emplace(store.band_tables[band]);
+      }
+      bands.push_back(insertIntoTable(
+        band_table,
+        action::sequence_fingerprint_system::bandKey(fingerprint, band),
+        episode
+      ));
+    }
+
+    return EpisodeStore(table, std::move(bands));
+  }
+
+  /**
+   * Build the band tables of a list of episodes
+   */
+  inline std::vector<EpisodeTable::ref_type> buildBandTables(
+    const std::vector<MemoryEpisode::ref_type>& episodes
+  ) {
+    std::vector<std::vector<uint64_t>> band_keys(action::SequenceFingerprint::NUM_BANDS);
+    for (const auto& episode : episodes) {
+      for (size_t band = 0; band < action::SequenceFingerprint::NUM_BANDS; ++band) {
+        band_keys[band].push_back(action::sequence_fingerprint_system::bandKey(episode->fingerprint, band));
+      }
+    }
+
+    std::vector<EpisodeTable::ref_type> bands;
+    bands.reserve(action::SequenceFingerprint::NUM_BANDS);
+    for (size_t band = 0; band < action::SequenceFingerprint::NUM_BANDS; ++band) {
+      bands.push_back(buildTable(band_keys[band], episodes, bucketCountFor(episodes.size())));
+    }
+    return bands;
+  }
+
+  /**
+   * Build the signature table of a list of episodes
+   */
+  inline EpisodeTable::ref_type buildSignatureTable(
+    const std::vector<MemoryEpisode::ref_type>& episodes
+  ) {
+    std::vector<uint64_t> signatures;
+    signatures.reserve(episodes.size());
+    for (const auto& episode : episodes) {
+      signatures.push_back(sequenceSignature(episode->action_sequence));
+    }
+    return buildTable(signatures, episodes, bucketCountFor(episodes.size()));
+  }
+
+} // namespace episode_store_system
+
+inline EpisodeStore::EpisodeStore(const std::vector<MemoryEpisode::ref_type>& episodes)
+  : table(episodes.empty() ?
+      std::nullopt :
+      std::optional<EpisodeTable::ref_type>(episode_store_system::buildSignatureTable(episodes))),
+    band_tables(episodes.empty() ?
+      std::vector<EpisodeTable::ref_type>() :
+      episode_store_system::buildBandTables(episodes)) {}
+
+} // namespace history_game::datamodel::memory
+
+#endif // HISTORY_GAME_DATAMODEL_MEMORY_EPISODE_STORE_H
@@ -3,35 +3,66 @@
 
 #include <string>
 #include <cstdint>
-#include <optional>
+#include <algorithm>
 #include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
 #include <history_game/datamodel/entity/entity.h>
+#include <history_game/datamodel/entity/entity_handle.h>
 #include <history_game/datamodel/npc/npc_identity.h>
 #include <history_game/datamodel/action/action_type.h>
 #include <history_game/datamodel/object/object.h>
 
 namespace history_game::datamodel::memory {
 
+/**
+ * What the action of a memory entry was aimed at
+ */
+enum class TargetKind : uint8_t {
+  None = 0,
+  Entity = 1,
+  Object = 2
+};
+
 /**
  * Represents a single observed action or event
  * These are the basic building blocks of NPC memory in the speechless world
+ *
+ * Memory entries are the most numerous objects of the simulation, so they are
+ * packed into 16 bytes: the actor and the target are entity handles (the
+ * target tagged by target_kind), the action is stored as its index in
+ * ActionType, and the run of identical observations as a tick and a span.
+ * Handles name an entity across all of its versions; look them up in the
+ * world (World::findNPC, findObject, findEntity) for the current version.
  */
-struct MemoryEntry {
-  // When the memory was formed
-  const uint64_t timestamp;
-  
-  // Who performed the action
-  const npc::NPCIdentity::ref_type actor;
-  
-  // The action that was observed
-  const action::ActionType action;
-  
-  // Target of the action, if any (optional)
-  const std::optional<entity::Entity::ref_type> target_entity;
-  
-  // Object involved in the action, if any (optional)
-  const std::optional<object::WorldObject::ref_type> target_object;
-  
+struct MemoryEntry : pool::Counted<MemoryEntry> {
+  // Longest run of identical observations a single entry can cover
+  static constexpr uint64_t MAX_SPAN = UINT16_MAX;
+
+  // Last tick an entry can record (later ticks are recorded as this one)
+  static constexpr uint64_t MAX_TICK = UINT32_MAX;
+
+private:
+  // Handle of the NPC that performed the action
+  entity::EntityHandle actor;
+
+  // Handle of the target of the action, as told by target_kind
+  entity::EntityHandle target;
+
+public:
+  // When the memory was formed, in ticks since the start of the simulation
+  uint32_t timestamp;
+
+private:
+  // Ticks from timestamp to the last tick of the run
+  uint16_t span;
+
+  // Index of the action in ActionType
+  uint8_t action_index;
+
+public:
+  // What target refers to
+  TargetKind target_kind;
+
   // Constructor for action with entity target
   template<action::ActionTypeConcept T>
   MemoryEntry(
@@ -39,11 +70,12 @@ struct MemoryEntry {
     const npc::NPCIdentity::ref_type& actor_ref,
     T action_type,
     const entity::Entity::ref_type& entity_target
-  ) : timestamp(time),
-      actor(actor_ref),
-      action(action_type),
-      target_entity(entity_target),
-      target_object(std::nullopt) {}
+  ) : actor(actor_ref->entity->handle),
+      target(entity_target->handle),
+      timestamp(toTick(time)),
+      span(0),
+      action_index(static_cast<uint8_t>(action::ActionType(action_type).index())),
+      target_kind(TargetKind::Entity) {}
   
   // Constructor for action with object target
   template<action::ActionTypeConcept T>
@@ -52,11 +84,12 @@ struct MemoryEntry {
     const npc::NPCIdentity::ref_type& actor_ref,
     T action_type,
     const object::WorldObject::ref_type& object_target
-  ) : timestamp(time),
-      actor(actor_ref),
-      action(action_type),
-      target_entity(std::nullopt),
-      target_object(object_target) {}
+  ) : actor(actor_ref->entity->handle),
+      target(object_target->entity->handle),
+      timestamp(toTick(time)),
+      span(0),
+      action_index(static_cast<uint8_t>(action::ActionType(action_type).index())),
+      target_kind(TargetKind::Object) {}
   
   // Constructor for action without a target
   template<action::ActionTypeConcept T>
@@ -64,17 +97,73 @@ struct MemoryEntry {
     uint64_t time, 
     const npc::NPCIdentity::ref_type& actor_ref,
     T action_type
-  ) : timestamp(time),
-      actor(actor_ref),
-      action(action_type),
-      target_entity(std::nullopt),
-      target_object(std::nullopt) {}
+  ) : actor(actor_ref->entity->handle),
+      timestamp(toTick(time)),
+      span(0),
+      action_index(static_cast<uint8_t>(action::ActionType(action_type).index())),
+      target_kind(TargetKind::None) {}
+  
+  // Constructor for the same observation spanning several ticks
+  // (callers start a new entry for runs longer than MAX_SPAN; longer ones are cut short)
+  MemoryEntry(
+    const MemoryEntry& observation,
+    uint64_t first_time,
+    uint64_t last_time
+  ) : actor(observation.actor),
+      target(observation.target),
+      timestamp(toTick(first_time)),
+      span(toSpan(first_time, last_time)),
+      action_index(observation.action_index),
+      target_kind(observation.target_kind) {}
+
+  // Last tick of a run of identical observations (equals timestamp for a single tick)
+  uint64_t lastTimestamp() const {
+    return uint64_t(timestamp) + span;
+  }
+
+  // The action that was observed
+  action::ActionType action() const {
+    return action::action_type_system::fromIndex(action_index);
+  }
+
+  std::size_t actionIndex() const {
+    return action_index;
+  }
+
+  // Handle of the NPC that performed the action
+  entity::EntityHandle actorHandle() const {
+    return actor;
+  }
+
+  // Handle of the entity the action was aimed at, if any
+  const entity::EntityHandle* targetEntity() const {
+    return target_kind == TargetKind::Entity ? &target : nullptr;
+  }
+
+  // Handle of the object involved in the action, if any
+  const entity::EntityHandle* targetObject() const {
+    return target_kind == TargetKind::Object ? &target : nullptr;
+  }
       
   // Define storage type
-  using storage = cpioo::managed_entity::storage<MemoryEntry, 10, uint32_t>;
+  using storage = pool::ManagedStorage<MemoryEntry>;
   using ref_type = storage::ref_type;
+
+private:
+  static uint32_t toTick(uint64_t time) {
+    return static_cast<uint32_t>(std::min(time, MAX_TICK));
+  }
+
+  static uint16_t toSpan(uint64_t first_time, uint64_t last_time) {
+    if (last_time < first_time) {
+      return 0;
+    }
+    return static_cast<uint16_t>(std::min(last_time - first_time, MAX_SPAN));
+  }
 };
 
+static_assert(sizeof(MemoryEntry) == 16, "MemoryEntry should stay packed into 16 bytes");
+
 } // namespace history_game::datamodel::memory
 
-#endif // HISTORY_GAME_DATAMODEL_MEMORY_MEMORY_ENTRY_H
\ No newline at end of file
+#endif // HISTORY_GAME_DATAMODEL_MEMORY_MEMORY_ENTRY_H
@@ -5,43 +5,65 @@
 #include <vector>
 #include <string>
 #include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
 #include <history_game/datamodel/action/action_sequence.h>
+#include <history_game/datamodel/action/sequence_fingerprint.h>
 #include <history_game/datamodel/npc/drive.h>
+#include <history_game/datamodel/npc/drive_set.h>
 
 namespace history_game::datamodel::memory {
 
 /**
  * Represents the impact of an action sequence on an NPC's emotional drives
  */
-struct MemoryEpisode {
+struct MemoryEpisode : pool::Counted<MemoryEpisode> {
   // Start and end time of the episode
-  const uint64_t start_time;
-  const uint64_t end_time;
+  uint64_t start_time;
+  uint64_t end_time;
   
   // Reference to the action sequence that created this episode
-  const action::ActionSequence::ref_type action_sequence;
+  action::ActionSequence::ref_type action_sequence;
+  
+  // Fingerprint of the action sequence, computed once for the episode store
+  action::SequenceFingerprint fingerprint;
   
   // Impact on each drive
-  const std::vector<npc::Drive> drive_impacts;
+  npc::DriveSet drive_impacts;
   
   // How many times this has been repeated
-  const uint32_t repetition_count;
+  uint32_t repetition_count;
   
   // Constructor
   MemoryEpisode(
     uint64_t start,
     uint64_t end,
     const action::ActionSequence::ref_type& sequence,
-    std::vector<npc::Drive> impacts,
+    npc::DriveSet impacts,
     uint32_t repetitions = 1
   ) : start_time(start),
       end_time(end),
       action_sequence(sequence),
-      drive_impacts(std::move(impacts)),
+      fingerprint(action::sequence_fingerprint_system::computeFingerprint(sequence)),
+      drive_impacts(impacts),
+      repetition_count(repetitions) {}
+  
+  // Constructor with the already computed fingerprint of the sequence
+  MemoryEpisode(
+    uint64_t start,
+    uint64_t end,
+    const action::ActionSequence::ref_type& sequence,
+    npc::DriveSet impacts,
+    uint32_t repetitions,
+    const action::SequenceFingerprint& sequence_fingerprint
+  ) : start_time(start),
+      end_time(end),
+      action_sequence(sequence),
+      fingerprint(sequence_fingerprint),
+      drive_impacts(impacts),
       repetition_count(repetitions) {}
       
   // Define storage type
-  using storage = cpioo::managed_entity::storage<MemoryEpisode, 10, uint32_t>;
+  using storage = pool::ManagedStorage<MemoryEpisode>;
   using ref_type = storage::ref_type;
 };
 
@@ -2,30 +2,293 @@
 #define HISTORY_GAME_DATAMODEL_MEMORY_PERCEPTION_BUFFER_H
 
 #include <vector>
+#include <cassert>
 #include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <iterator>
+#include <algorithm>
 #include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
+#include <history_game/datamodel/pool/small_vector.h>
 #include <history_game/datamodel/memory/memory_entry.h>
 
 namespace history_game::datamodel::memory {
 
+/**
+ * Fixed-capacity, append-only block of memory entries
+ * Chunks are shared between perception buffer versions. Entries are only ever
+ * appended after the last used slot, so every buffer version keeps seeing the
+ * same entries in the slots it was created with.
+ */
+struct PerceptionChunk : pool::Counted<PerceptionChunk> {
+  // Maximum number of entries this chunk can hold
+  size_t capacity;
+
+  // Entries written so far (never reallocated, never overwritten)
+  mutable std::vector<MemoryEntry::ref_type> entries;
+
+  // Constructor
+  explicit PerceptionChunk(size_t chunk_capacity)
+    : capacity(chunk_capacity) {
+    entries.reserve(chunk_capacity);
+  }
+
+  // Define storage type
+  using storage = pool::ManagedStorage<PerceptionChunk>;
+  using ref_type = storage::ref_type;
+};
+
+/**
+ * Read-only view over the newest entries of a perception buffer
+ * The entries are a few runs of consecutive chunk slots, oldest run first.
+ * Usually that is the tail of a full previous chunk followed by the prefix of
+ * the current chunk; runs split where an entry was superseded in place.
+ */
+struct PerceptionWindow {
+  // Consecutive entries [begin, end) of one chunk
+  struct Run {
+    PerceptionChunk::ref_type chunk;
+    uint32_t begin;
+    uint32_t end;
+
+    Run(PerceptionChunk::ref_type run_chunk, size_t run_begin, size_t run_end)
+      : chunk(std::move(run_chunk)),
+        begin(static_cast<uint32_t>(run_begin)),
+        end(static_cast<uint32_t>(run_end)) {}
+
+    size_t size() const { return end - begin; }
+  };
+
+  using Runs = pool::SmallVector<Run, 2>;
+
+  // Runs holding the entries, oldest first
+  Runs runs;
+
+  // Total number of entries visible in this window
+  size_t count;
+
+  // Constructor
+  PerceptionWindow(Runs window_runs, size_t visible_total)
+    : runs(std::move(window_runs)),
+      count(visible_total) {}
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  // Oldest entry is at index 0, newest at size() - 1
+  const MemoryEntry::ref_type& operator[](size_t index) const {
+    assert(index < count);
+    const Run* run = runs.begin();
+    while (index >= run->size()) {
+      index -= run->size();
+      ++run;
+    }
+    return run->chunk->entries[run->begin + index];
+  }
+
+  /**
+   * Random access iterator over the window
+   */
+  class const_iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = MemoryEntry::ref_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const MemoryEntry::ref_type*;
+    using reference = const MemoryEntry::ref_type&;
+
+    const_iterator() : window(nullptr), index(0) {}
+    const_iterator(const PerceptionWindow* w, size_t i) : window(w), index(i) {}
+
+    reference operator*() const { return (*window)[index]; }
+    pointer operator->() const { return &(*window)[index]; }
+    reference operator[](difference_type n) const { return (*window)[index + n]; }
+
+    const_iterator& operator++() { ++index; return *this; }
+    const_iterator operator++(int) { auto copy = *this; ++index; return copy; }
+    const_iterator& operator--() { --index; return *this; }
+    const_iterator operator--(int) { auto copy = *this; --index; return copy; }
+    const_iterator& operator+=(difference_type n) { index += n; return *this; }
+    const_iterator& operator-=(difference_type n) { index -= n; return *this; }
+    const_iterator operator+(difference_type n) const { return const_iterator(window, index + n); }
+    const_iterator operator-(difference_type n) const { return const_iterator(window, index - n); }
+    difference_type operator-(const const_iterator& other) const {
+      return static_cast<difference_type>(index) - static_cast<difference_type>(other.index);
+    }
+
+    bool operator==(const const_iterator& other) const { return index == other.index; }
+    bool operator!=(const const_iterator& other) const { return index != other.index; }
+    bool operator<(const const_iterator& other) const { return index < other.index; }
+    bool operator>(const const_iterator& other) const { return index > other.index; }
+    bool operator<=(const const_iterator& other) const { return index <= other.index; }
+    bool operator>=(const const_iterator& other) const { return index >= other.index; }
+
+  private:
+    const PerceptionWindow* window;
+    size_t index;
+  };
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, count); }
+};
+
+namespace perception_buffer_system {
+
+  // Runs a window may be split into before it is copied into a single chunk
+  constexpr size_t MAX_RUNS = 8;
+
+  /**
+   * Create a window holding the newest `capacity` of the given entries
+   */
+  inline PerceptionWindow makeWindow(
+    const std::vector<MemoryEntry::ref_type>& entries,
+    size_t capacity
+  ) {
+    if (entries.empty() || capacity == 0) {
+      return PerceptionWindow(PerceptionWindow::Runs(), 0);
+    }
+
+    size_t count = std::min(entries.size(), capacity);
+    PerceptionChunk chunk(capacity);
+    for (size_t i = entries.size() - count; i < entries.size(); ++i) {
+      chunk.entries.push_back(entries[i]);
+    }
+
+    PerceptionWindow::Runs runs;
+    runs.emplace_back(PerceptionChunk::storage::make_entity(std::move(chunk)), 0, count);
+    return PerceptionWindow(std::move(runs), count);
+  }
+
+  /**
+   * Copy a window split into more than MAX_RUNS runs into a single chunk
+   */
+  inline PerceptionWindow compact(PerceptionWindow window, size_t capacity) {
+    if (window.runs.size() <= MAX_RUNS) {
+      return window;
+    }
+
+    std::vector<MemoryEntry::ref_type> entries(window.begin(), window.end());
+    return makeWindow(entries, capacity);
+  }
+
+  /**
+   * Append entries to a perception window, keeping at most `capacity` of the newest
+   *
+   * When the window is the latest version of its last chunk, the entries are written
+   * in place into the free slots of that chunk, so appending k entries costs O(k).
+   * Older windows are unaffected because they never look past their own runs.
+   * When another version already extended the chunk, the entries start a new one.
+   */
+  inline PerceptionWindow append(
+    const PerceptionWindow& window,
+    const std::vector<MemoryEntry::ref_type>& new_entries,
+    size_t capacity
+  ) {
+    if (new_entries.empty()) {
+      return window;
+    }
+
+    if (capacity == 0) {
+      return PerceptionWindow(PerceptionWindow::Runs(), 0);
+    }
+
+    // If the new entries alone fill the buffer, nothing from the old window survives
+    if (new_entries.size() >= capacity) {
+      return makeWindow(new_entries, capacity);
+    }
+
+    // Keep the newest runs that will still be visible, trimming the oldest one
+    size_t keep = std::min(window.count, capacity - new_entries.size());
+    size_t skip = window.count - keep;
+    PerceptionWindow::Runs runs;
+    for (const auto& run : window.runs) {
+      if (skip >= run.size()) {
+        skip -= run.size();
+        continue;
+      }
+      runs.emplace_back(run.chunk, run.begin + skip, run.end);
+      skip = 0;
+    }
+
+    // Only the version ending at the last written slot of its chunk may write after it
+    bool can_extend = !runs.empty() &&
+      runs.back().chunk->entries.size() == runs.back().end;
+
+    for (const auto& entry : new_entries) {
+      if (!can_extend || runs.back().end == runs.back().chunk->capacity) {
+        runs.emplace_back(PerceptionChunk::storage::make_entity(PerceptionChunk(capacity)), 0, 0);
+        can_extend = true;
+      }
+
+      runs.back().chunk->entries.push_back(entry);
+      runs.back().end++;
+    }
+
+    return compact(PerceptionWindow(std::move(runs), keep + new_entries.size()), capacity);
+  }
+
+  /**
+   * Remove entries from a perception window and append others
+   * The removed entries are left out by splitting the runs around them, so the
+   * window keeps sharing its chunks.
+   *
+   * @param removed Indices of the entries to remove, in increasing order
+   */
+  inline PerceptionWindow replace(
+    const PerceptionWindow& window,
+    const std::vector<size_t>& removed,
+    const std::vector<MemoryEntry::ref_type>& new_entries,
+    size_t capacity
+  ) {
+    PerceptionWindow::Runs runs;
+    size_t first = 0;
+    auto next_removed = removed.begin();
+    for (const auto& run : window.runs) {
+      size_t begin = run.begin;
+      for (; next_removed != removed.end() && *next_removed < first + run.size(); ++next_removed) {
+        size_t slot = run.begin + (*next_removed - first);
+        if (slot > begin) {
+          runs.emplace_back(run.chunk, begin, slot);
+        }
+        begin = slot + 1;
+      }
+      if (begin < run.end) {
+        runs.emplace_back(run.chunk, begin, run.end);
+      }
+      first += run.size();
+    }
+
+    PerceptionWindow remaining(std::move(runs), window.count - removed.size());
+    return compact(append(remaining, new_entries, capacity), capacity);
+  }
+
+} // namespace perception_buffer_system
+
 /**
  * Short-term buffer of recent observations and actions
  * This is the working memory of an NPC
  */
-struct PerceptionBuffer {
+struct PerceptionBuffer : pool::Counted<PerceptionBuffer> {
   // List of recent memory entries
-  const std::vector<MemoryEntry::ref_type> recent_perceptions;
-  
-  // Constructor
+  PerceptionWindow recent_perceptions;
+
+  // Constructor from an explicit list of entries
   explicit PerceptionBuffer(
     std::vector<MemoryEntry::ref_type> perceptions
-  ) : recent_perceptions(std::move(perceptions)) {}
-      
+  ) : recent_perceptions(perception_buffer_system::makeWindow(perceptions, perceptions.size())) {}
+
+  // Constructor from an existing window (shares its chunks)
+  explicit PerceptionBuffer(
+    PerceptionWindow window
+  ) : recent_perceptions(std::move(window)) {}
+
   // Define storage type
-  using storage = cpioo::managed_entity::storage<PerceptionBuffer, 10, uint32_t>;
+  using storage = pool::ManagedStorage<PerceptionBuffer>;
   using ref_type = storage::ref_type;
 };
 
+
 } // namespace history_game::datamodel::memory
 
-#endif // HISTORY_GAME_DATAMODEL_MEMORY_PERCEPTION_BUFFER_H
\ No newline at end of file
+#endif // HISTORY_GAME_DATAMODEL_MEMORY_PERCEPTION_BUFFER_H
@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/datamodel/memory/segmentation_state.cpp
+#include <history_game/datamodel/memory/segmentation_state.h>
+
+namespace history_game::datamodel::memory {
+// Empty implementation file
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef HISTORY_GAME_DATAMODEL_MEMORY_SEGMENTATION_STATE_H
+#define HISTORY_GAME_DATAMODEL_MEMORY_SEGMENTATION_STATE_H
+
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
+#include <history_game/datamodel/memory/memory_entry.h>
+
+namespace history_game::datamodel::memory {
+
+/**
+ * Progress of splitting an NPC's perceptions into action sequences
+ * Lets episode formation look only at perceptions it has not seen yet
+ */
+struct SegmentationState : pool::Counted<SegmentationState> {
+  // Last tick already processed (none before the first perception)
+  std::optional<uint64_t> watermark;
+  
+  // Sequence still accepting new entries, in time order
+  std::vector<MemoryEntry::ref_type> open_sequence;
+  
+  // Constructor
+  SegmentationState(
+    std::optional<uint64_t> last_processed,
+    std::vector<MemoryEntry::ref_type> sequence
+  ) : watermark(last_processed),
+      open_sequence(std::move(sequence)) {}
+      
+  // Define storage type
+  using storage = pool::ManagedStorage<SegmentationState>;
+  using ref_type = storage::ref_type;
+};
+
+} // namespace history_game::datamodel::memory
+
+#endif // HISTORY_GAME_DATAMODEL_MEMORY_SEGMENTATION_STATE_H
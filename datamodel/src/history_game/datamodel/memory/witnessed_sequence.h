@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <vector>
 #include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
+#include <history_game/datamodel/pool/small_vector.h>
 #include <history_game/datamodel/action/action_sequence.h>
 #include <history_game/datamodel/npc/npc_identity.h>
 #include <history_game/datamodel/npc/drive.h>
@@ -14,8 +16,8 @@ namespace history_game::datamodel::memory {
  * Perceived effectiveness of a sequence for a specific drive
  */
 struct PerceivedEffectiveness {
-  const npc::DriveType drive_type;
-  const float value;
+  npc::DriveType drive_type;
+  float value;
   
   // Constructor
   template<npc::DriveTypeConcept T>
@@ -23,36 +25,39 @@ struct PerceivedEffectiveness {
     : drive_type(type), value(effectiveness) {}
 };
 
+// Sized like the affective traces of relationships, which are kept per drive too
+using DriveEffectiveness = pool::SmallVector<PerceivedEffectiveness, 3>;
+
 /**
  * Represents a behavior sequence that has been observed
  * and might be imitated
  */
-struct WitnessedSequence {
+struct WitnessedSequence : pool::Counted<WitnessedSequence> {
   // The action sequence that was observed
-  const action::ActionSequence::ref_type sequence;
+  action::ActionSequence::ref_type sequence;
   
   // The NPC who performed the sequence
-  const npc::NPCIdentity::ref_type performer;
+  npc::NPCIdentity::ref_type performer;
   
   // Number of times witnessed
-  const uint32_t observation_count;
+  uint32_t observation_count;
   
   // Perceived effectiveness per drive (subjective to the observer)
-  const std::vector<PerceivedEffectiveness> effectiveness;
+  DriveEffectiveness effectiveness;
   
   // Constructor
   WitnessedSequence(
     const action::ActionSequence::ref_type& action_sequence,
     const npc::NPCIdentity::ref_type& sequence_performer,
     uint32_t times_witnessed,
-    std::vector<PerceivedEffectiveness> drive_effectiveness
+    DriveEffectiveness drive_effectiveness
   ) : sequence(action_sequence),
       performer(sequence_performer),
       observation_count(times_witnessed),
       effectiveness(std::move(drive_effectiveness)) {}
       
   // Define storage type
-  using storage = cpioo::managed_entity::storage<WitnessedSequence, 10, uint32_t>;
+  using storage = pool::ManagedStorage<WitnessedSequence>;
   using ref_type = storage::ref_type;
 };
 
@@ -60,8 +60,8 @@ using DriveType = std::variant<
  * Structure to represent a drive with its intensity
  */
 struct Drive {
-  const DriveType type;
-  const float intensity;
+  DriveType type;
+  float intensity;
   
   // Constructor with concept constraint
   template<DriveTypeConcept T>
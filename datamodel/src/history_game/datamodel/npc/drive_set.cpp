@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/datamodel/npc/drive_set.cpp
+#include <history_game/datamodel/npc/drive_set.h>
+
+namespace history_game::datamodel::npc {
+// Empty implementation file
+}
\ No newline at end of file
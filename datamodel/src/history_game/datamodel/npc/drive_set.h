@@ -0,0 +1,127 @@
+#ifndef HISTORY_GAME_DATAMODEL_NPC_DRIVE_SET_H
+#define HISTORY_GAME_DATAMODEL_NPC_DRIVE_SET_H
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <variant>
+#include <iterator>
+#include <initializer_list>
+#include <history_game/datamodel/npc/drive.h>
+
+namespace history_game::datamodel::npc {
+
+/**
+ * Intensity of each drive, indexed by the position of its type in DriveType
+ * A drive is either present or absent; absent drives always have an intensity
+ * of 0, so combining and scoring can run over every slot without branching.
+ */
+struct DriveSet {
+  // Number of drive types
+  static constexpr size_t SIZE = std::variant_size_v<DriveType>;
+
+  // Intensity of each drive (0 when absent)
+  std::array<float, SIZE> values{};
+
+  // Bit i is set when the drive at index i is present
+  uint8_t present = 0;
+
+  static_assert(SIZE <= 8, "DriveSet presence mask holds at most 8 drive types");
+
+  // Empty set
+  DriveSet() = default;
+
+  // Set with the given drives (a later drive of the same type replaces an earlier one)
+  DriveSet(std::initializer_list<Drive> drives) {
+    for (const auto& drive : drives) {
+      set(drive.type, drive.intensity);
+    }
+  }
+
+  // Set with the given drives (a later drive of the same type replaces an earlier one)
+  DriveSet(const std::vector<Drive>& drives) {
+    for (const auto& drive : drives) {
+      set(drive.type, drive.intensity);
+    }
+  }
+
+  /**
+   * Drive type stored at a given index
+   */
+  static DriveType typeAt(size_t index) {
+    return makeTypes(std::make_index_sequence<SIZE>{})[index];
+  }
+
+  bool has(size_t index) const { return (present >> index) & 1u; }
+  bool has(const DriveType& type) const { return has(type.index()); }
+
+  float get(size_t index) const { return values[index]; }
+  float get(const DriveType& type) const { return values[type.index()]; }
+
+  void set(size_t index, float intensity) {
+    values[index] = intensity;
+    present |= static_cast<uint8_t>(1u << index);
+  }
+  void set(const DriveType& type, float intensity) { set(type.index(), intensity); }
+
+  // Number of drives present
+  size_t size() const {
+    size_t count = 0;
+    for (size_t i = 0; i < SIZE; ++i) {
+      count += has(i);
+    }
+    return count;
+  }
+
+  bool empty() const { return present == 0; }
+
+  /**
+   * Forward iterator over the drives present, in DriveType order
+   */
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Drive;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Drive;
+
+    const_iterator(const DriveSet* s, size_t i) : set(s), index(i) { skipAbsent(); }
+
+    Drive operator*() const { return Drive(typeAt(index), set->values[index]); }
+
+    const_iterator& operator++() { ++index; skipAbsent(); return *this; }
+    const_iterator operator++(int) { auto copy = *this; ++(*this); return copy; }
+
+    bool operator==(const const_iterator& other) const { return index == other.index; }
+    bool operator!=(const const_iterator& other) const { return index != other.index; }
+
+  private:
+    void skipAbsent() {
+      while (index < SIZE && !set->has(index)) {
+        ++index;
+      }
+    }
+
+    const DriveSet* set;
+    size_t index;
+  };
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, SIZE); }
+
+private:
+  template<size_t... I>
+  static const std::array<DriveType, SIZE>& makeTypes(std::index_sequence<I...>) {
+    static const std::array<DriveType, SIZE> types{
+      DriveType{std::in_place_index<I>}...
+    };
+    return types;
+  }
+};
+
+} // namespace history_game::datamodel::npc
+
+#endif // HISTORY_GAME_DATAMODEL_NPC_DRIVE_SET_H
@@ -3,58 +3,80 @@
 
 #include <vector>
 #include <string>
+#include <optional>
 #include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
 #include <history_game/datamodel/entity/entity.h>
 #include <history_game/datamodel/npc/drive.h>
+#include <history_game/datamodel/npc/drive_set.h>
 #include <history_game/datamodel/npc/npc_identity.h>
 #include <history_game/datamodel/memory/perception_buffer.h>
 #include <history_game/datamodel/memory/memory_episode.h>
+#include <history_game/datamodel/memory/episode_store.h>
 #include <history_game/datamodel/memory/witnessed_sequence.h>
+#include <history_game/datamodel/memory/segmentation_state.h>
 #include <history_game/datamodel/relationship/relationship.h>
+#include <history_game/datamodel/relationship/relationship_store.h>
 #include <history_game/datamodel/relationship/relationship_target.h>
 
 namespace history_game::datamodel::npc {
 
 /**
  * NPC struct representing a non-player character (or player)
- * All data is immutable
+ * All data is immutable: it is set by the constructor and only read through
+ * the accessors
  */
-struct NPC {
+struct NPC : pool::Counted<NPC> {
+private:
   // Reference to the NPC's identity (used in memories, preventing cycles)
-  const NPCIdentity::ref_type identity;
+  NPCIdentity::ref_type identity;
   
   // The NPC's current drives
-  const std::vector<Drive> drives;
+  DriveSet drives;
   
   // Reference to perception buffer
-  const memory::PerceptionBuffer::ref_type perception;
+  memory::PerceptionBuffer::ref_type perception;
   
-  // Episodic memory - sequences that had emotional impact
-  const std::vector<memory::MemoryEpisode::ref_type> episodic_memory;
+  // Episodic memory - sequences that had emotional impact, one per distinct sequence
+  memory::EpisodeStore episodic_memory;
   
   // Observed behaviors
-  const std::vector<memory::WitnessedSequence::ref_type> observed_behaviors;
+  std::vector<memory::WitnessedSequence::ref_type> observed_behaviors;
   
-  // Relationships with other NPCs (asymmetric)
-  const std::vector<relationship::Relationship::ref_type> relationships;
+  // Relationships with other NPCs (asymmetric), indexed by target
+  relationship::RelationshipStore relationships;
   
+  // Where episode formation left off in the perception buffer (none until it runs)
+  std::optional<memory::SegmentationState::ref_type> segmentation;
+  
+public:
   // Constructor
   NPC(
     const NPCIdentity::ref_type& npc_identity,
-    std::vector<Drive> npc_drives,
+    DriveSet npc_drives,
     const memory::PerceptionBuffer::ref_type& perception_buffer,
-    std::vector<memory::MemoryEpisode::ref_type> episodes,
+    memory::EpisodeStore episodes,
     std::vector<memory::WitnessedSequence::ref_type> behaviors,
-    std::vector<relationship::Relationship::ref_type> npc_relationships
+    relationship::RelationshipStore npc_relationships,
+    std::optional<memory::SegmentationState::ref_type> segmentation_state = std::nullopt
   ) : identity(npc_identity),
-      drives(std::move(npc_drives)),
+      drives(npc_drives),
       perception(perception_buffer),
       episodic_memory(std::move(episodes)),
       observed_behaviors(std::move(behaviors)),
-      relationships(std::move(npc_relationships)) {}
+      relationships(std::move(npc_relationships)),
+      segmentation(std::move(segmentation_state)) {}
+  
+  const NPCIdentity::ref_type& getIdentity() const { return identity; }
+  const DriveSet& getDrives() const { return drives; }
+  const memory::PerceptionBuffer::ref_type& getPerception() const { return perception; }
+  const memory::EpisodeStore& getEpisodicMemory() const { return episodic_memory; }
+  const std::vector<memory::WitnessedSequence::ref_type>& getObservedBehaviors() const { return observed_behaviors; }
+  const relationship::RelationshipStore& getRelationships() const { return relationships; }
+  const std::optional<memory::SegmentationState::ref_type>& getSegmentation() const { return segmentation; }
       
   // Define storage type for NPCs
-  using storage = cpioo::managed_entity::storage<NPC, 10, uint32_t>;
+  using storage = pool::ManagedStorage<NPC>;
   using ref_type = storage::ref_type;
 };
 
@@ -2,8 +2,10 @@
 #define HISTORY_GAME_DATAMODEL_NPC_NPC_IDENTITY_H
 
 #include <string>
+#include <cstdint>
 #include <optional>
 #include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
 #include <history_game/datamodel/entity/entity.h>
 #include <history_game/datamodel/world/position.h>
 #include <history_game/datamodel/action/action_type.h>
@@ -16,25 +18,25 @@ struct WorldObject;
 namespace history_game::datamodel::npc {
 
   // Forward declaration needed for the optional reference
-  using WorldObjectRef = cpioo::managed_entity::reference<cpioo::managed_entity::storage<object::WorldObject, 10, uint32_t>>;
+  using WorldObjectRef = pool::Ref<object::WorldObject>;
 
 /**
  * Basic identity information for an NPC
  * This struct is referenced from memories and contains no references to memories,
  * preventing circular references
  */
-struct NPCIdentity {
+struct NPCIdentity : pool::Counted<NPCIdentity> {
   // Reference to the base entity (contains ID and position)
-  const entity::Entity::ref_type entity;
+  entity::Entity::ref_type entity;
   
   // The action currently being performed
-  const std::optional<action::ActionType> current_action;
+  std::optional<action::ActionType> current_action;
   
   // Target of the action, if any (entity reference to avoid circular refs)
-  const std::optional<entity::Entity::ref_type> target_entity;
+  std::optional<entity::Entity::ref_type> target_entity;
   
   // Object involved in the action, if any
-  const std::optional<WorldObjectRef> target_object;
+  std::optional<WorldObjectRef> target_object;
   
   // Constructor with no action
   NPCIdentity(
@@ -104,9 +106,27 @@ struct NPCIdentity {
       current_action(action),
       target_entity(std::nullopt),
       target_object(std::nullopt) {}
+  
+  // Equal identities are shared (see PoolConfig); references compare by object
+  bool operator==(const NPCIdentity& other) const {
+    bool same_action = current_action ?
+      other.current_action && current_action->index() == other.current_action->index() :
+      !other.current_action;
+    return entity == other.entity && same_action &&
+           target_entity == other.target_entity && target_object == other.target_object;
+  }
+  
+  uint64_t hashValue() const {
+    uint64_t hash = reinterpret_cast<uintptr_t>(&*entity);
+    hash = pool::hash_cons_system::combine(hash, current_action ? current_action->index() + 1 : 0);
+    if (target_entity) {
+      hash = pool::hash_cons_system::combine(hash, reinterpret_cast<uintptr_t>(&**target_entity));
+    }
+    return hash;
+  }
       
   // Define storage type
-  using storage = cpioo::managed_entity::storage<NPCIdentity, 10, uint32_t>;
+  using storage = pool::ManagedStorage<NPCIdentity>;
   using ref_type = storage::ref_type;
 };
 
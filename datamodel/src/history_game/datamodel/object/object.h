@@ -6,6 +6,7 @@
 #include <variant>
 #include <concepts>
 #include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
 #include <history_game/datamodel/entity/entity.h>
 #include <history_game/datamodel/npc/npc_identity.h>
 
@@ -63,15 +64,15 @@ using ObjectCategory = std::variant<
 /**
  * Represents a world object
  */
-struct WorldObject {
+struct WorldObject : pool::Counted<WorldObject> {
   // Reference to the base entity
-  const entity::Entity::ref_type entity;
+  entity::Entity::ref_type entity;
   
   // Object category
-  const ObjectCategory category;
+  ObjectCategory category;
   
   // Creator of this object (if any)
-  const npc::NPCIdentity::ref_type created_by;
+  npc::NPCIdentity::ref_type created_by;
   
   // Constructor
   template<ObjectCategoryConcept T>
@@ -84,7 +85,7 @@ struct WorldObject {
       created_by(creator) {}
       
   // Define storage type
-  using storage = cpioo::managed_entity::storage<WorldObject, 10, uint32_t>;
+  using storage = pool::ManagedStorage<WorldObject>;
   using ref_type = storage::ref_type;
 };
 
@@ -0,0 +1,197 @@
+#ifndef HISTORY_GAME_DATAMODEL_POOL_HASH_CONS_H
+#define HISTORY_GAME_DATAMODEL_POOL_HASH_CONS_H
+
+#include <mutex>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <unordered_map>
+
+namespace history_game::datamodel::pool {
+
+/**
+ * Lookups of hash-consing tables, and how many waited for a shard lock held by another thread
+ */
+struct HashConsContention {
+  uint64_t lookups = 0;
+  uint64_t contended = 0;
+};
+
+/**
+ * Equal values of one managed type made recently, to share instead of duplicating
+ *
+ * Values are kept for the current and the previous generation, and the
+ * simulation advances the generation once per tick, so a value repeated from
+ * one tick to the next is shared while the table holds no more than two
+ * ticks' worth of references. A value found in the previous generation is
+ * carried over to the current one. The table is split in shards with a lock
+ * each, so NPCs updated in parallel rarely wait for one another; every
+ * lookup takes its shard's lock, and the lookups that had to wait for it
+ * are counted (see HashConsContention).
+ *
+ * Types are shared this way when their PoolConfig enables hash_cons; they
+ * provide hashValue() and operator==.
+ */
+template<typename T, typename Ref>
+class HashConsTable {
+public:
+  static constexpr std::size_t SHARDS = 16;
+
+  /**
+   * The stored value equal to value if there is one, otherwise the one made by make
+   * @return The reference, and whether it was shared
+   */
+  template<typename Make>
+  std::pair<Ref, bool> intern(T&& value, Make make) {
+    uint64_t hash = value.hashValue();
+    Shard& shard = shards[hash % SHARDS];
+    std::unique_lock<std::mutex> lock(shard.mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      lock.lock();
+      shard.contended++;
+    }
+    shard.lookups++;
+
+    if (const Ref* found = find(shard.current, hash, value)) {
+      return {*found, true};
+    }
+    if (const Ref* found = find(shard.previous, hash, value)) {
+      Ref shared(*found);
+      shard.current.emplace(hash, shared);
+      return {shared, true};
+    }
+
+    Ref made = make(std::move(value));
+    shard.current.emplace(hash, made);
+    return {made, false};
+  }
+
+  // Drops the values not used since the previous generation
+  void advanceGeneration() {
+    for (Shard& shard : shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.previous.clear();
+      shard.previous.swap(shard.current);
+    }
+  }
+
+  HashConsContention contention() {
+    HashConsContention total;
+    for (Shard& shard : shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      total.lookups += shard.lookups;
+      total.contended += shard.contended;
+    }
+    return total;
+  }
+
+  std::size_t size() {
+    std::size_t total = 0;
+    for (Shard& shard : shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      total += shard.current.size() + shard.previous.size();
+    }
+    return total;
+  }
+
+private:
+  using Generation = std::unordered_multimap<uint64_t, Ref>;
+
+  struct Shard {
+    std::mutex mutex;
+    Generation current;
+    Generation previous;
+
+    // Counted under the shard's lock
+    uint64_t lookups = 0;
+    uint64_t contended = 0;
+  };
+
+  static const Ref* find(const Generation& generation, uint64_t hash, const T& value) {
+    auto [first, last] = generation.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+      if (*it->second == value) {
+        return &it->second;
+      }
+    }
+    return nullptr;
+  }
+
+  std::array<Shard, SHARDS> shards;
+};
+
+namespace hash_cons_system {
+
+  // Whether types with hash_cons in their PoolConfig are shared (HISTORY_GAME_HASH_CONS)
+#if defined(HISTORY_GAME_HASH_CONS)
+  constexpr bool ENABLED = true;
+#else
+  constexpr bool ENABLED = false;
+#endif
+
+  struct Registry {
+    std::mutex mutex;
+    std::vector<void (*)()> advance;
+    std::vector<HashConsContention (*)()> contention;
+  };
+
+  inline Registry& getRegistry() {
+    static Registry registry;
+    return registry;
+  }
+
+  /**
+   * Table of a hash-consed type, registered on first use
+   */
+  template<typename T, typename Ref>
+  inline HashConsTable<T, Ref>& getTable() {
+    static HashConsTable<T, Ref>* table = [] {
+      // Never destroyed, the references it holds can outlive static destruction
+      static HashConsTable<T, Ref>* type_table = new HashConsTable<T, Ref>();
+      Registry& registry = getRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.advance.push_back([] { getTable<T, Ref>().advanceGeneration(); });
+      registry.contention.push_back([] { return getTable<T, Ref>().contention(); });
+      return type_table;
+    }();
+    return *table;
+  }
+
+  /**
+   * Start a new generation in every table (once per tick)
+   */
+  inline void advanceGeneration() {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto advance : registry.advance) {
+      advance();
+    }
+  }
+
+  /**
+   * Lookups of every table so far, and how many waited for a shard lock
+   */
+  inline HashConsContention getContention() {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    HashConsContention total;
+    for (auto contention : registry.contention) {
+      HashConsContention table = contention();
+      total.lookups += table.lookups;
+      total.contended += table.contended;
+    }
+    return total;
+  }
+
+  // Mixes a value into a hash (boost::hash_combine)
+  inline uint64_t combine(uint64_t hash, uint64_t value) {
+    return hash ^ (value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+  }
+
+} // namespace hash_cons_system
+
+} // namespace history_game::datamodel::pool
+
+#endif // HISTORY_GAME_DATAMODEL_POOL_HASH_CONS_H
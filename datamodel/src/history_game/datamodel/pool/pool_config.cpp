@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/datamodel/pool/pool_config.cpp
+#include <history_game/datamodel/pool/pool_config.h>
+
+namespace history_game::datamodel::pool {
+// Empty implementation file
+}
\ No newline at end of file
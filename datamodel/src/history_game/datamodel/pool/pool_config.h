@@ -0,0 +1,102 @@
+#ifndef HISTORY_GAME_DATAMODEL_POOL_POOL_CONFIG_H
+#define HISTORY_GAME_DATAMODEL_POOL_POOL_CONFIG_H
+
+#include <cstdint>
+#include <cstddef>
+#include <history_game/datamodel/pool/ref_count.h>
+
+namespace history_game::datamodel {
+
+namespace action { struct ActionSequence; }
+namespace entity { struct Entity; }
+namespace memory {
+  struct EpisodeBucket;
+  struct EpisodeBucketChunk;
+  struct EpisodeTable;
+  struct MemoryEntry;
+  struct MemoryEpisode;
+  struct PerceptionBuffer;
+  struct PerceptionChunk;
+  struct SegmentationState;
+  struct WitnessedSequence;
+}
+namespace npc {
+  struct NPC;
+  struct NPCIdentity;
+}
+namespace object { struct WorldObject; }
+namespace relationship {
+  struct Relationship;
+  struct RelationshipIndex;
+}
+namespace world {
+  struct SimulationClock;
+  struct World;
+  struct WorldDirectory;
+}
+
+} // namespace history_game::datamodel
+
+namespace history_game::datamodel::pool {
+
+/**
+ * Storage parameters of a managed type
+ * Each chunk of the type's storage holds 2^chunk_bits objects, and refcount_type
+ * is how references to an object are counted. Types with millions of live
+ * objects use large chunks, types with a handful use small ones. Every type
+ * uses SharedRefCount, since parallel phases copy references to them and
+ * retired worlds can be released away from the simulation thread. Types with
+ * hash_cons share equal values made in consecutive ticks (see HashConsTable).
+ */
+template<typename T>
+struct PoolConfig {
+  static constexpr const char* name = "unnamed";
+  static constexpr std::size_t chunk_bits = 10;
+  using refcount_type = SharedRefCount;
+  static constexpr bool hash_cons = false;
+};
+
+#define HISTORY_GAME_POOL_CONFIG(TYPE, NAME, CHUNK_BITS, REFCOUNT, HASH_CONS) \
+  template<> \
+  struct PoolConfig<TYPE> { \
+    static constexpr const char* name = NAME; \
+    static constexpr std::size_t chunk_bits = CHUNK_BITS; \
+    using refcount_type = REFCOUNT; \
+    static constexpr bool hash_cons = HASH_CONS; \
+  };
+
+// Written for every observation and action of every NPC
+HISTORY_GAME_POOL_CONFIG(memory::MemoryEntry, "MemoryEntry", 14, SharedRefCount, false)
+
+// A new version of each for every NPC that moves or changes each tick
+// (an identity often repeats the previous version, so identities are shared)
+HISTORY_GAME_POOL_CONFIG(entity::Entity, "Entity", 12, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(npc::NPCIdentity, "NPCIdentity", 12, SharedRefCount, true)
+HISTORY_GAME_POOL_CONFIG(npc::NPC, "NPC", 12, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(memory::PerceptionBuffer, "PerceptionBuffer", 12, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(memory::PerceptionChunk, "PerceptionChunk", 12, SharedRefCount, false)
+
+// Replaced as NPCs form episodes and relationships
+HISTORY_GAME_POOL_CONFIG(action::ActionSequence, "ActionSequence", 10, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(memory::EpisodeBucket, "EpisodeBucket", 10, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(memory::EpisodeBucketChunk, "EpisodeBucketChunk", 10, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(memory::EpisodeTable, "EpisodeTable", 10, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(memory::MemoryEpisode, "MemoryEpisode", 10, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(memory::SegmentationState, "SegmentationState", 10, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(memory::WitnessedSequence, "WitnessedSequence", 10, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(object::WorldObject, "WorldObject", 10, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(relationship::Relationship, "Relationship", 10, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(relationship::RelationshipIndex, "RelationshipIndex", 10, SharedRefCount, false)
+
+// One live object per tick, retired ones may be released by the world reclaimer
+HISTORY_GAME_POOL_CONFIG(world::SimulationClock, "SimulationClock", 4, SharedRefCount, false)
+HISTORY_GAME_POOL_CONFIG(world::World, "World", 4, SharedRefCount, false)
+
+// One per layout of NPCs and objects, shared by the world versions keeping it
+HISTORY_GAME_POOL_CONFIG(world::WorldDirectory, "WorldDirectory", 4, SharedRefCount, false)
+
+#undef HISTORY_GAME_POOL_CONFIG
+
+} // namespace history_game::datamodel::pool
+
+#endif // HISTORY_GAME_DATAMODEL_POOL_POOL_CONFIG_H
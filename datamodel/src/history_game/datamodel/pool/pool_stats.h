@@ -0,0 +1,282 @@
+#ifndef HISTORY_GAME_DATAMODEL_POOL_POOL_STATS_H
+#define HISTORY_GAME_DATAMODEL_POOL_POOL_STATS_H
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_config.h>
+#include <history_game/datamodel/pool/slab_cache.h>
+#include <history_game/datamodel/pool/hash_cons.h>
+
+namespace history_game::datamodel::pool {
+
+/**
+ * Allocation counters of one managed type
+ * Threads count in their own counters and add them here in batches, so the
+ * totals lag behind by up to FLUSH_INTERVAL changes per thread, and the peak
+ * is the highest total seen when a batch was added.
+ */
+struct PoolCounters {
+  static constexpr uint32_t FLUSH_INTERVAL = 256;
+
+  const char* const name;
+  const std::size_t chunk_size;
+
+  // Adds the calling thread's pending counts
+  void (*const flush_local)();
+
+  // Slabs the type's slab cache has carved
+  std::size_t (*const slab_count)();
+
+  // Objects held in the storage's heap slots
+  std::atomic<int64_t> live{0};
+  std::atomic<int64_t> peak{0};
+
+  // Objects allocated by the storage
+  std::atomic<uint64_t> allocations{0};
+
+  // Values handed out again by hash-consing instead of being created
+  std::atomic<uint64_t> shared{0};
+
+  PoolCounters(const char* pool_name, std::size_t pool_chunk_size,
+               void (*pool_flush_local)(), std::size_t (*pool_slab_count)())
+    : name(pool_name), chunk_size(pool_chunk_size),
+      flush_local(pool_flush_local), slab_count(pool_slab_count) {}
+
+  void add(int64_t live_change, uint64_t new_allocations, uint64_t new_shares) {
+    int64_t now = live.fetch_add(live_change, std::memory_order_relaxed) + live_change;
+    allocations.fetch_add(new_allocations, std::memory_order_relaxed);
+    shared.fetch_add(new_shares, std::memory_order_relaxed);
+    int64_t previous = peak.load(std::memory_order_relaxed);
+    while (now > previous &&
+           !peak.compare_exchange_weak(previous, now, std::memory_order_relaxed)) {}
+  }
+};
+
+/**
+ * Snapshot of the counters of one managed type
+ */
+struct PoolStats {
+  const char* name;
+  std::size_t chunk_size;
+  uint64_t live;
+  uint64_t peak;
+  uint64_t allocations;
+  uint64_t shared;
+
+  // Chunks carved by the slab cache (they are not given back)
+  uint64_t chunks;
+
+  // Share of the chunk capacity holding live objects
+  float utilization() const {
+    uint64_t capacity = chunks * chunk_size;
+    return capacity ? static_cast<float>(live) / static_cast<float>(capacity) : 0.0f;
+  }
+};
+
+namespace pool_system {
+
+  struct Registry {
+    std::mutex mutex;
+    std::vector<PoolCounters*> counters;
+  };
+
+  inline Registry& getRegistry() {
+    static Registry registry;
+    return registry;
+  }
+
+  template<typename T>
+  inline void flushLocalCounts();
+
+  template<typename T>
+  inline std::size_t countSlabs() {
+    return SlabCache<T>::slabCount();
+  }
+
+  /**
+   * Counters of a managed type, registered on first use
+   */
+  template<typename T>
+  inline PoolCounters& getCounters() {
+    static PoolCounters* counters = [] {
+      static PoolCounters type_counters(
+        PoolConfig<T>::name,
+        std::size_t(1) << PoolConfig<T>::chunk_bits,
+        &flushLocalCounts<T>,
+        &countSlabs<T>
+      );
+      Registry& registry = getRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.counters.push_back(&type_counters);
+      return &type_counters;
+    }();
+    return *counters;
+  }
+
+  /**
+   * Changes to the counters of a type made by the calling thread and not yet added
+   * Trivially destructible, so it can still be used while the thread exits.
+   */
+  template<typename T>
+  struct LocalCounts {
+    int64_t live = 0;
+    uint64_t allocations = 0;
+    uint64_t shared = 0;
+    uint32_t pending = 0;
+    bool flushed_at_exit = false;
+  };
+
+  template<typename T>
+  inline LocalCounts<T>& getLocalCounts() {
+    thread_local LocalCounts<T> counts;
+    return counts;
+  }
+
+  template<typename T>
+  inline void flushLocalCounts() {
+    LocalCounts<T>& counts = getLocalCounts<T>();
+    if (counts.live || counts.allocations || counts.shared) {
+      getCounters<T>().add(counts.live, counts.allocations, counts.shared);
+    }
+    counts = LocalCounts<T>{0, 0, 0, 0, counts.flushed_at_exit};
+  }
+
+  // Adds a thread's pending counts when the thread exits
+  template<typename T>
+  struct LocalCountsFlusher {
+    ~LocalCountsFlusher() {
+      flushLocalCounts<T>();
+      getLocalCounts<T>().flushed_at_exit = true;
+    }
+  };
+
+  template<typename T>
+  inline void countChange(int64_t live_change, uint64_t new_allocations, uint64_t new_shares = 0) {
+    LocalCounts<T>& counts = getLocalCounts<T>();
+    counts.live += live_change;
+    counts.allocations += new_allocations;
+    counts.shared += new_shares;
+
+    // Register the type and the thread's flusher before the first batch
+    if (counts.pending++ == 0) {
+      getCounters<T>();
+      if (!counts.flushed_at_exit) {
+        thread_local LocalCountsFlusher<T> flusher;
+      }
+    }
+
+    // After the thread's flusher ran every change is added right away
+    if (counts.pending >= PoolCounters::FLUSH_INTERVAL || counts.flushed_at_exit) {
+      flushLocalCounts<T>();
+    }
+  }
+
+  /**
+   * Add the calling thread's pending changes to the counters of every type
+   * (for threads that stop changing counts for a while, so the totals catch up)
+   */
+  inline void flushThreadCounts() {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const PoolCounters* counters : registry.counters) {
+      counters->flush_local();
+    }
+  }
+
+  /**
+   * Snapshot of the counters of every managed type used so far
+   * (including the calling thread's pending changes)
+   */
+  inline std::vector<PoolStats> getStats() {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::vector<PoolStats> stats;
+    stats.reserve(registry.counters.size());
+    for (const PoolCounters* counters : registry.counters) {
+      counters->flush_local();
+      stats.push_back(PoolStats{
+        counters->name,
+        counters->chunk_size,
+        static_cast<uint64_t>(std::max<int64_t>(counters->live.load(std::memory_order_relaxed), 0)),
+        static_cast<uint64_t>(std::max<int64_t>(counters->peak.load(std::memory_order_relaxed), 0)),
+        counters->allocations.load(std::memory_order_relaxed),
+        counters->shared.load(std::memory_order_relaxed),
+        counters->slab_count()
+      });
+    }
+    return stats;
+  }
+
+} // namespace pool_system
+
+/**
+ * Base of managed types
+ * Allocates the objects created with new (the ones the storage holds) from
+ * per-thread slab caches and counts them; temporaries and moved-from values
+ * are not counted. Empty, so it adds nothing to the size of the type.
+ */
+template<typename T>
+struct Counted {
+  static void* operator new(std::size_t size) {
+    pool_system::countChange<T>(1, 1);
+    return size == sizeof(T) ? SlabCache<T>::allocate() : ::operator new(size);
+  }
+
+  static void operator delete(void* pointer, std::size_t size) {
+    pool_system::countChange<T>(-1, 0);
+    if (size == sizeof(T)) {
+      SlabCache<T>::deallocate(pointer);
+    } else {
+      ::operator delete(pointer);
+    }
+  }
+};
+
+/**
+ * Storage of a managed type, sized by its PoolConfig
+ * For types with hash_cons in their
+ * PoolConfig it returns the stored value equal to the new one, if there is
+ * one, instead of storing a copy.
+ */
+template<typename T>
+struct ManagedStorage
+  : cpioo::managed_entity::storage<T, PoolConfig<T>::chunk_bits, typename PoolConfig<T>::refcount_type> {
+  using base = cpioo::managed_entity::storage<T, PoolConfig<T>::chunk_bits, typename PoolConfig<T>::refcount_type>;
+  using ref_type = typename base::ref_type;
+
+  template<typename... Args>
+  static ref_type make_entity(Args&&... args) {
+    if constexpr (PoolConfig<T>::hash_cons && hash_cons_system::ENABLED) {
+      auto [ref, shared] = hash_cons_system::getTable<T, ref_type>().intern(
+        T(std::forward<Args>(args)...),
+        [](T&& value) {
+          return base::make_entity(std::move(value));
+        }
+      );
+      if (shared) {
+        pool_system::countChange<T>(0, 0, 1);
+      }
+      return ref;
+    } else {
+      return base::make_entity(std::forward<Args>(args)...);
+    }
+  }
+};
+
+/**
+ * Reference type of a managed type, usable while the type is incomplete
+ */
+template<typename T>
+using Ref = cpioo::managed_entity::reference<
+  cpioo::managed_entity::storage<T, PoolConfig<T>::chunk_bits, typename PoolConfig<T>::refcount_type>>;
+
+} // namespace history_game::datamodel::pool
+
+#endif // HISTORY_GAME_DATAMODEL_POOL_POOL_STATS_H
@@ -0,0 +1,288 @@
+#ifndef HISTORY_GAME_DATAMODEL_POOL_REF_COUNT_H
+#define HISTORY_GAME_DATAMODEL_POOL_REF_COUNT_H
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <cpioo/managed_entity.hpp>
+
+namespace history_game::datamodel::pool {
+
+/**
+ * Reference count that can be copied and dropped from any thread
+ * Every change is an atomic read-modify-write.
+ */
+class AtomicRefCount {
+public:
+  AtomicRefCount(uint32_t initial = 1) : count(initial) {}
+
+  AtomicRefCount(const AtomicRefCount&) = delete;
+  AtomicRefCount& operator=(const AtomicRefCount&) = delete;
+
+  AtomicRefCount& operator++() {
+    count.fetch_add(1, std::memory_order_relaxed);
+    return *this;
+  }
+
+  // Remaining references (0 once the last one is dropped)
+  uint32_t operator--() {
+    return count.fetch_sub(1, std::memory_order_acq_rel) - 1;
+  }
+
+private:
+  std::atomic<uint32_t> count;
+};
+
+class DeferredRefCount;
+
+namespace ref_count_system {
+
+  /**
+   * Changes to deferred counts recorded by one thread
+   */
+  struct DeferredLog {
+    std::vector<DeferredRefCount*> increments;
+    std::vector<DeferredRefCount*> decrements;
+
+    bool empty() const { return increments.empty() && decrements.empty(); }
+  };
+
+  // A thread publishes its log on its own once it holds this many changes
+  constexpr std::size_t DEFERRED_PUBLISH_SIZE = std::size_t(1) << 16;
+
+  struct DeferredQueue {
+    std::mutex mutex;
+
+    // Logs published since the last flush
+    std::vector<DeferredLog> published;
+
+    // Held while a flush changes the counts (only flushes change them)
+    std::mutex flush_mutex;
+
+    // Decrements taken by the last flush, applied by the next one
+    std::vector<DeferredRefCount*> held;
+  };
+
+  inline DeferredQueue& getDeferredQueue() {
+    // Never destroyed, references can be dropped during static destruction
+    static DeferredQueue* queue = new DeferredQueue();
+    return *queue;
+  }
+
+  // Trivially destructible, so it can still be used while the thread exits
+  struct ThreadLog {
+    DeferredLog* log;
+    bool retired;
+  };
+
+  inline void publish(ThreadLog& thread_log) {
+    if (!thread_log.log || thread_log.log->empty()) {
+      return;
+    }
+    DeferredQueue& queue = getDeferredQueue();
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.published.push_back(std::move(*thread_log.log));
+    *thread_log.log = DeferredLog{};
+  }
+
+  // Publishes a thread's log when the thread exits
+  struct ThreadLogRetirer {
+    ThreadLog* thread_log;
+
+    ~ThreadLogRetirer() {
+      publish(*thread_log);
+      delete thread_log->log;
+      thread_log->log = nullptr;
+      thread_log->retired = true;
+    }
+  };
+
+  inline ThreadLog& getThreadLog() {
+    thread_local ThreadLog thread_log{nullptr, false};
+    if (!thread_log.log && !thread_log.retired) {
+      thread_local ThreadLogRetirer retirer{&thread_log};
+      thread_log.log = new DeferredLog();
+    }
+    return thread_log;
+  }
+
+  /**
+   * Record a change to a deferred count made by the calling thread
+   * Threads that already exited publish each change right away.
+   */
+  inline void record(DeferredRefCount* count, bool increment) {
+    ThreadLog& thread_log = getThreadLog();
+    if (thread_log.retired) {
+      DeferredLog single;
+      (increment ? single.increments : single.decrements).push_back(count);
+      DeferredQueue& queue = getDeferredQueue();
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.published.push_back(std::move(single));
+      return;
+    }
+
+    DeferredLog& log = *thread_log.log;
+    (increment ? log.increments : log.decrements).push_back(count);
+    if (log.increments.size() + log.decrements.size() >= DEFERRED_PUBLISH_SIZE) {
+      publish(thread_log);
+    }
+  }
+
+  /**
+   * Hand the calling thread's recorded changes to the next flush
+   * Every thread that copies or drops references publishes before the tick
+   * it works in ends (workers when they finish their part of a phase).
+   */
+  inline void publishChanges() {
+    publish(getThreadLog());
+  }
+
+  inline bool flushChanges();
+
+} // namespace ref_count_system
+
+/**
+ * Reference count changed only at tick boundaries
+ *
+ * Copying or dropping a reference appends the count to the calling thread's
+ * log instead of changing it, so no thread writes to an object's count while
+ * the simulation runs. ref_count_system::flushChanges() applies the published
+ * logs: the increments first, then the decrements published before the
+ * previous flush. Holding the decrements back one flush means a reference
+ * copied on one thread is counted before the reference it was copied from is
+ * dropped on another, as long as every thread publishes its log once per
+ * tick. Objects whose count reaches zero are freed by the flush, on the
+ * thread running it; the references they hold are dropped there too and
+ * applied right away, since their increments were counted before.
+ *
+ * The count is the first member of the cpioo node holding the object, which
+ * is how a flush finds the object to free.
+ */
+class DeferredRefCount {
+public:
+  DeferredRefCount(uint32_t initial = 1) : count(initial) {}
+
+  DeferredRefCount(const DeferredRefCount&) = delete;
+  DeferredRefCount& operator=(const DeferredRefCount&) = delete;
+
+  DeferredRefCount& operator++() {
+    ref_count_system::record(this, true);
+    return *this;
+  }
+
+  // Never 0: the object is freed by the flush that applies the last decrement
+  uint32_t operator--() {
+    ref_count_system::record(this, false);
+    return 1;
+  }
+
+private:
+  friend bool ref_count_system::flushChanges();
+
+  using Node = cpioo::managed_entity::node<DeferredRefCount>;
+
+  // Free the object once no reference to it remains
+  static void release(DeferredRefCount* reference_count) {
+    if (--reference_count->count == 0) {
+      Node* node = reinterpret_cast<Node*>(reference_count);
+      node->destroy(node->value);
+      delete node;
+    }
+  }
+
+  // Only changed by flushes, under the flush lock
+  uint32_t count;
+};
+
+static_assert(std::is_standard_layout_v<cpioo::managed_entity::node<DeferredRefCount>> &&
+              offsetof(cpioo::managed_entity::node<DeferredRefCount>, count) == 0,
+              "DeferredRefCount must be the first member of the cpioo node");
+
+namespace ref_count_system {
+
+  /**
+   * Apply the published changes to deferred counts, freeing the objects left
+   * without references (once per tick, from any thread)
+   * @return Whether decrements are held back for the next flush
+   */
+  inline bool flushChanges() {
+    publishChanges();
+    DeferredQueue& queue = getDeferredQueue();
+    std::lock_guard<std::mutex> flush_lock(queue.flush_mutex);
+
+    std::vector<DeferredLog> taken;
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      taken.swap(queue.published);
+    }
+
+    for (const DeferredLog& log : taken) {
+      for (DeferredRefCount* count : log.increments) {
+        ++count->count;
+      }
+    }
+
+    std::vector<DeferredRefCount*> releasing;
+    releasing.swap(queue.held);
+    for (const DeferredLog& log : taken) {
+      queue.held.insert(queue.held.end(), log.decrements.begin(), log.decrements.end());
+    }
+
+    // Objects freed here drop their references on this thread, apply those too
+    ThreadLog& thread_log = getThreadLog();
+    while (!releasing.empty()) {
+      for (DeferredRefCount* count : releasing) {
+        DeferredRefCount::release(count);
+      }
+      releasing.clear();
+
+      if (thread_log.log) {
+        for (DeferredRefCount* count : thread_log.log->increments) {
+          ++count->count;
+        }
+        thread_log.log->increments.clear();
+        releasing.swap(thread_log.log->decrements);
+      }
+    }
+    return !queue.held.empty();
+  }
+
+  /**
+   * Flush until every dropped reference is applied
+   * Only while no other thread copies or drops references.
+   */
+  inline void settleChanges() {
+    while (flushChanges()) {}
+  }
+
+} // namespace ref_count_system
+
+/**
+ * Reference count of the types shared between simulation threads
+ * Selected by HISTORY_GAME_REFCOUNT (deferred by default, atomic, or plain
+ * counts that only one thread may change).
+ */
+#if defined(HISTORY_GAME_REFCOUNT_ATOMIC)
+using SharedRefCount = AtomicRefCount;
+#elif defined(HISTORY_GAME_REFCOUNT_DEFERRED)
+using SharedRefCount = DeferredRefCount;
+#else
+using SharedRefCount = uint32_t;
+#endif
+
+namespace ref_count_system {
+
+  // Whether counts are only changed by flushChanges()
+  constexpr bool DEFERRED = std::is_same_v<SharedRefCount, DeferredRefCount>;
+
+  // Whether a reference copied on one thread can be dropped on any other
+  constexpr bool RELEASE_ON_ANY_THREAD = std::is_same_v<SharedRefCount, AtomicRefCount> || DEFERRED;
+
+} // namespace ref_count_system
+
+} // namespace history_game::datamodel::pool
+
+#endif // HISTORY_GAME_DATAMODEL_POOL_REF_COUNT_H
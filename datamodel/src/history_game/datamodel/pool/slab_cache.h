@@ -0,0 +1,203 @@
+#ifndef HISTORY_GAME_DATAMODEL_POOL_SLAB_CACHE_H
+#define HISTORY_GAME_DATAMODEL_POOL_SLAB_CACHE_H
+
+#include <mutex>
+#include <new>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <history_game/datamodel/pool/pool_config.h>
+
+namespace history_game::datamodel::pool {
+
+/**
+ * Per-thread caches of free slots for objects of one type
+ *
+ * Each thread keeps two batches of free slots and allocates and frees from
+ * them without locking. Only when both are empty (or full) does it take a
+ * full batch from (or give one back to) the shared depot, which carves new
+ * slabs of 2^chunk_bits slots when it runs out. Slots freed by a thread other
+ * than the one that allocated them go to the freeing thread's cache. Slabs
+ * are kept for the life of the program.
+ */
+template<typename T>
+class SlabCache {
+public:
+  static constexpr std::size_t BATCH = 64;
+
+  static void* allocate() {
+    ThreadCache& cache = getThreadCache();
+    if (cache.retired) {
+      return getDepot().allocateOne();
+    }
+
+    if (!cache.loaded.head) {
+      if (cache.previous.count) {
+        std::swap(cache.loaded, cache.previous);
+      } else {
+        cache.loaded = getDepot().takeBatch();
+      }
+    }
+
+    FreeSlot* slot = cache.loaded.head;
+    cache.loaded.head = slot->next;
+    cache.loaded.count--;
+    return slot;
+  }
+
+  static void deallocate(void* pointer) {
+    FreeSlot* slot = static_cast<FreeSlot*>(pointer);
+    ThreadCache& cache = getThreadCache();
+    if (cache.retired) {
+      getDepot().freeOne(slot);
+      return;
+    }
+
+    if (cache.loaded.count == BATCH) {
+      if (cache.previous.count == BATCH) {
+        getDepot().giveBatch(cache.previous);
+      }
+      cache.previous = cache.loaded;
+      cache.loaded = Batch{};
+    }
+
+    slot->next = cache.loaded.head;
+    cache.loaded.head = slot;
+    cache.loaded.count++;
+  }
+
+  // Slabs carved so far (each holds 2^chunk_bits slots)
+  static std::size_t slabCount() {
+    return getDepot().slabCount();
+  }
+
+  // Size of the slots handed out
+  static constexpr std::size_t slotSize() {
+    return (std::max(sizeof(T), sizeof(FreeSlot)) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  }
+
+private:
+  struct FreeSlot {
+    FreeSlot* next;
+  };
+
+  struct Batch {
+    FreeSlot* head = nullptr;
+    std::size_t count = 0;
+  };
+
+  static constexpr std::size_t ALIGNMENT = std::max(alignof(T), alignof(FreeSlot));
+  static constexpr std::size_t SLAB_SLOTS = std::size_t(1) << PoolConfig<T>::chunk_bits;
+
+  class Depot {
+  public:
+    Batch takeBatch() {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (full_batches.empty()) {
+        carveSlab();
+      }
+      Batch batch = full_batches.back();
+      full_batches.pop_back();
+      return batch;
+    }
+
+    void giveBatch(const Batch& batch) {
+      std::lock_guard<std::mutex> lock(mutex);
+      full_batches.push_back(batch);
+    }
+
+    void* allocateOne() {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!loose.head) {
+        if (full_batches.empty()) {
+          carveSlab();
+        }
+        loose = full_batches.back();
+        full_batches.pop_back();
+      }
+      FreeSlot* slot = loose.head;
+      loose.head = slot->next;
+      loose.count--;
+      return slot;
+    }
+
+    void freeOne(FreeSlot* slot) {
+      std::lock_guard<std::mutex> lock(mutex);
+      slot->next = loose.head;
+      loose.head = slot;
+      if (++loose.count == BATCH) {
+        full_batches.push_back(loose);
+        loose = Batch{};
+      }
+    }
+
+    std::size_t slabCount() {
+      std::lock_guard<std::mutex> lock(mutex);
+      return slabs;
+    }
+
+  private:
+    void carveSlab() {
+      slabs++;
+      std::byte* slab = static_cast<std::byte*>(
+        ::operator new(SLAB_SLOTS * slotSize(), std::align_val_t(ALIGNMENT)));
+      for (std::size_t first = 0; first < SLAB_SLOTS; first += BATCH) {
+        Batch batch;
+        std::size_t last = std::min(first + BATCH, SLAB_SLOTS);
+        for (std::size_t i = last; i-- > first;) {
+          FreeSlot* slot = reinterpret_cast<FreeSlot*>(slab + i * slotSize());
+          slot->next = batch.head;
+          batch.head = slot;
+          batch.count++;
+        }
+        full_batches.push_back(batch);
+      }
+    }
+
+    std::mutex mutex;
+    std::vector<Batch> full_batches;
+    Batch loose;
+    std::size_t slabs = 0;
+  };
+
+  // Trivially destructible, so it can still be used while the thread exits
+  struct ThreadCache {
+    Batch loaded;
+    Batch previous;
+    bool retired = false;
+  };
+
+  // Gives a thread's batches back to the depot when the thread exits
+  struct ThreadCacheRetirer {
+    ThreadCache* cache;
+
+    ~ThreadCacheRetirer() {
+      Depot& depot = getDepot();
+      for (Batch* batch : {&cache->loaded, &cache->previous}) {
+        while (FreeSlot* slot = batch->head) {
+          batch->head = slot->next;
+          depot.freeOne(slot);
+        }
+        batch->count = 0;
+      }
+      cache->retired = true;
+    }
+  };
+
+  static Depot& getDepot() {
+    // Never destroyed, objects can outlive static destruction
+    static Depot* depot = new Depot();
+    return *depot;
+  }
+
+  static ThreadCache& getThreadCache() {
+    thread_local ThreadCache cache;
+    thread_local ThreadCacheRetirer retirer{&cache};
+    return cache;
+  }
+};
+
+} // namespace history_game::datamodel::pool
+
+#endif // HISTORY_GAME_DATAMODEL_POOL_SLAB_CACHE_H
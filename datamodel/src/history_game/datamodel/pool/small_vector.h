@@ -0,0 +1,201 @@
+#ifndef HISTORY_GAME_DATAMODEL_POOL_SMALL_VECTOR_H
+#define HISTORY_GAME_DATAMODEL_POOL_SMALL_VECTOR_H
+
+#include <new>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+
+namespace history_game::datamodel::pool {
+
+/**
+ * Vector keeping up to N elements inline
+ * For short collections inside datamodel objects: as long as they fit in
+ * the inline slots they cost no allocation of their own. Past that they
+ * move to the heap like a std::vector.
+ */
+template<typename T, std::size_t N>
+class SmallVector {
+public:
+  static_assert(N > 0, "SmallVector needs at least one inline slot");
+
+  using value_type = T;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  static constexpr std::size_t INLINE_CAPACITY = N;
+
+  SmallVector() {}
+
+  SmallVector(std::initializer_list<T> values) {
+    reserve(values.size());
+    for (const T& value : values) {
+      push_back(value);
+    }
+  }
+
+  SmallVector(const SmallVector& other) {
+    reserve(other.count);
+    for (const T& value : other) {
+      push_back(value);
+    }
+  }
+
+  SmallVector(SmallVector&& other) noexcept {
+    takeFrom(other);
+  }
+
+  SmallVector& operator=(const SmallVector& other) {
+    if (this != &other) {
+      SmallVector copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  SmallVector& operator=(SmallVector&& other) noexcept {
+    if (this != &other) {
+      release();
+      takeFrom(other);
+    }
+    return *this;
+  }
+
+  ~SmallVector() {
+    release();
+  }
+
+  template<typename... Args>
+  T& emplace_back(Args&&... args) {
+    if (count < capacity()) {
+      T* slot = new (data() + count) T(std::forward<Args>(args)...);
+      count++;
+      return *slot;
+    }
+
+    // Build the new element before moving the old ones, args may refer to them
+    std::size_t new_capacity = capacity() * 2;
+    T* elements = std::allocator<T>().allocate(new_capacity);
+    T* slot;
+    try {
+      slot = new (elements + count) T(std::forward<Args>(args)...);
+    } catch (...) {
+      std::allocator<T>().deallocate(elements, new_capacity);
+      throw;
+    }
+    moveTo(elements, new_capacity);
+    count++;
+    return *slot;
+  }
+
+  void push_back(const T& value) {
+    emplace_back(value);
+  }
+
+  void push_back(T&& value) {
+    emplace_back(std::move(value));
+  }
+
+  void reserve(std::size_t wanted) {
+    if (wanted > capacity()) {
+      grow(wanted);
+    }
+  }
+
+  void clear() {
+    std::destroy_n(data(), count);
+    count = 0;
+  }
+
+  T* data() {
+    return heap_capacity ? storage.heap : inlineData();
+  }
+
+  const T* data() const {
+    return heap_capacity ? storage.heap : inlineData();
+  }
+
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  std::size_t capacity() const { return heap_capacity ? heap_capacity : N; }
+
+  // Elements held on the heap (none while they fit inline)
+  std::size_t heapCapacity() const { return heap_capacity; }
+
+  T& operator[](std::size_t index) { return data()[index]; }
+  const T& operator[](std::size_t index) const { return data()[index]; }
+
+  T& back() { return data()[count - 1]; }
+  const T& back() const { return data()[count - 1]; }
+
+  iterator begin() { return data(); }
+  iterator end() { return data() + count; }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + count; }
+
+private:
+  T* inlineData() {
+    return std::launder(reinterpret_cast<T*>(storage.buffer));
+  }
+
+  const T* inlineData() const {
+    return std::launder(reinterpret_cast<const T*>(storage.buffer));
+  }
+
+  void grow(std::size_t new_capacity) {
+    moveTo(std::allocator<T>().allocate(new_capacity), new_capacity);
+  }
+
+  // Moves the elements to allocated storage for new_capacity of them
+  void moveTo(T* elements, std::size_t new_capacity) {
+    T* old_elements = data();
+    std::uninitialized_move_n(old_elements, count, elements);
+    std::destroy_n(old_elements, count);
+    if (heap_capacity) {
+      std::allocator<T>().deallocate(old_elements, heap_capacity);
+    }
+    storage.heap = elements;
+    heap_capacity = static_cast<uint32_t>(new_capacity);
+  }
+
+  // Takes the elements of other, leaving it empty (this must hold none)
+  void takeFrom(SmallVector& other) {
+    if (other.heap_capacity) {
+      storage.heap = other.storage.heap;
+      heap_capacity = other.heap_capacity;
+      count = other.count;
+      other.heap_capacity = 0;
+      other.count = 0;
+      return;
+    }
+
+    std::uninitialized_move_n(other.inlineData(), other.count, inlineData());
+    count = other.count;
+    other.clear();
+  }
+
+  void release() {
+    clear();
+    if (heap_capacity) {
+      std::allocator<T>().deallocate(storage.heap, heap_capacity);
+      heap_capacity = 0;
+    }
+  }
+
+  union Storage {
+    T* heap;
+    alignas(T) std::byte buffer[N * sizeof(T)];
+  } storage;
+
+  uint32_t count = 0;
+
+  // Zero while the elements are inline
+  uint32_t heap_capacity = 0;
+};
+
+} // namespace history_game::datamodel::pool
+
+#endif // HISTORY_GAME_DATAMODEL_POOL_SMALL_VECTOR_H
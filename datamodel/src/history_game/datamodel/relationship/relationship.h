@@ -1,9 +1,12 @@
 #ifndef HISTORY_GAME_DATAMODEL_RELATIONSHIP_RELATIONSHIP_H
 #define HISTORY_GAME_DATAMODEL_RELATIONSHIP_RELATIONSHIP_H
 
+#include <cmath>
 #include <cstdint>
 #include <vector>
 #include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
+#include <history_game/datamodel/pool/small_vector.h>
 #include <history_game/datamodel/entity/entity.h>
 #include <history_game/datamodel/npc/drive.h>
 #include <history_game/datamodel/relationship/relationship_target.h>
@@ -14,8 +17,8 @@ namespace history_game::datamodel::relationship {
  * Represents emotional connection history for a drive
  */
 struct AffectiveTrace {
-  const npc::DriveType drive_type;
-  const float value;
+  npc::DriveType drive_type;
+  float value;
   
   // Constructor
   template<npc::DriveTypeConcept T>
@@ -23,31 +26,36 @@ struct AffectiveTrace {
     : drive_type(type), value(trace_value) {}
 };
 
+// Traces are kept for the drives with a non-zero value: a sample run had
+// 64% of relationships with none, 25% with one, 11% with two and almost
+// none with three, so three fit inline
+using AffectiveTraces = pool::SmallVector<AffectiveTrace, 3>;
+
 /**
  * Represents one NPC's relationship with any target
  * (another NPC, a world object, or a location)
  */
-struct Relationship {
+struct Relationship : pool::Counted<Relationship> {
   // The target of this relationship (can be entity, object, or location)
-  const RelationshipTarget target;
+  RelationshipTarget target;
   
   // Familiarity level (exposure)
-  const float familiarity;
+  float familiarity;
   
   // Emotional impact history per drive
-  const std::vector<AffectiveTrace> affective_traces;
+  AffectiveTraces affective_traces;
   
   // Last interaction timestamp
-  const uint64_t last_interaction;
+  uint64_t last_interaction;
   
   // Number of interactions with this target
-  const uint32_t interaction_count;
+  uint32_t interaction_count;
   
   // Constructor
   Relationship(
     RelationshipTarget relationship_target,
     float familiarity_level,
-    std::vector<AffectiveTrace> traces,
+    AffectiveTraces traces,
     uint64_t interaction_time,
     uint32_t interactions
   ) : target(std::move(relationship_target)),
@@ -57,11 +65,84 @@ struct Relationship {
       interaction_count(interactions) {}
       
   // Define storage type
-  using storage = cpioo::managed_entity::storage<Relationship, 10, uint32_t>;
+  using storage = pool::ManagedStorage<Relationship>;
   using ref_type = storage::ref_type;
 };
 
+/**
+ * How relationships fade while there is no interaction
+ * Decay is not stored; it is applied to the stored values whenever they are
+ * read, counting whole periods of absolute time since the last interaction.
+ * Every read between two period boundaries therefore sees the same values.
+ */
+struct RelationshipDecay {
+  // Ticks between decay steps
+  uint64_t period;
+  
+  // Ticks for familiarity to halve
+  float familiarity_half_life;
+  
+  // Ticks for affective traces to halve
+  float trace_half_life;
+  
+  // Constructor with default values
+  RelationshipDecay(
+    uint64_t decay_period = 50,
+    float familiarity_half = 2000.0f,
+    float trace_half = 1000.0f
+  ) : period(decay_period),
+      familiarity_half_life(familiarity_half),
+      trace_half_life(trace_half) {}
+};
+
 namespace relationship_system {
+  /**
+   * Fraction of a value left after decaying from last_interaction to current_time
+   */
+  inline float getDecayFactor(
+    uint64_t last_interaction,
+    uint64_t current_time,
+    float half_life,
+    const RelationshipDecay& decay
+  ) {
+    if (current_time <= last_interaction || half_life <= 0.0f) {
+      return 1.0f;
+    }
+    
+    uint64_t elapsed = (current_time / decay.period - last_interaction / decay.period) * decay.period;
+    return std::exp2(-static_cast<float>(elapsed) / half_life);
+  }
+  
+  /**
+   * Familiarity of a relationship at a given time
+   */
+  inline float getFamiliarity(
+    const Relationship& relationship,
+    uint64_t current_time,
+    const RelationshipDecay& decay
+  ) {
+    return relationship.familiarity * getDecayFactor(
+      relationship.last_interaction, current_time, decay.familiarity_half_life, decay);
+  }
+  
+  /**
+   * Affective trace of a relationship for a drive at a given time (0 if none)
+   */
+  inline float getAffectiveTrace(
+    const Relationship& relationship,
+    const npc::DriveType& drive_type,
+    uint64_t current_time,
+    const RelationshipDecay& decay
+  ) {
+    for (const auto& trace : relationship.affective_traces) {
+      if (trace.drive_type.index() == drive_type.index()) {
+        return trace.value * getDecayFactor(
+          relationship.last_interaction, current_time, decay.trace_half_life, decay);
+      }
+    }
+    return 0.0f;
+  }
+  
   /**
    * Find a relationship with a specific target among a collection of relationships
    */
@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/datamodel/relationship/relationship_store.cpp
+#include <history_game/datamodel/relationship/relationship_store.h>
+
+namespace history_game::datamodel::relationship {
+// Empty implementation file
+}
\ No newline at end of file
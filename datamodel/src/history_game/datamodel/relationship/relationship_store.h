@@ -0,0 +1,273 @@
+#ifndef HISTORY_GAME_DATAMODEL_RELATIONSHIP_RELATIONSHIP_STORE_H
+#define HISTORY_GAME_DATAMODEL_RELATIONSHIP_RELATIONSHIP_STORE_H
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <unordered_map>
+#include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
+#include <history_game/datamodel/world/position.h>
+#include <history_game/datamodel/entity/entity.h>
+#include <history_game/datamodel/entity/entity_handle.h>
+#include <history_game/datamodel/object/object.h>
+#include <history_game/datamodel/relationship/relationship.h>
+#include <history_game/datamodel/relationship/relationship_target.h>
+
+namespace history_game::datamodel::relationship {
+
+/**
+ * Lookup structures over a fixed list of relationships
+ * Entity and object targets are hashed by handle. Location targets are
+ * registered in every cell of a uniform grid that their radius overlaps;
+ * locations too large for the grid are kept apart and always checked.
+ */
+struct RelationshipIndex : pool::Counted<RelationshipIndex> {
+  // Side of the grid cells used for location targets
+  static constexpr float CELL_SIZE = 32.0f;
+
+  // Locations overlapping more cells than this on a side are not put in the grid
+  static constexpr int32_t MAX_CELLS_PER_SIDE = 8;
+
+  // The relationships, in their original order
+  std::vector<Relationship::ref_type> relationships;
+
+  // Position of the first relationship with each entity or object (by handle)
+  std::unordered_map<entity::EntityHandle, size_t> by_target;
+
+  // Positions of the location relationships overlapping each grid cell, in order
+  std::unordered_map<uint64_t, std::vector<size_t>> location_cells;
+
+  // Positions of the location relationships too large for the grid, in order
+  std::vector<size_t> wide_locations;
+
+  // Constructor
+  RelationshipIndex(
+    std::vector<Relationship::ref_type> indexed_relationships,
+    std::unordered_map<entity::EntityHandle, size_t> target_positions,
+    std::unordered_map<uint64_t, std::vector<size_t>> cells,
+    std::vector<size_t> wide
+  ) : relationships(std::move(indexed_relationships)),
+      by_target(std::move(target_positions)),
+      location_cells(std::move(cells)),
+      wide_locations(std::move(wide)) {}
+
+  // Define storage type
+  using storage = pool::ManagedStorage<RelationshipIndex>;
+  using ref_type = storage::ref_type;
+};
+
+namespace relationship_store_system {
+
+  /**
+   * Handle of an entity or object target (the same for all of its versions)
+   */
+  inline entity::EntityHandle getHandle(const entity::Entity::ref_type& entity) {
+    return entity->handle;
+  }
+
+  inline entity::EntityHandle getHandle(const object::WorldObject::ref_type& object) {
+    return object->entity->handle;
+  }
+
+  inline entity::EntityHandle getHandle(entity::EntityHandle handle) {
+    return handle;
+  }
+
+  /**
+   * Grid cell coordinate of a world coordinate
+   */
+  inline int32_t getCell(float coordinate) {
+    return static_cast<int32_t>(std::floor(coordinate / RelationshipIndex::CELL_SIZE));
+  }
+
+  /**
+   * Key of a grid cell
+   */
+  inline uint64_t getCellKey(int32_t x, int32_t y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+  }
+
+  /**
+   * Build the index over a list of relationships
+   */
+  inline RelationshipIndex::ref_type buildIndex(std::vector<Relationship::ref_type> relationships) {
+    std::unordered_map<entity::EntityHandle, size_t> by_target;
+    std::unordered_map<uint64_t, std::vector<size_t>> location_cells;
+    std::vector<size_t> wide_locations;
+
+    for (size_t i = 0; i < relationships.size(); ++i) {
+      const RelationshipTarget& target = relationships[i]->target;
+
+      if (const auto* entity = std::get_if<entity::Entity::ref_type>(&target)) {
+        by_target.emplace(getHandle(*entity), i);
+      } else if (const auto* object = std::get_if<object::WorldObject::ref_type>(&target)) {
+        by_target.emplace(getHandle(*object), i);
+      } else {
+        const LocationPoint& location = std::get<LocationPoint>(target);
+        int32_t min_x = getCell(location.position.x - location.radius);
+        int32_t max_x = getCell(location.position.x + location.radius);
+        int32_t min_y = getCell(location.position.y - location.radius);
+        int32_t max_y = getCell(location.position.y + location.radius);
+
+        if (max_x - min_x >= RelationshipIndex::MAX_CELLS_PER_SIDE ||
+            max_y - min_y >= RelationshipIndex::MAX_CELLS_PER_SIDE) {
+          wide_locations.push_back(i);
+          continue;
+        }
+
+        for (int32_t x = min_x; x <= max_x; ++x) {
+          for (int32_t y = min_y; y <= max_y; ++y) {
+            location_cells[getCellKey(x, y)].push_back(i);
+          }
+        }
+      }
+    }
+
+    RelationshipIndex index(
+      std::move(relationships),
+      std::move(by_target),
+      std::move(location_cells),
+      std::move(wide_locations)
+    );
+    return RelationshipIndex::storage::make_entity(std::move(index));
+  }
+
+} // namespace relationship_store_system
+
+/**
+ * An NPC's relationships
+ * Keeps the relationships in order together with an index for finding them
+ * by target. Copying the store only copies a reference to the index, so every
+ * version of an NPC with the same relationships shares it.
+ */
+struct RelationshipStore {
+  // The indexed relationships (none while the store is empty)
+  std::optional<RelationshipIndex::ref_type> index;
+
+  // Constructor for an empty store
+  RelationshipStore() : index(std::nullopt) {}
+
+  // Constructor from a list of relationships
+  RelationshipStore(std::vector<Relationship::ref_type> relationships)
+    : index(relationships.empty() ?
+        std::nullopt :
+        std::optional<RelationshipIndex::ref_type>(
+          relationship_store_system::buildIndex(std::move(relationships)))) {}
+
+  // All relationships, in their original order
+  const std::vector<Relationship::ref_type>& all() const {
+    static const std::vector<Relationship::ref_type> empty_list;
+    return index ? index.value()->relationships : empty_list;
+  }
+
+  size_t size() const { return all().size(); }
+  bool empty() const { return !index; }
+
+  std::vector<Relationship::ref_type>::const_iterator begin() const { return all().begin(); }
+  std::vector<Relationship::ref_type>::const_iterator end() const { return all().end(); }
+};
+
+namespace relationship_system {
+
+  /**
+   * Find the relationship with an entity or object (by handle)
+   */
+  template<typename T>
+  inline std::optional<Relationship::ref_type> findRelationship(
+    const RelationshipStore& relationships,
+    const T& target_to_find
+  ) {
+    if (!relationships.index) {
+      return std::nullopt;
+    }
+
+    const auto& index = relationships.index.value();
+    auto it = index->by_target.find(relationship_store_system::getHandle(target_to_find));
+    if (it == index->by_target.end()) {
+      return std::nullopt;
+    }
+    return index->relationships[it->second];
+  }
+
+  /**
+   * Find the first location relationship that contains the given position
+   */
+  inline std::optional<Relationship::ref_type> findLocationRelationship(
+    const RelationshipStore& relationships,
+    const world::Position& position
+  ) {
+    if (!relationships.index) {
+      return std::nullopt;
+    }
+
+    const auto& index = relationships.index.value();
+    size_t found = index->relationships.size();
+
+    auto contains = [&index, &position](size_t i) {
+      return std::get<LocationPoint>(index->relationships[i]->target).contains(position);
+    };
+
+    // Candidates are in order, so the first match of each list is its earliest
+    auto cell = index->location_cells.find(relationship_store_system::getCellKey(
+      relationship_store_system::getCell(position.x),
+      relationship_store_system::getCell(position.y)
+    ));
+    if (cell != index->location_cells.end()) {
+      for (size_t i : cell->second) {
+        if (contains(i)) {
+          found = i;
+          break;
+        }
+      }
+    }
+
+    for (size_t i : index->wide_locations) {
+      if (i >= found) {
+        break;
+      }
+      if (contains(i)) {
+        found = i;
+        break;
+      }
+    }
+
+    if (found == index->relationships.size()) {
+      return std::nullopt;
+    }
+    return index->relationships[found];
+  }
+
+  /**
+   * Check if an NPC is familiar with a specific target
+   */
+  template<typename T>
+  inline bool isFamiliarWith(
+    const RelationshipStore& relationships,
+    const T& target,
+    float familiarity_threshold = 0.5f
+  ) {
+    auto rel = findRelationship(relationships, target);
+    return rel && rel.value()->familiarity >= familiarity_threshold;
+  }
+
+  /**
+   * Check if an NPC is familiar with a location
+   */
+  inline bool isFamiliarWithLocation(
+    const RelationshipStore& relationships,
+    const world::Position& position,
+    float familiarity_threshold = 0.5f
+  ) {
+    auto rel = findLocationRelationship(relationships, position);
+    return rel && rel.value()->familiarity >= familiarity_threshold;
+  }
+
+} // namespace relationship_system
+
+} // namespace history_game::datamodel::relationship
+
+#endif // HISTORY_GAME_DATAMODEL_RELATIONSHIP_RELATIONSHIP_STORE_H
@@ -14,8 +14,8 @@ namespace history_game::datamodel::relationship {
  * - A location
  */
 struct LocationPoint {
-  const world::Position position;
-  const float radius;
+  world::Position position;
+  float radius;
   
   LocationPoint(world::Position pos, float rad) : position(pos), radius(rad) {}
   
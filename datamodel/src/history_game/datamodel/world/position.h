@@ -8,8 +8,8 @@ namespace history_game::datamodel::world {
  * Immutable data structure
  */
 struct Position {
-  const float x;
-  const float y;
+  float x;
+  float y;
   
   // Constructor
   Position(float x_pos, float y_pos) : x(x_pos), y(y_pos) {}
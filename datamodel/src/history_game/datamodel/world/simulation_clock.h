@@ -4,21 +4,22 @@
 #include <cstdint>
 #include <string>
 #include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
 
 namespace history_game::datamodel::world {
 
 /**
  * Manages simulation time and generational tracking
  */
-struct SimulationClock {
+struct SimulationClock : pool::Counted<SimulationClock> {
   // Current tick count
-  const uint64_t current_tick;
+  uint64_t current_tick;
   
   // Current generation number
-  const uint32_t current_generation;
+  uint32_t current_generation;
   
   // Ticks per generation
-  const uint32_t ticks_per_generation;
+  uint32_t ticks_per_generation;
   
   // Constructor
   SimulationClock(
@@ -30,7 +31,7 @@ struct SimulationClock {
       ticks_per_generation(generation_length) {}
       
   // Define storage type
-  using storage = cpioo::managed_entity::storage<SimulationClock, 4, uint16_t>;
+  using storage = pool::ManagedStorage<SimulationClock>;
   using ref_type = storage::ref_type;
 };
 
@@ -2,41 +2,108 @@
 #define HISTORY_GAME_DATAMODEL_WORLD_WORLD_H
 
 #include <vector>
+#include <cstdint>
+#include <algorithm>
 #include <unordered_map>
 #include <string>
 #include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
 #include <history_game/datamodel/entity/entity.h>
+#include <history_game/datamodel/entity/entity_handle.h>
 #include <history_game/datamodel/npc/npc.h>
 #include <history_game/datamodel/npc/npc_identity.h>
 #include <history_game/datamodel/object/object.h>
+#include <history_game/datamodel/memory/memory_entry.h>
 #include <history_game/datamodel/world/simulation_clock.h>
+#include <history_game/datamodel/world/world_directory.h>
 
 namespace history_game::datamodel::world {
 
 /**
  * Structure that represents the world and manages all entities in the simulation
+ * Its members are only set by the constructors, which also build (or reuse)
+ * the directory, so the directory always matches the NPCs and objects.
  */
-struct World {
+struct World : pool::Counted<World> {
+private:
   // Simulation time tracking
-  const SimulationClock::ref_type clock;
+  SimulationClock::ref_type clock;
   
   // All NPCs in the world
-  const std::vector<npc::NPC::ref_type> npcs;
+  std::vector<npc::NPC::ref_type> npcs;
   
   // All objects in the world
-  const std::vector<object::WorldObject::ref_type> objects;
+  std::vector<object::WorldObject::ref_type> objects;
   
+  // Actions executed in the current tick, one shared record per acting NPC
+  std::vector<memory::MemoryEntry::ref_type> events;
+  
+  // Where each entity is in npcs or objects, shared by versions with the same layout
+  WorldDirectory::ref_type directory;
+  
+public:
   // Constructor
   World(
     const SimulationClock::ref_type& simulation_clock,
     std::vector<npc::NPC::ref_type> world_npcs,
-    std::vector<object::WorldObject::ref_type> world_objects
+    std::vector<object::WorldObject::ref_type> world_objects,
+    std::vector<memory::MemoryEntry::ref_type> world_events = {}
+  ) : clock(simulation_clock),
+      npcs(std::move(world_npcs)),
+      objects(std::move(world_objects)),
+      events(std::move(world_events)),
+      directory(world_directory_system::build(npcs, objects)) {}
+  
+  // Constructor for the next version of a world, keeping its directory if
+  // the NPCs and objects are still where it says
+  World(
+    const World& previous,
+    const SimulationClock::ref_type& simulation_clock,
+    std::vector<npc::NPC::ref_type> world_npcs,
+    std::vector<object::WorldObject::ref_type> world_objects,
+    std::vector<memory::MemoryEntry::ref_type> world_events = {}
   ) : clock(simulation_clock),
       npcs(std::move(world_npcs)),
-      objects(std::move(world_objects)) {}
+      objects(std::move(world_objects)),
+      events(std::move(world_events)),
+      directory(world_directory_system::reuse(previous.directory, npcs, objects)) {}
+  
+  const SimulationClock::ref_type& getClock() const { return clock; }
+  const std::vector<npc::NPC::ref_type>& getNPCs() const { return npcs; }
+  const std::vector<object::WorldObject::ref_type>& getObjects() const { return objects; }
+  const std::vector<memory::MemoryEntry::ref_type>& getEvents() const { return events; }
+  const WorldDirectory::ref_type& getDirectory() const { return directory; }
+  
+  /**
+   * Current version of the NPC with a handle, or nullptr if it is not in this world
+   */
+  const npc::NPC::ref_type* findNPC(entity::EntityHandle handle) const {
+    const WorldDirectory::Entry* entry = directory->find(handle);
+    return entry && entry->is_npc ? &npcs[entry->position] : nullptr;
+  }
+  
+  /**
+   * Current version of the object with a handle, or nullptr if it is not in this world
+   */
+  const object::WorldObject::ref_type* findObject(entity::EntityHandle handle) const {
+    const WorldDirectory::Entry* entry = directory->find(handle);
+    return entry && !entry->is_npc ? &objects[entry->position] : nullptr;
+  }
+  
+  /**
+   * Current version of the entity (of an NPC or an object) with a handle,
+   * or nullptr if it is not in this world
+   */
+  const entity::Entity::ref_type* findEntity(entity::EntityHandle handle) const {
+    const WorldDirectory::Entry* entry = directory->find(handle);
+    if (!entry) {
+      return nullptr;
+    }
+    return entry->is_npc ? &npcs[entry->position]->getIdentity()->entity : &objects[entry->position]->entity;
+  }
       
   // Define storage type
-  using storage = cpioo::managed_entity::storage<World, 4, uint16_t>;
+  using storage = pool::ManagedStorage<World>;
   using ref_type = storage::ref_type;
 };
 
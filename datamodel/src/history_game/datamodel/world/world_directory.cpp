@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/datamodel/world/world_directory.cpp
+#include <history_game/datamodel/world/world_directory.h>
+
+namespace history_game::datamodel::world {
+// Empty implementation file
+}
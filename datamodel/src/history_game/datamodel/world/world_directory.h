@@ -0,0 +1,127 @@
+#ifndef HISTORY_GAME_DATAMODEL_WORLD_WORLD_DIRECTORY_H
+#define HISTORY_GAME_DATAMODEL_WORLD_WORLD_DIRECTORY_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <cpioo/managed_entity.hpp>
+#include <history_game/datamodel/pool/pool_stats.h>
+#include <history_game/datamodel/entity/entity_handle.h>
+#include <history_game/datamodel/npc/npc.h>
+#include <history_game/datamodel/object/object.h>
+
+namespace history_game::datamodel::world {
+
+/**
+ * Where each entity of a world is in its npcs or objects, indexed by handle slot
+ *
+ * Built for one layout of NPCs and objects and shared by every world version
+ * keeping that layout, so the versions a tick makes without anyone arriving,
+ * leaving or moving in the vectors build it only once. Sized by the highest
+ * handle slot in use, which stays close to the number of live entities since
+ * the simulation's registry reuses the slots of the ones that left.
+ */
+struct WorldDirectory : pool::Counted<WorldDirectory> {
+  struct Entry {
+    entity::EntityHandle handle;
+    uint32_t position = 0;
+    bool is_npc = false;
+  };
+  
+  const std::vector<Entry> entries;
+  const size_t npc_count;
+  const size_t object_count;
+  
+  WorldDirectory(std::vector<Entry> directory_entries, size_t npcs, size_t objects)
+    : entries(std::move(directory_entries)), npc_count(npcs), object_count(objects) {}
+  
+  /**
+   * Entry of the entity with a handle, or nullptr if it is not in the world
+   */
+  const Entry* find(entity::EntityHandle handle) const {
+    if (!handle.isValid() || handle.index() >= entries.size()) {
+      return nullptr;
+    }
+    const Entry& entry = entries[handle.index()];
+    return entry.handle == handle ? &entry : nullptr;
+  }
+  
+  /**
+   * Whether the directory describes these NPCs and objects, at these positions
+   */
+  bool matches(
+    const std::vector<npc::NPC::ref_type>& npcs,
+    const std::vector<object::WorldObject::ref_type>& objects
+  ) const {
+    if (npcs.size() != npc_count || objects.size() != object_count) {
+      return false;
+    }
+    for (size_t i = 0; i < npcs.size(); ++i) {
+      const Entry* entry = find(npcs[i]->getIdentity()->entity->handle);
+      if (!entry || !entry->is_npc || entry->position != i) {
+        return false;
+      }
+    }
+    for (size_t i = 0; i < objects.size(); ++i) {
+      const Entry* entry = find(objects[i]->entity->handle);
+      if (!entry || entry->is_npc || entry->position != i) {
+        return false;
+      }
+    }
+    return true;
+  }
+  
+  // Define storage type
+  using storage = pool::ManagedStorage<WorldDirectory>;
+  using ref_type = storage::ref_type;
+};
+
+namespace world_directory_system {
+
+  /**
+   * Directory of a set of NPCs and objects
+   */
+  inline WorldDirectory::ref_type build(
+    const std::vector<npc::NPC::ref_type>& npcs,
+    const std::vector<object::WorldObject::ref_type>& objects
+  ) {
+    uint32_t max_index = 0;
+    for (const auto& npc : npcs) {
+      max_index = std::max(max_index, npc->getIdentity()->entity->handle.index());
+    }
+    for (const auto& object : objects) {
+      max_index = std::max(max_index, object->entity->handle.index());
+    }
+    
+    std::vector<WorldDirectory::Entry> entries(npcs.empty() && objects.empty() ? 0 : max_index + 1);
+    for (size_t i = 0; i < npcs.size(); ++i) {
+      entity::EntityHandle handle = npcs[i]->getIdentity()->entity->handle;
+      entries[handle.index()] = WorldDirectory::Entry{handle, static_cast<uint32_t>(i), true};
+    }
+    for (size_t i = 0; i < objects.size(); ++i) {
+      entity::EntityHandle handle = objects[i]->entity->handle;
+      entries[handle.index()] = WorldDirectory::Entry{handle, static_cast<uint32_t>(i), false};
+    }
+    return WorldDirectory::storage::make_entity(std::move(entries), npcs.size(), objects.size());
+  }
+
+  /**
+   * The previous version's directory if it still describes the NPCs and objects, else a new one
+   */
+  inline WorldDirectory::ref_type reuse(
+    const WorldDirectory::ref_type& previous,
+    const std::vector<npc::NPC::ref_type>& npcs,
+    const std::vector<object::WorldObject::ref_type>& objects
+  ) {
+    if (previous->matches(npcs, objects)) {
+      return previous;
+    }
+    return build(npcs, objects);
+  }
+
+} // namespace world_directory_system
+
+} // namespace history_game::datamodel::world
+
+#endif // HISTORY_GAME_DATAMODEL_WORLD_WORLD_DIRECTORY_H
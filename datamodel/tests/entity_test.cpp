@@ -1,16 +1,32 @@
 #include <gtest/gtest.h>
+#include <set>
+#include <thread>
+#include <optional>
+#include <type_traits>
 #include <history_game/datamodel/entity/entity.h>
+#include <history_game/datamodel/entity/entity_registry.h>
 #include <history_game/datamodel/world/position.h>
 #include <history_game/datamodel/npc/npc.h>
+#include <history_game/datamodel/npc/npc_identity.h>
 #include <history_game/datamodel/npc/drive.h>
+#include <history_game/datamodel/npc/drive_set.h>
 #include <history_game/datamodel/memory/perception_buffer.h>
+#include <history_game/datamodel/object/object.h>
+#include <history_game/datamodel/pool/hash_cons.h>
+#include <history_game/datamodel/pool/pool_stats.h>
+#include <history_game/datamodel/pool/ref_count.h>
+#include <history_game/datamodel/pool/slab_cache.h>
+#include <history_game/datamodel/pool/small_vector.h>
+#include <history_game/datamodel/relationship/relationship_store.h>
+#include <history_game/datamodel/world/world.h>
 
 using namespace history_game::datamodel;
 
 // Test entity::Entity creation and immutability
 TEST(EntityTest, CreateAndAccess) {
+    entity::EntityRegistry registry;
     // Create an entity
-    entity::Entity entity("test_entity",  world::Position(10.0f, 20.0f));
+    entity::Entity entity("test_entity",  world::Position(10.0f, 20.0f), registry);
     
     // Check fields
     EXPECT_EQ(entity.id, "test_entity");
@@ -20,8 +36,9 @@ TEST(EntityTest, CreateAndAccess) {
 
 // Test managed entity::Entity reference
 TEST(EntityTest, ManagedReference) {
+    entity::EntityRegistry registry;
     // Create an entity::Entity through the storage system
-    entity::Entity entity("test_entity",  world::Position(10.0f, 20.0f));
+    entity::Entity entity("test_entity",  world::Position(10.0f, 20.0f), registry);
     auto ref = entity::Entity::storage::make_entity(std::move(entity));
     
     // Access through reference
@@ -30,6 +47,261 @@ TEST(EntityTest, ManagedReference) {
     EXPECT_FLOAT_EQ(ref->position.y, 20.0f);
 }
 
+// Test handle reuse in the entity::EntityRegistry
+TEST(EntityTest, RegistryGenerations) {
+    entity::EntityRegistry registry;
+    
+    auto first = registry.issue();
+    auto second = registry.issue();
+    EXPECT_TRUE(first.isValid());
+    EXPECT_NE(first, second);
+    EXPECT_FALSE(entity::EntityHandle().isValid());
+    EXPECT_EQ(registry.liveCount(), 2);
+    
+    // A released slot comes back with the next generation
+    registry.release(first);
+    EXPECT_FALSE(registry.isLive(first));
+    auto reused = registry.issue();
+    EXPECT_EQ(reused.index(), first.index());
+    EXPECT_EQ(reused.generation(), first.generation() + 1);
+    EXPECT_NE(reused, first);
+    EXPECT_TRUE(registry.isLive(reused));
+    EXPECT_EQ(registry.liveCount(), 2);
+}
+
+// Test finding the current version of a moved NPC by handle
+TEST(EntityTest, WorldDirectory) {
+    entity::EntityRegistry registry;
+    auto make_npc = [](const entity::Entity::ref_type& entity_ref) {
+        npc::NPCIdentity identity(entity_ref);
+        auto identity_ref = npc::NPCIdentity::storage::make_entity(std::move(identity));
+        memory::PerceptionBuffer buffer({});
+        auto perception = memory::PerceptionBuffer::storage::make_entity(std::move(buffer));
+        npc::NPC npc(identity_ref, {}, perception, {}, {}, {});
+        return npc::NPC::storage::make_entity(std::move(npc));
+    };
+    
+    entity::Entity entity("walker", world::Position(0.0f, 0.0f), registry);
+    auto entity_ref = entity::Entity::storage::make_entity(std::move(entity));
+    
+    // The moved version keeps the handle of the original
+    entity::Entity moved("walker", world::Position(5.0f, 0.0f), entity_ref->handle);
+    auto moved_ref = entity::Entity::storage::make_entity(std::move(moved));
+    
+    entity::Entity well("well", world::Position(1.0f, 1.0f), registry);
+    auto well_ref = entity::Entity::storage::make_entity(std::move(well));
+    auto walker = make_npc(moved_ref);
+    object::WorldObject object(well_ref, object::object_category::Tool{}, walker->getIdentity());
+    auto object_ref = object::WorldObject::storage::make_entity(std::move(object));
+    
+    world::SimulationClock clock(0, 0, 100);
+    auto clock_ref = world::SimulationClock::storage::make_entity(std::move(clock));
+    world::World world(clock_ref, {walker}, {object_ref});
+    
+    const auto* found = world.findNPC(entity_ref->handle);
+    ASSERT_NE(found, nullptr);
+    EXPECT_FLOAT_EQ((*found)->getIdentity()->entity->position.x, 5.0f);
+    EXPECT_EQ(world.findObject(entity_ref->handle), nullptr);
+    
+    const auto* found_object = world.findObject(well_ref->handle);
+    ASSERT_NE(found_object, nullptr);
+    EXPECT_EQ((*found_object)->entity->id, "well");
+    EXPECT_EQ(world.findNPC(entity::EntityHandle()), nullptr);
+    
+    // Storing a world moves its vectors instead of copying them
+    const npc::NPC::ref_type* npcs = world.getNPCs().data();
+    auto world_ref = world::World::storage::make_entity(std::move(world));
+    EXPECT_EQ(world_ref->getNPCs().data(), npcs);
+    EXPECT_NE(world_ref->findNPC(entity_ref->handle), nullptr);
+    
+    // Versions keeping everyone in place share the directory
+    world::World next(*world_ref, clock_ref, {make_npc(entity_ref)}, {object_ref});
+    EXPECT_EQ(next.getDirectory(), world_ref->getDirectory());
+    EXPECT_FLOAT_EQ((*next.findNPC(entity_ref->handle))->getIdentity()->entity->position.x, 0.0f);
+    
+    // A version without the object gets its own
+    world::World emptied(next, clock_ref, next.getNPCs(), {});
+    EXPECT_NE(emptied.getDirectory(), next.getDirectory());
+    EXPECT_EQ(emptied.findObject(well_ref->handle), nullptr);
+    EXPECT_NE(emptied.findNPC(entity_ref->handle), nullptr);
+}
+
+// Test the allocation counters of a managed type
+TEST(EntityTest, PoolStats) {
+    auto getClockStats = [] {
+        for (const auto& stats : pool::pool_system::getStats()) {
+            if (std::string(stats.name) == "SimulationClock") {
+                return stats;
+            }
+        }
+        return pool::PoolStats{"SimulationClock", 16, 0, 0, 0, 0, 0};
+    };
+    
+    world::SimulationClock clock(0, 0, 100);
+    auto before = getClockStats();
+    {
+        auto first = world::SimulationClock::storage::make_entity(std::move(clock));
+        auto second = world::SimulationClock::storage::make_entity(1, 0, 100);
+        auto during = getClockStats();
+        EXPECT_EQ(during.allocations, before.allocations + 2);
+        EXPECT_EQ(during.live, before.live + 2);
+        EXPECT_GE(during.peak, before.live + 2);
+        
+        // Values on the stack, copied or moved from are not in the storage
+        world::SimulationClock copy(*first);
+        world::SimulationClock moved(std::move(copy));
+        EXPECT_EQ(getClockStats().live, during.live);
+    }
+    if constexpr (pool::ref_count_system::DEFERRED) {
+        pool::ref_count_system::settleChanges();
+    }
+    EXPECT_EQ(getClockStats().live, before.live);
+    
+    // Small types use small chunks
+    auto after = getClockStats();
+    EXPECT_EQ(after.chunk_size, 16);
+    EXPECT_EQ(after.chunks, pool::SlabCache<world::SimulationClock>::slabCount());
+    EXPECT_GE(after.chunks, (after.peak + 15) / 16);
+    EXPECT_LE(after.utilization(), 1.0f);
+    EXPECT_TRUE(std::is_empty_v<pool::Counted<entity::Entity>>);
+}
+
+// Test slots handed out by the per-thread slab caches
+TEST(EntityTest, SlabCache) {
+    using Cache = pool::SlabCache<entity::Entity>;
+    
+    // Slots are distinct, and freed ones are handed out again
+    std::vector<void*> slots;
+    for (size_t i = 0; i < 3 * Cache::BATCH; ++i) {
+        slots.push_back(Cache::allocate());
+    }
+    EXPECT_EQ(std::set<void*>(slots.begin(), slots.end()).size(), slots.size());
+    void* last = slots.back();
+    Cache::deallocate(last);
+    EXPECT_EQ(Cache::allocate(), last);
+    
+    // Slots freed by another thread go to that thread's cache
+    std::thread([&slots] {
+        for (void* slot : slots) {
+            pool::SlabCache<entity::Entity>::deallocate(slot);
+        }
+    }).join();
+    
+    // Managed objects are allocated from the cache
+    entity::EntityRegistry registry;
+    auto ref = entity::Entity::storage::make_entity("cached", world::Position(0.0f, 0.0f), registry);
+    EXPECT_EQ(ref->id, "cached");
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&*ref) % alignof(entity::Entity), 0);
+}
+
+// Test short collections kept inline
+TEST(EntityTest, SmallVector) {
+    pool::SmallVector<std::string, 2> names{"a", "b"};
+    EXPECT_EQ(names.size(), 2);
+    EXPECT_EQ(names.heapCapacity(), 0);
+    
+    // Moving inline elements moves each of them
+    pool::SmallVector<std::string, 2> moved(std::move(names));
+    EXPECT_TRUE(names.empty());
+    EXPECT_EQ(moved[1], "b");
+    
+    // Past the inline slots the elements move to the heap
+    moved.push_back("c");
+    EXPECT_GE(moved.heapCapacity(), 3);
+    EXPECT_EQ(moved.back(), "c");
+    const std::string* heap = moved.data();
+    pool::SmallVector<std::string, 2> taken(std::move(moved));
+    EXPECT_EQ(taken.data(), heap);
+    
+    pool::SmallVector<std::string, 2> copy;
+    copy = taken;
+    EXPECT_EQ(copy.size(), 3);
+    EXPECT_EQ(copy[0], "a");
+    EXPECT_NE(copy.data(), taken.data());
+    
+    // Appending one of its own elements when full
+    pool::SmallVector<std::string, 2> full{"first element, long enough to live on the heap", "b"};
+    full.push_back(full[0]);
+    EXPECT_EQ(full[2], full[0]);
+    full.push_back(full[1]);
+    EXPECT_EQ(full[3], "b");
+}
+
+// Test sharing of equal identities
+TEST(EntityTest, HashConsing) {
+    if (!pool::hash_cons_system::ENABLED) {
+        GTEST_SKIP() << "Built without HISTORY_GAME_HASH_CONS";
+    }
+    
+    auto lookups_before = pool::hash_cons_system::getContention().lookups;
+    entity::EntityRegistry registry;
+    auto entity_ref = entity::Entity::storage::make_entity("still", world::Position(1.0f, 2.0f), registry);
+    auto resting = npc::NPCIdentity::storage::make_entity(entity_ref, action::action_type::Rest{});
+    
+    // Every identity made takes a lookup, waiting or not
+    auto contention = pool::hash_cons_system::getContention();
+    EXPECT_EQ(contention.lookups, lookups_before + 1);
+    EXPECT_LE(contention.contended, contention.lookups);
+    
+    // An equal identity made in the next tick is the same object
+    pool::hash_cons_system::advanceGeneration();
+    auto still_resting = npc::NPCIdentity::storage::make_entity(entity_ref, action::action_type::Rest{});
+    EXPECT_EQ(still_resting, resting);
+    EXPECT_NE(npc::NPCIdentity::storage::make_entity(entity_ref, action::action_type::Move{}), resting);
+    
+    // Values unused for a whole generation are no longer shared
+    pool::hash_cons_system::advanceGeneration();
+    pool::hash_cons_system::advanceGeneration();
+    EXPECT_NE(npc::NPCIdentity::storage::make_entity(entity_ref, action::action_type::Rest{}), resting);
+}
+
+// Test references counted from several threads
+TEST(EntityTest, AtomicRefCount) {
+    pool::AtomicRefCount atomic(1);
+    ++atomic;
+    EXPECT_EQ(--atomic, 1);
+    EXPECT_EQ(--atomic, 0);
+    
+    // A reference copied on one thread and dropped on another
+    pool::AtomicRefCount handed_over(1);
+    ++handed_over;
+    uint32_t remaining = 0;
+    std::thread([&handed_over, &remaining] { remaining = --handed_over; }).join();
+    EXPECT_EQ(remaining, 1);
+    EXPECT_EQ(--handed_over, 0);
+}
+
+// Test references counted at the next flushes
+TEST(EntityTest, DeferredRefCount) {
+    struct Tracked {
+        bool* destroyed;
+        explicit Tracked(bool* flag) : destroyed(flag) {}
+        ~Tracked() { *destroyed = true; }
+    };
+    using Storage = cpioo::managed_entity::storage<Tracked, 4, pool::DeferredRefCount>;
+    pool::ref_count_system::settleChanges();
+    
+    bool destroyed = false;
+    std::optional<Storage::ref_type> kept;
+    {
+        auto ref = Storage::make_entity(&destroyed);
+        // A reference copied on another thread outlives the one it was copied from
+        std::thread([&ref, &kept] {
+            kept.emplace(ref);
+            pool::ref_count_system::publishChanges();
+        }).join();
+    }
+    pool::ref_count_system::settleChanges();
+    EXPECT_FALSE(destroyed);
+    
+    // Dropping the last reference frees the object one flush later
+    kept.reset();
+    EXPECT_TRUE(pool::ref_count_system::flushChanges());
+    EXPECT_FALSE(destroyed);
+    EXPECT_FALSE(pool::ref_count_system::flushChanges());
+    EXPECT_TRUE(destroyed);
+}
+
 // Test npc::Drive creation
 TEST(DriveTest, CreateDrive) {
     // Create a npc::Drive with type and intensity
@@ -40,16 +312,41 @@ TEST(DriveTest, CreateDrive) {
     EXPECT_TRUE(std::holds_alternative<npc::drive::Sustenance>(hunger.type));
 }
 
+// Test npc::DriveSet lookup and iteration
+TEST(DriveTest, DriveSet) {
+    npc::DriveSet drives = {
+        npc::Drive(npc::drive::Pride{}, 10.0f),
+        npc::Drive(npc::drive::Belonging{}, 0.0f)
+    };
+    
+    // Present drives are tracked separately from their intensity
+    EXPECT_EQ(drives.size(), 2);
+    EXPECT_TRUE(drives.has(npc::drive::Belonging{}));
+    EXPECT_FALSE(drives.has(npc::drive::Grief{}));
+    EXPECT_FLOAT_EQ(drives.get(npc::drive::Grief{}), 0.0f);
+    
+    drives.set(npc::drive::Grief{}, 5.0f);
+    EXPECT_FLOAT_EQ(drives.get(npc::drive::Grief{}), 5.0f);
+    
+    // Iteration visits the present drives in DriveType order
+    std::vector<std::string> names;
+    for (const auto& drive : drives) {
+        names.push_back(std::visit([](const auto& d) -> std::string { return d.name; }, drive.type));
+    }
+    EXPECT_EQ(names, (std::vector<std::string>{"Belonging", "Grief", "Pride"}));
+}
+
 // Test NPC creation
 TEST(NPCTest, CreateNPC) {
+    entity::EntityRegistry registry;
     // Create components
-    entity::Entity entity("test_npc",  world::Position(15.0f, 25.0f));
+    entity::Entity entity("test_npc",  world::Position(15.0f, 25.0f), registry);
     auto entity_ref = entity::Entity::storage::make_entity(std::move(entity));
     
     npc::NPCIdentity identity(entity_ref);
     auto identity_ref = npc::NPCIdentity::storage::make_entity(std::move(identity));
     
-    std::vector<npc::Drive> drives = {
+    npc::DriveSet drives = {
         npc::Drive(npc::drive::Sustenance{}, 50.0f),
         npc::Drive(npc::drive::Curiosity{}, 60.0f)
     };
@@ -68,12 +365,63 @@ TEST(NPCTest, CreateNPC) {
     );
     
     // Check fields
-    EXPECT_EQ(npc.identity->entity->id, "test_npc");
-    EXPECT_EQ(npc.drives.size(), 2);
-    EXPECT_TRUE(std::holds_alternative<npc::drive::Sustenance>(npc.drives[0].type));
-    EXPECT_TRUE(std::holds_alternative<npc::drive::Curiosity>(npc.drives[1].type));
-    EXPECT_FLOAT_EQ(npc.drives[0].intensity, 50.0f);
-    EXPECT_FLOAT_EQ(npc.drives[1].intensity, 60.0f);
-    EXPECT_TRUE(npc.perception->recent_perceptions.empty());
-    EXPECT_TRUE(npc.episodic_memory.empty());
-}
\ No newline at end of file
+    EXPECT_EQ(npc.getIdentity()->entity->id, "test_npc");
+    EXPECT_EQ(npc.getDrives().size(), 2);
+    EXPECT_TRUE(npc.getDrives().has(npc::drive::Sustenance{}));
+    EXPECT_TRUE(npc.getDrives().has(npc::drive::Curiosity{}));
+    EXPECT_FALSE(npc.getDrives().has(npc::drive::Grief{}));
+    EXPECT_FLOAT_EQ(npc.getDrives().get(npc::drive::Sustenance{}), 50.0f);
+    EXPECT_FLOAT_EQ(npc.getDrives().get(npc::drive::Curiosity{}), 60.0f);
+    EXPECT_TRUE(npc.getPerception()->recent_perceptions.empty());
+    EXPECT_TRUE(npc.getEpisodicMemory().empty());
+}
+
+// Test finding relationships through the store's index
+TEST(RelationshipTest, RelationshipStore) {
+    entity::EntityRegistry registry;
+    auto friend_ref = entity::Entity::storage::make_entity(entity::Entity("friend", world::Position(1.0f, 1.0f), registry));
+    auto stranger_ref = entity::Entity::storage::make_entity(entity::Entity("stranger", world::Position(2.0f, 2.0f), registry));
+    auto creator_ref = npc::NPCIdentity::storage::make_entity(npc::NPCIdentity(friend_ref));
+    auto tool_entity_ref = entity::Entity::storage::make_entity(entity::Entity("tool", world::Position(3.0f, 3.0f), registry));
+    auto tool_ref = object::WorldObject::storage::make_entity(
+        object::WorldObject(tool_entity_ref, object::object_category::Tool{}, creator_ref));
+    
+    auto make = [](relationship::RelationshipTarget target, float familiarity) {
+        return relationship::Relationship::storage::make_entity(
+            relationship::Relationship(std::move(target), familiarity, {}, 0, 1));
+    };
+    
+    std::vector<relationship::Relationship::ref_type> list;
+    list.push_back(make(friend_ref, 0.9f));
+    list.push_back(make(tool_ref, 0.4f));
+    list.push_back(make(relationship::LocationPoint(world::Position(10.0f, 10.0f), 5.0f), 0.7f));
+    list.push_back(make(relationship::LocationPoint(world::Position(12.0f, 10.0f), 5.0f), 0.2f));
+    list.push_back(make(relationship::LocationPoint(world::Position(0.0f, 0.0f), 1000.0f), 0.1f));
+    
+    relationship::RelationshipStore store(list);
+    EXPECT_EQ(store.size(), 5);
+    
+    // Copies share the index
+    relationship::RelationshipStore copy = store;
+    EXPECT_EQ(copy.index.value(), store.index.value());
+    
+    // Entities and objects are found by handle
+    auto found_friend = relationship::relationship_system::findRelationship(store, friend_ref);
+    ASSERT_TRUE(found_friend);
+    EXPECT_FLOAT_EQ(found_friend.value()->familiarity, 0.9f);
+    EXPECT_FALSE(relationship::relationship_system::findRelationship(store, stranger_ref));
+    EXPECT_TRUE(relationship::relationship_system::isFamiliarWith(store, friend_ref));
+    EXPECT_FALSE(relationship::relationship_system::isFamiliarWith(store, tool_ref));
+    
+    // The first containing location wins, as with a plain list
+    for (const auto& position : { world::Position(11.0f, 10.0f), world::Position(16.0f, 10.0f), world::Position(500.0f, 500.0f) }) {
+        EXPECT_EQ(
+            relationship::relationship_system::findLocationRelationship(store, position),
+            relationship::relationship_system::findLocationRelationship(list, position));
+    }
+    EXPECT_FALSE(relationship::relationship_system::findLocationRelationship(store, world::Position(2000.0f, 0.0f)));
+    
+    relationship::RelationshipStore empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_FALSE(relationship::relationship_system::findRelationship(empty, friend_ref));
+}
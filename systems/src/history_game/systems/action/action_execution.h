@@ -7,7 +7,9 @@
 #include <history_game/datamodel/action/action_type.h>
 #include <history_game/datamodel/npc/npc.h>
 #include <history_game/datamodel/object/object.h>
+#include <history_game/datamodel/memory/memory_entry.h>
 #include <history_game/systems/behavior/action_selection.h>
+#include <history_game/systems/memory/memory_system.h>
 #include <history_game/systems/utility/serialization.h>
 
 namespace history_game::systems::action {
@@ -23,13 +25,25 @@ struct ActionExecutor {
     static inline std::random_device rd{};
     static inline std::mt19937 gen{rd()};
     
+    // Helper method to get where a target entity is in this world (its
+    // reference may be an older version)
+    const datamodel::world::Position& getCurrentPosition(const datamodel::entity::Entity::ref_type& target) const {
+        if (const auto* target_npc = world->findNPC(target->handle)) {
+            return (*target_npc)->getIdentity()->entity->position;
+        }
+        if (const auto* target_object = world->findObject(target->handle)) {
+            return (*target_object)->entity->position;
+        }
+        return target->position;
+    }
+    
     // Helper method to update NPC entity position
     datamodel::npc::NPC::ref_type updateNPCPosition(const datamodel::world::Position& new_position) const {
-        auto npc_identity = npc->identity;
+        auto npc_identity = npc->getIdentity();
         auto entity = npc_identity->entity;
         
-        // Create new entity with updated position
-        datamodel::entity::Entity new_entity(entity->id, new_position);
+        // Create a new version of the entity with the updated position
+        datamodel::entity::Entity new_entity(entity->id, new_position, entity->handle);
         auto new_entity_ref = datamodel::entity::Entity::storage::make_entity(std::move(new_entity));
         
         // Create new NPCIdentity with updated entity based on current action and targets
@@ -72,23 +86,24 @@ struct ActionExecutor {
         // Create new NPC with updated identity
         datamodel::npc::NPC updated_npc(
             new_identity_ref, 
-            npc->drives, 
-            npc->perception,
-            npc->episodic_memory,
-            npc->observed_behaviors,  // Correct field name (was known_entities)
-            npc->relationships
+            npc->getDrives(), 
+            npc->getPerception(),
+            npc->getEpisodicMemory(),
+            npc->getObservedBehaviors(),  // Correct field name (was known_entities)
+            npc->getRelationships(),
+            npc->getSegmentation()
         );
         return datamodel::npc::NPC::storage::make_entity(std::move(updated_npc));
     }
     
     // Move action handler
     datamodel::npc::NPC::ref_type operator()(const datamodel::action::action_type::Move&) const {
-        auto npc_identity = npc->identity;
+        auto npc_identity = npc->getIdentity();
         auto position = npc_identity->entity->position;
         
-        // If we have a target, move toward it
+        // If we have a target, move toward where it is now
         if (npc_identity->target_entity) {
-            auto target_pos = npc_identity->target_entity.value()->position;
+            auto target_pos = getCurrentPosition(npc_identity->target_entity.value());
             float dx = target_pos.x - position.x;
             float dy = target_pos.y - position.y;
             
@@ -114,7 +129,7 @@ struct ActionExecutor {
             
             // Log movement in the debug output
             spdlog::debug("NPC {} moved from ({:.1f}, {:.1f}) to ({:.1f}, {:.1f})",
-                         npc->identity->entity->id,
+                         npc->getIdentity()->entity->id,
                          position.x, position.y,
                          new_position.x, new_position.y);
             
@@ -148,7 +163,7 @@ struct ActionExecutor {
             
             // Log movement in the debug output
             spdlog::debug("NPC {} moved randomly from ({:.1f}, {:.1f}) to ({:.1f}, {:.1f})",
-                         npc->identity->entity->id,
+                         npc->getIdentity()->entity->id,
                          position.x, position.y,
                          new_position.x, new_position.y);
             
@@ -166,7 +181,7 @@ struct ActionExecutor {
     // Take action handler
     datamodel::npc::NPC::ref_type operator()(const datamodel::action::action_type::Take&) const {
         // Take action: Move an object closer to the NPC
-        if (npc->identity->target_object) {
+        if (npc->getIdentity()->target_object) {
             // In a real implementation, we might:
             // 1. Change the object's position to be near the NPC
             // 2. Update the object's ownership
@@ -179,7 +194,7 @@ struct ActionExecutor {
     // Give action handler
     datamodel::npc::NPC::ref_type operator()(const datamodel::action::action_type::Give&) const {
         // Give action: Transfer an object to another NPC
-        if (npc->identity->target_entity && npc->identity->target_object) {
+        if (npc->getIdentity()->target_entity && npc->getIdentity()->target_object) {
             // In a real implementation, we might:
             // 1. Change the object's position to be near the target NPC
             // 2. Update the object's ownership
@@ -245,12 +260,12 @@ inline datamodel::npc::NPC::ref_type executeAction(
     utility::SimulationLogger* logger = nullptr
 ) {
     // If NPC has no current action, return the NPC unchanged
-    if (!npc->identity->current_action) {
+    if (!npc->getIdentity()->current_action) {
         return npc;
     }
 
     // Get the action type
-    auto action_type = npc->identity->current_action.value();
+    auto action_type = npc->getIdentity()->current_action.value();
         
     // Log the action to the serialization logger if provided
     if (logger && logger->isInitialized()) {
@@ -259,9 +274,9 @@ inline datamodel::npc::NPC::ref_type executeAction(
         
         // Get target ID if exists
         std::optional<std::string> target_id;
-        if (npc->identity->target_entity) {
-            target_id = npc->identity->target_entity.value()->id;
-        } else if (npc->identity->target_object) {
+        if (npc->getIdentity()->target_entity) {
+            target_id = npc->getIdentity()->target_entity.value()->id;
+        } else if (npc->getIdentity()->target_object) {
             // WorldObject is a forward-declared type in NPCIdentity, but the actual type is from object namespace
             // This is tricky to handle; let's log that we have a target but skip the ID
             target_id = std::string("object-target");
@@ -270,7 +285,7 @@ inline datamodel::npc::NPC::ref_type executeAction(
         // Log action execution event
         logger->logEvent(utility::createActionExecutionEvent(
             current_time,
-            npc->identity->entity->id,
+            npc->getIdentity()->entity->id,
             behavior::action_selection_system::get_action_name(action_type),
             target_id
         ));
@@ -281,30 +296,92 @@ inline datamodel::npc::NPC::ref_type executeAction(
     return std::visit(executor, action_type);
 }
 
+/**
+ * Create the event record for the action an NPC executed this tick
+ * 
+ * If the NPC was already doing the same thing in the previous tick, the record
+ * spans both ticks, so observers watching the whole run keep sharing one entry.
+ * 
+ * @param npc The NPC after executing its current action
+ * @param current_tick The tick in which the action was executed
+ * @param previous_event The NPC's event record of the previous tick, if any
+ * @return The event record shared by every observer of the action
+ */
+inline datamodel::memory::MemoryEntry::ref_type createActionEvent(
+    const datamodel::npc::NPC::ref_type& npc,
+    uint64_t current_tick,
+    const datamodel::memory::MemoryEntry::ref_type* previous_event = nullptr
+) {
+    const auto& identity = npc->getIdentity();
+    
+    auto event = std::visit(
+        [&](const auto& action_type) {
+            if (identity->target_entity) {
+                return datamodel::memory::MemoryEntry(current_tick, identity, action_type, identity->target_entity.value());
+            }
+            if (identity->target_object) {
+                return datamodel::memory::MemoryEntry(current_tick, identity, action_type, identity->target_object.value());
+            }
+            return datamodel::memory::MemoryEntry(current_tick, identity, action_type);
+        },
+        identity->current_action.value()
+    );
+    
+    // Extend the previous record when the action continues
+    if (previous_event &&
+        (*previous_event)->lastTimestamp() + 1 == current_tick &&
+        current_tick - (*previous_event)->timestamp <= datamodel::memory::MemoryEntry::MAX_SPAN &&
+        memory::isSameObservation(**previous_event, event)) {
+        datamodel::memory::MemoryEntry span(event, (*previous_event)->timestamp, current_tick);
+        return datamodel::memory::MemoryEntry::storage::make_entity(std::move(span));
+    }
+    
+    return datamodel::memory::MemoryEntry::storage::make_entity(std::move(event));
+}
+
 /**
  * Execute all NPC actions in the world
  * 
  * @param world The current world state
  * @param logger Optional serialization logger for event recording
- * @return Updated world with all actions executed
+ * @return Updated world with all actions executed and one event per action
  */
 inline datamodel::world::World::ref_type executeAllActions(
     const datamodel::world::World::ref_type& world,
     utility::SimulationLogger* logger = nullptr
 ) {
-    spdlog::info("Executing actions for all NPCs at tick {}", world->clock->current_tick);
+    spdlog::info("Executing actions for all NPCs at tick {}", world->getClock()->current_tick);
+    
+    uint64_t current_tick = world->getClock()->current_tick;
     
     std::vector<datamodel::npc::NPC::ref_type> updated_npcs;
-    updated_npcs.reserve(world->npcs.size());
+    updated_npcs.reserve(world->getNPCs().size());
+    
+    std::vector<datamodel::memory::MemoryEntry::ref_type> events;
+    events.reserve(world->getNPCs().size());
+    
+    // Events of the previous tick, so continuing actions can be extended
+    auto previous_events = memory::indexEventsByActor(world->getEvents());
     
     // Execute actions for each NPC
-    for (const auto& npc : world->npcs) {
+    for (const auto& npc : world->getNPCs()) {
         auto updated_npc = executeAction(world, npc, logger);
+        
+        // Record one event per executed action
+        if (updated_npc->getIdentity()->current_action) {
+            auto previous = previous_events.find(updated_npc->getIdentity()->entity->handle);
+            events.push_back(createActionEvent(
+                updated_npc,
+                current_tick,
+                previous != previous_events.end() ? &world->getEvents()[previous->second] : nullptr
+            ));
+        }
+        
         updated_npcs.push_back(updated_npc);
     }
     
-    // Create a new world with updated NPCs
-    datamodel::world::World updated_world(world->clock, updated_npcs, world->objects);
+    // Create a new world with updated NPCs and this tick's events
+    datamodel::world::World updated_world(*world, world->getClock(), updated_npcs, world->getObjects(), std::move(events));
     return datamodel::world::World::storage::make_entity(std::move(updated_world));
 }
 
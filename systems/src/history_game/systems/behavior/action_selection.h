@@ -4,6 +4,8 @@
 #include <vector>
 #include <optional>
 #include <algorithm>
+#include <iterator>
+#include <utility>
 #include <random>
 #include <cpioo/managed_entity.hpp>
 #include <spdlog/spdlog.h>
@@ -19,29 +21,32 @@ namespace history_game::systems::behavior {
 
 /**
  * Represents a possible action that an NPC could take, with its potential targets
+ * Set by the constructors and read through the accessors; options can be moved.
  */
 struct ActionOption {
+private:
   // The action type
-  const datamodel::action::ActionType action;
+  datamodel::action::ActionType action;
   
   // Possible targets for the action (if any)
-  const std::optional<datamodel::entity::Entity::ref_type> target_entity;
+  std::optional<datamodel::entity::Entity::ref_type> target_entity;
   
   // Possible object target for the action (if any)
-  const std::optional<datamodel::object::WorldObject::ref_type> target_object;
+  std::optional<datamodel::object::WorldObject::ref_type> target_object;
   
   // The expected drive impacts from performing this action
-  const std::vector<datamodel::npc::Drive> expected_impacts;
+  datamodel::npc::DriveSet expected_impacts;
   
   // Whether this action is from episodic memory or primitive heuristics
-  const bool from_memory;
+  bool from_memory;
   
+public:
   // Constructor for action targeting an entity
   template<datamodel::action::ActionTypeConcept T>
   ActionOption(
     T action_type,
     const datamodel::entity::Entity::ref_type& entity,
-    std::vector<datamodel::npc::Drive> impacts,
+    datamodel::npc::DriveSet impacts,
     bool is_from_memory = false
   ) : action(action_type),
       target_entity(entity),
@@ -54,7 +59,7 @@ struct ActionOption {
   ActionOption(
     T action_type,
     const datamodel::object::WorldObject::ref_type& object,
-    std::vector<datamodel::npc::Drive> impacts,
+    datamodel::npc::DriveSet impacts,
     bool is_from_memory = false
   ) : action(action_type),
       target_entity(std::nullopt),
@@ -66,13 +71,19 @@ struct ActionOption {
   template<datamodel::action::ActionTypeConcept T>
   ActionOption(
     T action_type,
-    std::vector<datamodel::npc::Drive> impacts,
+    datamodel::npc::DriveSet impacts,
     bool is_from_memory = false
   ) : action(action_type),
       target_entity(std::nullopt),
       target_object(std::nullopt),
       expected_impacts(std::move(impacts)),
       from_memory(is_from_memory) {}
+  
+  const datamodel::action::ActionType& getAction() const { return action; }
+  const std::optional<datamodel::entity::Entity::ref_type>& getTargetEntity() const { return target_entity; }
+  const std::optional<datamodel::object::WorldObject::ref_type>& getTargetObject() const { return target_object; }
+  const datamodel::npc::DriveSet& getExpectedImpacts() const { return expected_impacts; }
+  bool isFromMemory() const { return from_memory; }
 };
 
 /**
@@ -80,7 +91,7 @@ struct ActionOption {
  */
 struct ActionSelectionCriteria {
   // The NPC's current drives that need to be addressed
-  const std::vector<datamodel::npc::Drive>& current_drives;
+  const datamodel::npc::DriveSet& current_drives;
   
   // Preference for familiar actions vs. novel actions (0.0-1.0)
   const float familiarity_preference;
@@ -93,7 +104,7 @@ struct ActionSelectionCriteria {
   
   // Constructor
   ActionSelectionCriteria(
-    const std::vector<datamodel::npc::Drive>& drives,
+    const datamodel::npc::DriveSet& drives,
     float f_pref = 0.5f,
     float s_pref = 0.5f,
     float rand = 0.2f
@@ -115,27 +126,21 @@ namespace action_selection_system {
    */
   inline float calculateDriveScore(
     const ActionOption& option,
-    const std::vector<datamodel::npc::Drive>& current_drives
+    const datamodel::npc::DriveSet& current_drives
   ) {
     float total_score = 0.0f;
     
-    // For each current drive, check if any expected impacts address it
-    for (const auto& drive : current_drives) {
+    // Absent drives and impacts have intensity 0 and add nothing
+    for (size_t i = 0; i < datamodel::npc::DriveSet::SIZE; ++i) {
+      float drive_intensity = current_drives.values[i];
+      
       // Skip drives with low intensity
-      if (std::abs(drive.intensity) < 0.1f) {
-        continue;
-      }
+      float relevant = std::abs(drive_intensity) < 0.1f ? 0.0f : 1.0f;
       
-      // Find any impacts that affect this drive
-      for (const auto& impact : option.expected_impacts) {
-        // Check if the impact addresses this drive
-        if (drives::drive_impact_system::areSameDriveTypes(drive.type, impact.type)) {
-          // Higher drive intensity and stronger impact give higher score
-          // Negative impact intensity means drive reduction
-          float drive_reduction = -impact.intensity * drive.intensity;
-          total_score += drive_reduction;
-        }
-      }
+      // Higher drive intensity and stronger impact give higher score
+      // Negative impact intensity means drive reduction
+      float drive_reduction = -option.getExpectedImpacts().values[i] * drive_intensity;
+      total_score += drive_reduction * relevant;
     }
     
     return total_score;
@@ -151,12 +156,12 @@ namespace action_selection_system {
     float pref_score = 0.0f;
     
     // Memory-based actions get a boost based on familiarity preference
-    if (option.from_memory) {
+    if (option.isFromMemory()) {
       pref_score += criteria.familiarity_preference * 10.0f;
     }
     
     // Actions with entity targets get a boost based on social preference
-    if (option.target_entity) {
+    if (option.getTargetEntity()) {
       pref_score += criteria.social_preference * 5.0f;
     }
     
@@ -171,16 +176,16 @@ namespace action_selection_system {
     const datamodel::world::World::ref_type& world
   ) {
     std::vector<ActionOption> options;
-    const auto& npc_position = npc->identity->entity->position;
+    const auto& npc_position = npc->getIdentity()->entity->position;
     
     // Find all nearby NPCs
-    for (const auto& other_npc : world->npcs) {
+    for (const auto& other_npc : world->getNPCs()) {
       // Skip self
-      if (other_npc->identity->entity->id == npc->identity->entity->id) {
+      if (other_npc->getIdentity()->entity->handle == npc->getIdentity()->entity->handle) {
         continue;
       }
       
-      const auto& other_position = other_npc->identity->entity->position;
+      const auto& other_position = other_npc->getIdentity()->entity->position;
       float distance = std::sqrt(
         std::pow(npc_position.x - other_position.x, 2) +
         std::pow(npc_position.y - other_position.y, 2)
@@ -191,23 +196,23 @@ namespace action_selection_system {
         // For Belonging drive: Follow
         options.emplace_back(
           datamodel::action::action_type::Follow{},
-          other_npc->identity->entity,
-          std::vector<datamodel::npc::Drive>{datamodel::npc::Drive(datamodel::npc::drive::Belonging{}, -0.3f)},
+          other_npc->getIdentity()->entity,
+          datamodel::npc::DriveSet{datamodel::npc::Drive(datamodel::npc::drive::Belonging{}, -0.3f)},
           false
         );
         
         // For Curiosity drive: Observe
         options.emplace_back(
           datamodel::action::action_type::Observe{},
-          other_npc->identity->entity,
-          std::vector<datamodel::npc::Drive>{datamodel::npc::Drive(datamodel::npc::drive::Curiosity{}, -0.2f)},
+          other_npc->getIdentity()->entity,
+          datamodel::npc::DriveSet{datamodel::npc::Drive(datamodel::npc::drive::Curiosity{}, -0.2f)},
           false
         );
       }
     }
     
     // Find all nearby objects
-    for (const auto& object : world->objects) {
+    for (const auto& object : world->getObjects()) {
       const auto& obj_position = object->entity->position;
       float distance = std::sqrt(
         std::pow(npc_position.x - obj_position.x, 2) +
@@ -220,7 +225,7 @@ namespace action_selection_system {
         options.emplace_back(
           datamodel::action::action_type::Observe{},
           object,
-          std::vector<datamodel::npc::Drive>{datamodel::npc::Drive(datamodel::npc::drive::Curiosity{}, -0.2f)},
+          datamodel::npc::DriveSet{datamodel::npc::Drive(datamodel::npc::drive::Curiosity{}, -0.2f)},
           false
         );
         
@@ -233,7 +238,7 @@ namespace action_selection_system {
             options.emplace_back(
               datamodel::action::action_type::Take{},
               object,
-              std::vector<datamodel::npc::Drive>{datamodel::npc::Drive(datamodel::npc::drive::Sustenance{}, -0.5f)},
+              datamodel::npc::DriveSet{datamodel::npc::Drive(datamodel::npc::drive::Sustenance{}, -0.5f)},
               false
             );
           }
@@ -242,7 +247,7 @@ namespace action_selection_system {
             options.emplace_back(
               datamodel::action::action_type::Rest{},
               object,
-              std::vector<datamodel::npc::Drive>{
+              datamodel::npc::DriveSet{
                 datamodel::npc::Drive(datamodel::npc::drive::Shelter{}, -0.4f),
                 datamodel::npc::Drive(datamodel::npc::drive::Sustenance{}, -0.3f)
               },
@@ -258,14 +263,14 @@ namespace action_selection_system {
     // For Curiosity drive: Move
     options.emplace_back(
       datamodel::action::action_type::Move{},
-      std::vector<datamodel::npc::Drive>{datamodel::npc::Drive(datamodel::npc::drive::Curiosity{}, -0.2f)},
+      datamodel::npc::DriveSet{datamodel::npc::Drive(datamodel::npc::drive::Curiosity{}, -0.2f)},
       false
     );
     
     // For Shelter drive: Build
     options.emplace_back(
       datamodel::action::action_type::Build{},
-      std::vector<datamodel::npc::Drive>{
+      datamodel::npc::DriveSet{
         datamodel::npc::Drive(datamodel::npc::drive::Shelter{}, -0.3f),
         datamodel::npc::Drive(datamodel::npc::drive::Pride{}, -0.2f)
       },
@@ -275,7 +280,7 @@ namespace action_selection_system {
     // For Pride drive: Gesture
     options.emplace_back(
       datamodel::action::action_type::Gesture{},
-      std::vector<datamodel::npc::Drive>{datamodel::npc::Drive(datamodel::npc::drive::Pride{}, -0.3f)},
+      datamodel::npc::DriveSet{datamodel::npc::Drive(datamodel::npc::drive::Pride{}, -0.3f)},
       false
     );
     
@@ -292,7 +297,7 @@ namespace action_selection_system {
     std::vector<ActionOption> options;
     
     // Find episodic memories with significant positive impacts
-    for (const auto& episode : npc->episodic_memory) {
+    for (const auto& episode : npc->getEpisodicMemory()) {
       // Skip episodes that haven't been experienced multiple times
       if (episode->repetition_count < 2) {
         continue;
@@ -306,40 +311,27 @@ namespace action_selection_system {
       const auto& first_step = episode->action_sequence->steps.front();
       const auto& memory = first_step.memory;
       
-      // Use the action and targets from the memory
-      datamodel::action::ActionType action = memory->action;
-      std::optional<datamodel::entity::Entity::ref_type> target_entity = memory->target_entity;
-      std::optional<datamodel::object::WorldObject::ref_type> target_object = memory->target_object;
+      // Use the action from the memory
+      datamodel::action::ActionType action = memory->action();
       
-      // Check if targets still exist in the world
-      bool targets_exist = true;
+      // Target the current versions of the remembered targets, if they still exist
+      std::optional<datamodel::entity::Entity::ref_type> target_entity;
+      std::optional<datamodel::object::WorldObject::ref_type> target_object;
       
-      if (target_entity) {
-        // Check if entity still exists (simplistic check)
-        bool found = false;
-        for (const auto& npc : world->npcs) {
-          if (npc->identity->entity->id == target_entity.value()->id) {
-            found = true;
-            break;
-          }
+      if (const auto* remembered = memory->targetEntity()) {
+        const auto* current = world->findNPC(*remembered);
+        if (!current) {
+          continue;
         }
-        if (!found) targets_exist = false;
+        target_entity.emplace((*current)->getIdentity()->entity);
       }
       
-      if (target_object) {
-        // Check if object still exists (simplistic check)
-        bool found = false;
-        for (const auto& obj : world->objects) {
-          if (obj->entity->id == target_object.value()->entity->id) {
-            found = true;
-            break;
-          }
+      if (const auto* remembered = memory->targetObject()) {
+        const auto* current = world->findObject(*remembered);
+        if (!current) {
+          continue;
         }
-        if (!found) targets_exist = false;
-      }
-      
-      if (!targets_exist) {
-        continue;
+        target_object.emplace(*current);
       }
       
       // Create action option with expected impacts from episode
@@ -381,9 +373,10 @@ namespace action_selection_system {
   
   /**
    * Score and select an action from the available options
+   * The selected option is moved out of options.
    */
   inline std::optional<ActionOption> selectAction(
-    const std::vector<ActionOption>& options,
+    std::vector<ActionOption> options,
     const ActionSelectionCriteria& criteria
   ) {
     if (options.empty()) {
@@ -428,11 +421,11 @@ namespace action_selection_system {
       std::uniform_int_distribution<> dist(0, top_n - 1);
       size_t index = dist(gen);
       
-      return options[scored_options[index].first];
+      return std::move(options[scored_options[index].first]);
     }
     
     // Otherwise choose the highest scoring option
-    return options[scored_options.front().first];
+    return std::move(options[scored_options.front().first]);
   }
   
   /**
@@ -443,36 +436,36 @@ namespace action_selection_system {
     const ActionOption& selected_action
   ) {
     // Log the action being taken
-    const std::string action_name = get_action_name(selected_action.action);
+    const std::string action_name = get_action_name(selected_action.getAction());
     const std::string npc_id = identity->entity->id;
     
-    if (selected_action.target_entity) {
-      const std::string target_id = selected_action.target_entity.value()->id;
+    if (selected_action.getTargetEntity()) {
+      const std::string target_id = selected_action.getTargetEntity().value()->id;
       spdlog::info("NPC {} performs {} targeting entity {}", npc_id, action_name, target_id);
     } 
-    else if (selected_action.target_object) {
-      const std::string object_id = selected_action.target_object.value()->entity->id;
+    else if (selected_action.getTargetObject()) {
+      const std::string object_id = selected_action.getTargetObject().value()->entity->id;
       spdlog::info("NPC {} performs {} targeting object {}", npc_id, action_name, object_id);
     }
     else {
       spdlog::info("NPC {} performs {}", npc_id, action_name);
     }
     // Create a new identity with the updated action
-    if (selected_action.target_entity) {
+    if (selected_action.getTargetEntity()) {
       // Action targeting an entity
       datamodel::npc::NPCIdentity updated_identity(
         identity->entity,
-        selected_action.action,
-        selected_action.target_entity.value()
+        selected_action.getAction(),
+        selected_action.getTargetEntity().value()
       );
       return datamodel::npc::NPCIdentity::storage::make_entity(std::move(updated_identity));
     }
-    else if (selected_action.target_object) {
+    else if (selected_action.getTargetObject()) {
       // Action targeting an object
       datamodel::npc::NPCIdentity updated_identity(
         identity->entity,
-        selected_action.action,
-        selected_action.target_object.value()
+        selected_action.getAction(),
+        selected_action.getTargetObject().value()
       );
       return datamodel::npc::NPCIdentity::storage::make_entity(std::move(updated_identity));
     }
@@ -480,7 +473,7 @@ namespace action_selection_system {
       // Untargeted action
       datamodel::npc::NPCIdentity updated_identity(
         identity->entity,
-        selected_action.action
+        selected_action.getAction()
       );
       return datamodel::npc::NPCIdentity::storage::make_entity(std::move(updated_identity));
     }
@@ -502,21 +495,14 @@ namespace action_selection_system {
     auto memory_options = generateMemoryBasedActions(npc, world);
     
     // Combine all options
-    std::vector<ActionOption> all_options;
-    all_options.reserve(primitive_options.size() + memory_options.size());
-    
-    // Add primitive options
-    for (const auto& option : primitive_options) {
-      all_options.push_back(option);
-    }
+    std::vector<ActionOption> all_options = std::move(primitive_options);
+    all_options.reserve(all_options.size() + memory_options.size());
     
     // Add memory options
-    for (const auto& option : memory_options) {
-      all_options.push_back(option);
-    }
+    std::move(memory_options.begin(), memory_options.end(), std::back_inserter(all_options));
     
     // Select the best action
-    auto selected_action = selectAction(all_options, criteria);
+    auto selected_action = selectAction(std::move(all_options), criteria);
     
     if (!selected_action) {
       // No suitable action found, return unchanged NPC
@@ -525,18 +511,19 @@ namespace action_selection_system {
     
     // Update the NPC's identity with the selected action
     auto updated_identity = updateIdentityWithAction(
-      npc->identity,
+      npc->getIdentity(),
       selected_action.value()
     );
     
     // Create a new NPC with the updated identity
     datamodel::npc::NPC updated_npc(
       updated_identity,
-      npc->drives,
-      npc->perception,
-      npc->episodic_memory,
-      npc->observed_behaviors,
-      npc->relationships
+      npc->getDrives(),
+      npc->getPerception(),
+      npc->getEpisodicMemory(),
+      npc->getObservedBehaviors(),
+      npc->getRelationships(),
+      npc->getSegmentation()
     );
     
     return datamodel::npc::NPC::storage::make_entity(std::move(updated_npc));
@@ -551,50 +538,28 @@ namespace action_selection_system {
     const ActionOption& action,
     float action_effectiveness = 1.0f
   ) {
-    // Create a new vector for updated drives
-    std::vector<datamodel::npc::Drive> updated_drives;
-    updated_drives.reserve(npc->drives.size());
+    // Apply the impacts the NPC has drives for, scaled by effectiveness
+    datamodel::npc::DriveSet updated_drives = npc->getDrives();
+    uint8_t affected = npc->getDrives().present & action.getExpectedImpacts().present;
     
-    // Track which drives have been updated
-    std::vector<bool> updated(npc->drives.size(), false);
-    
-    // First pass: apply impacts
-    for (size_t i = 0; i < npc->drives.size(); ++i) {
-      const auto& drive = npc->drives[i];
-      bool found_impact = false;
-      
-      // Check if this drive has a matching impact
-      for (const auto& impact : action.expected_impacts) {
-        if (drives::drive_impact_system::areSameDriveTypes(drive.type, impact.type)) {
-          // Apply the impact, scaled by effectiveness
-          float new_intensity = drive.intensity + (impact.intensity * action_effectiveness);
-          
-          // Ensure intensity stays within bounds (0-100)
-          new_intensity = std::max(0.0f, std::min(100.0f, new_intensity));
-          
-          // Add updated drive
-          updated_drives.emplace_back(drive.type, new_intensity);
-          updated[i] = true;
-          found_impact = true;
-          break;
-        }
-      }
-      
-      // If no impact for this drive, copy the original
-      if (!found_impact) {
-        updated_drives.push_back(drive);
+    for (size_t i = 0; i < datamodel::npc::DriveSet::SIZE; ++i) {
+      if ((affected >> i) & 1u) {
+        float new_intensity = npc->getDrives().values[i] + (action.getExpectedImpacts().values[i] * action_effectiveness);
+        
+        // Ensure intensity stays within bounds (0-100)
+        updated_drives.values[i] = std::max(0.0f, std::min(100.0f, new_intensity));
       }
     }
     
-    
     // Create a new NPC with updated drives
     datamodel::npc::NPC updated_npc(
-      npc->identity,
+      npc->getIdentity(),
       updated_drives,
-      npc->perception,
-      npc->episodic_memory,
-      npc->observed_behaviors,
-      npc->relationships
+      npc->getPerception(),
+      npc->getEpisodicMemory(),
+      npc->getObservedBehaviors(),
+      npc->getRelationships(),
+      npc->getSegmentation()
     );
     
     return datamodel::npc::NPC::storage::make_entity(std::move(updated_npc));
@@ -1,11 +1,13 @@
 #ifndef HISTORY_GAME_SYSTEMS_DRIVES_DRIVE_DYNAMICS_H
 #define HISTORY_GAME_SYSTEMS_DRIVES_DRIVE_DYNAMICS_H
 
+#include <array>
 #include <vector>
 #include <cmath>
 #include <spdlog/spdlog.h>
 #include <history_game/datamodel/npc/npc.h>
 #include <history_game/datamodel/npc/drive.h>
+#include <history_game/datamodel/npc/drive_set.h>
 #include <history_game/systems/drives/drive_impact.h>
 
 namespace history_game::systems::drives {
@@ -23,6 +25,9 @@ struct DriveParameters {
   // Different growth rates for each drive type
   const std::vector<std::pair<datamodel::npc::DriveType, float>> drive_growth_modifiers;
   
+  // The same modifiers indexed by drive type (1.0 where none was given)
+  const std::array<float, datamodel::npc::DriveSet::SIZE> growth_modifiers;
+  
   // Constructor with default values
   DriveParameters(
     float growth_rate = 0.1f,
@@ -30,7 +35,22 @@ struct DriveParameters {
     std::vector<std::pair<datamodel::npc::DriveType, float>> modifiers = {}
   ) : base_growth_rate(growth_rate),
       intensity_factor(intensity),
-      drive_growth_modifiers(std::move(modifiers)) {}
+      drive_growth_modifiers(std::move(modifiers)),
+      growth_modifiers(indexModifiers(drive_growth_modifiers)) {}
+
+private:
+  static std::array<float, datamodel::npc::DriveSet::SIZE> indexModifiers(
+    const std::vector<std::pair<datamodel::npc::DriveType, float>>& modifiers
+  ) {
+    std::array<float, datamodel::npc::DriveSet::SIZE> indexed;
+    indexed.fill(1.0f);
+    
+    // The first modifier given for a drive type wins
+    for (auto it = modifiers.rbegin(); it != modifiers.rend(); ++it) {
+      indexed[it->first.index()] = it->second;
+    }
+    return indexed;
+  }
 };
 
 namespace drive_dynamics_system {
@@ -47,20 +67,9 @@ namespace drive_dynamics_system {
    */
   inline float getGrowthModifier(
     const datamodel::npc::DriveType& drive_type,
-    const std::vector<std::pair<datamodel::npc::DriveType, float>>& modifiers
+    const DriveParameters& params
   ) {
-    // Default modifier if not found
-    float modifier = 1.0f;
-    
-    // Look for a specific modifier for this drive type
-    for (const auto& [type, mod] : modifiers) {
-      if (drive_impact_system::areSameDriveTypes(drive_type, type)) {
-        modifier = mod;
-        break;
-      }
-    }
-    
-    return modifier;
+    return params.growth_modifiers[drive_type.index()];
   }
   
   /**
@@ -72,10 +81,7 @@ namespace drive_dynamics_system {
     uint64_t ticks_elapsed
   ) {
     // Get the growth modifier for this drive type
-    float growth_modifier = getGrowthModifier(
-      drive.type,
-      params.drive_growth_modifiers
-    );
+    float growth_modifier = getGrowthModifier(drive.type, params);
     
     // Calculate the natural increase rate, adjusted for this drive
     float increase_rate = params.base_growth_rate * growth_modifier;
@@ -106,27 +112,22 @@ namespace drive_dynamics_system {
     const DriveParameters& params,
     uint64_t ticks_elapsed
   ) {
-    // Update each drive
-    std::vector<datamodel::npc::Drive> updated_drives;
-    updated_drives.reserve(npc->drives.size());
-    
-    // Log the update
-    const std::string npc_id = npc->identity->entity->id;
+    // Update each drive the NPC has
+    datamodel::npc::DriveSet updated_drives = npc->getDrives();
     
-    for (const auto& drive : npc->drives) {
-      updated_drives.push_back(
-        updateDrive(drive, params, ticks_elapsed)
-      );
+    for (const auto& drive : npc->getDrives()) {
+      updated_drives.set(drive.type, updateDrive(drive, params, ticks_elapsed).intensity);
     }
     
     // Create a new NPC with updated drives
     datamodel::npc::NPC updated_npc(
-      npc->identity,
+      npc->getIdentity(),
       updated_drives,
-      npc->perception,
-      npc->episodic_memory,
-      npc->observed_behaviors,
-      npc->relationships
+      npc->getPerception(),
+      npc->getEpisodicMemory(),
+      npc->getObservedBehaviors(),
+      npc->getRelationships(),
+      npc->getSegmentation()
     );
     
     return datamodel::npc::NPC::storage::make_entity(std::move(updated_npc));
@@ -1,12 +1,14 @@
 #ifndef HISTORY_GAME_SYSTEMS_DRIVES_DRIVE_IMPACT_H
 #define HISTORY_GAME_SYSTEMS_DRIVES_DRIVE_IMPACT_H
 
+#include <cmath>
 #include <vector>
 #include <optional>
 #include <string>
 #include <variant>
 #include <cpioo/managed_entity.hpp>
 #include <history_game/datamodel/npc/drive.h>
+#include <history_game/datamodel/npc/drive_set.h>
 #include <history_game/datamodel/npc/npc.h>
 #include <history_game/datamodel/action/action_type.h>
 #include <history_game/datamodel/memory/memory_entry.h>
@@ -24,16 +26,10 @@ namespace drive_impact_system {
   inline std::optional<datamodel::relationship::Relationship::ref_type> findActorRelationship(
     const datamodel::drives::ActionContext& context
   ) {
-    // Get the actor's identity from the memory
-    const datamodel::npc::NPCIdentity::ref_type& actor_identity = context.memory->actor;
-    
-    // Get the actor's entity reference
-    const datamodel::entity::Entity::ref_type& actor_entity = actor_identity->entity;
-    
-    // Look for a relationship with this entity
+    // Look for a relationship with the actor's entity
     return datamodel::relationship::relationship_system::findRelationship(
-      context.observer->relationships, 
-      actor_entity
+      context.observer->getRelationships(), 
+      context.memory->actorHandle()
     );
   }
   
@@ -43,16 +39,18 @@ namespace drive_impact_system {
   inline std::optional<datamodel::relationship::Relationship::ref_type> findLocationRelationship(
     const datamodel::drives::ActionContext& context
   ) {
-    // Get the memory's location where the action occurred
-    const datamodel::entity::Entity::ref_type& location_entity = 
-      context.memory->target_entity.value_or(context.memory->actor->entity);
-    
-    const datamodel::world::Position& action_position = location_entity->position;
+    // The action happened where its target (or else its actor) is now
+    const auto* target_entity = context.memory->targetEntity();
+    const datamodel::entity::Entity::ref_type* location_entity =
+      context.world.findEntity(target_entity ? *target_entity : context.memory->actorHandle());
+    if (!location_entity) {
+      return std::nullopt;
+    }
     
     // Look for a relationship with this location
     return datamodel::relationship::relationship_system::findLocationRelationship(
-      context.observer->relationships,
-      action_position
+      context.observer->getRelationships(),
+      (*location_entity)->position
     );
   }
   
@@ -63,75 +61,69 @@ namespace drive_impact_system {
     const datamodel::drives::ActionContext& context
   ) {
     // Check if there's an object target
-    if (!context.memory->target_object) {
+    if (!context.memory->targetObject()) {
       return std::nullopt;
     }
     
-    // Get the object reference
-    const datamodel::object::WorldObject::ref_type& target_object = context.memory->target_object.value();
-    
     // Look for a relationship with this object
     return datamodel::relationship::relationship_system::findRelationship(
-      context.observer->relationships,
-      target_object
+      context.observer->getRelationships(),
+      *context.memory->targetObject()
     );
   }
   
   /**
-   * Get the familiarity level for a relationship
+   * Get the familiarity level for a relationship, decayed to the current time
    */
-  inline float getFamiliarity(const std::optional<datamodel::relationship::Relationship::ref_type>& relationship) {
+  inline float getFamiliarity(
+    const std::optional<datamodel::relationship::Relationship::ref_type>& relationship,
+    uint64_t current_time,
+    const datamodel::relationship::RelationshipDecay& decay
+  ) {
     if (relationship) {
-      return relationship.value()->familiarity;
+      return datamodel::relationship::relationship_system::getFamiliarity(*relationship.value(), current_time, decay);
     }
     return 0.0f; // No relationship means no familiarity
   }
   
   /**
-   * Get the affective trace for a specific drive from a relationship
+   * Get the affective trace for a specific drive from a relationship,
+   * decayed to the current time
    */
   template<datamodel::npc::DriveTypeConcept T>
   inline float getAffectiveTrace(
     const std::optional<datamodel::relationship::Relationship::ref_type>& relationship,
-    const T& drive_type
+    const T& drive_type,
+    uint64_t current_time,
+    const datamodel::relationship::RelationshipDecay& decay
   ) {
     if (!relationship) {
       return 0.0f;
     }
     
-    // Look for the specific drive in the affective traces
-    for (const auto& trace : relationship.value()->affective_traces) {
-      if (std::visit([](const auto& a, const auto& b) { 
-          using A = std::decay_t<decltype(a)>;
-          using B = std::decay_t<decltype(b)>;
-          return std::is_same_v<A, B>; 
-        }, trace.drive_type, datamodel::npc::DriveType{drive_type})) {
-        return trace.value;
-      }
-    }
-    
-    return 0.0f;
+    return datamodel::relationship::relationship_system::getAffectiveTrace(
+      *relationship.value(),
+      datamodel::npc::DriveType{drive_type},
+      current_time,
+      decay
+    );
   }
   
   /**
    * Helper function to compare two drive types
    */
   inline bool areSameDriveTypes(const datamodel::npc::DriveType& a, const datamodel::npc::DriveType& b) {
-    return std::visit([](const auto& x, const auto& y) {
-      using X = std::decay_t<decltype(x)>;
-      using Y = std::decay_t<decltype(y)>;
-      return std::is_same_v<X, Y>;
-    }, a, b);
+    return a.index() == b.index();
   }
   
   // Action-specific impact functions using ADL
   
   // Observe action impacts
-  inline std::vector<datamodel::npc::Drive> getActionImpacts(
+  inline datamodel::npc::DriveSet getActionImpacts(
     const datamodel::action::action_type::Observe&, 
     const datamodel::drives::ActionContext& context
   ) {
-    std::vector<datamodel::npc::Drive> impacts;
+    datamodel::npc::DriveSet impacts;
     
     // Get relationships
     auto actor_rel = findActorRelationship(context);
@@ -141,25 +133,25 @@ namespace drive_impact_system {
     float curiosity_impact = -0.1f; // Baseline reduction in curiosity
     
     // Modify impact based on familiarity
-    float actor_familiarity = getFamiliarity(actor_rel);
-    float location_familiarity = getFamiliarity(location_rel);
+    float actor_familiarity = getFamiliarity(actor_rel, context.current_time, context.decay);
+    float location_familiarity = getFamiliarity(location_rel, context.current_time, context.decay);
     
     // Less familiar things reduce curiosity more (satisfy it better)
     float familiarity_factor = 1.0f - ((actor_familiarity + location_familiarity) / 2.0f);
     curiosity_impact *= (1.0f + familiarity_factor);
     
     // Add the impact
-    impacts.emplace_back(datamodel::npc::drive::Curiosity{}, curiosity_impact);
+    impacts.set(datamodel::npc::drive::Curiosity{}, curiosity_impact);
     
     return impacts;
   }
   
   // Follow action impacts
-  inline std::vector<datamodel::npc::Drive> getActionImpacts(
+  inline datamodel::npc::DriveSet getActionImpacts(
     const datamodel::action::action_type::Follow&, 
     const datamodel::drives::ActionContext& context
   ) {
-    std::vector<datamodel::npc::Drive> impacts;
+    datamodel::npc::DriveSet impacts;
     
     // Get actor relationship
     auto actor_rel = findActorRelationship(context);
@@ -168,24 +160,24 @@ namespace drive_impact_system {
     float belonging_impact = -0.2f; // Baseline reduction in belonging need
     
     // Modify impact based on familiarity
-    float actor_familiarity = getFamiliarity(actor_rel);
+    float actor_familiarity = getFamiliarity(actor_rel, context.current_time, context.decay);
     
     // More familiar NPCs provide stronger belonging satisfaction
     float familiarity_factor = actor_familiarity;
     belonging_impact *= (1.0f + familiarity_factor);
     
     // Add the impact
-    impacts.emplace_back(datamodel::npc::drive::Belonging{}, belonging_impact);
+    impacts.set(datamodel::npc::drive::Belonging{}, belonging_impact);
     
     return impacts;
   }
   
   // Rest action impacts
-  inline std::vector<datamodel::npc::Drive> getActionImpacts(
+  inline datamodel::npc::DriveSet getActionImpacts(
     const datamodel::action::action_type::Rest&, 
     const datamodel::drives::ActionContext& context
   ) {
-    std::vector<datamodel::npc::Drive> impacts;
+    datamodel::npc::DriveSet impacts;
     
     // Get location relationship
     auto location_rel = findLocationRelationship(context);
@@ -194,18 +186,18 @@ namespace drive_impact_system {
     float sustenance_impact = -0.3f; // Baseline reduction in sustenance need
     
     // Modify impact based on location familiarity
-    float location_familiarity = getFamiliarity(location_rel);
+    float location_familiarity = getFamiliarity(location_rel, context.current_time, context.decay);
     
     // More familiar locations provide better rest
     float familiarity_factor = location_familiarity;
     sustenance_impact *= (1.0f + familiarity_factor);
     
     // Add the sustenance impact
-    impacts.emplace_back(datamodel::npc::drive::Sustenance{}, sustenance_impact);
+    impacts.set(datamodel::npc::drive::Sustenance{}, sustenance_impact);
     
     // Familiar locations also provide shelter satisfaction
     if (location_familiarity > 0.3f) {
-      impacts.emplace_back(datamodel::npc::drive::Shelter{}, -0.2f * location_familiarity);
+      impacts.set(datamodel::npc::drive::Shelter{}, -0.2f * location_familiarity);
     }
     
     return impacts;
@@ -213,7 +205,7 @@ namespace drive_impact_system {
   
   // Default handler for actions without specific implementations
   template<typename T>
-  inline std::vector<datamodel::npc::Drive> getActionImpacts(
+  inline datamodel::npc::DriveSet getActionImpacts(
     const T&, 
     const datamodel::drives::ActionContext& context
   ) {
@@ -223,82 +215,111 @@ namespace drive_impact_system {
   
   /**
    * Adjust impacts based on current drive levels
+   * Higher drive intensity means higher impact magnitude
    */
-  inline std::vector<datamodel::npc::Drive> adjustImpacts(
-    const std::vector<datamodel::npc::Drive>& impacts,
-    const std::vector<datamodel::npc::Drive>& current_drives
+  inline datamodel::npc::DriveSet adjustImpacts(
+    const datamodel::npc::DriveSet& impacts,
+    const datamodel::npc::DriveSet& current_drives
   ) {
-    std::vector<datamodel::npc::Drive> adjusted_impacts;
-    adjusted_impacts.reserve(impacts.size());
+    datamodel::npc::DriveSet adjusted_impacts = impacts;
     
-    for (const auto& impact : impacts) {
-      bool found_matching_drive = false;
-      
-      // Find the current level of this drive
-      for (const auto& drive : current_drives) {
-        if (areSameDriveTypes(impact.type, drive.type)) {
-          // Higher drive intensity means higher impact magnitude
-          float intensity_factor = drive.intensity / 100.0f;
-          float new_intensity = impact.intensity * (1.0f + intensity_factor);
-          adjusted_impacts.emplace_back(impact.type, new_intensity);
-          found_matching_drive = true;
-          break;
-        }
-      }
-      
-      // If no matching drive was found, just copy the original impact
-      if (!found_matching_drive) {
-        adjusted_impacts.push_back(impact);
-      }
+    // Absent drives have intensity 0, which leaves the impact unchanged
+    for (size_t i = 0; i < datamodel::npc::DriveSet::SIZE; ++i) {
+      float intensity_factor = current_drives.values[i] / 100.0f;
+      adjusted_impacts.values[i] = impacts.values[i] * (1.0f + intensity_factor);
     }
     
     return adjusted_impacts;
   }
 
   /**
-   * Evaluate how an observation impacts the observer's drives
-   * using std::visit and argument-dependent lookup
+   * Weight for an observation spanning several ticks
+   * Grows sublinearly, so a long repeated observation counts for more than
+   * a single one without overwhelming everything else
    */
-  inline std::vector<datamodel::npc::Drive> evaluateImpact(const datamodel::drives::ActionContext& context) {
+  inline float getSpanWeight(const datamodel::memory::MemoryEntry::ref_type& memory) {
+    uint64_t span = memory->lastTimestamp() - memory->timestamp + 1;
+    return 1.0f + std::log(static_cast<float>(span));
+  }
+
+  /**
+   * Evaluate how an observation impacts the observer's drives, before
+   * accounting for the observer's current drive levels
+   * Depends only on the observation and the observer's relationships (as
+   * decayed to the observation's decay period)
+   */
+  inline datamodel::npc::DriveSet evaluateBaseImpact(const datamodel::drives::ActionContext& context) {
     // Get base impacts using std::visit with ADL
-    std::vector<datamodel::npc::Drive> base_impacts = std::visit(
+    datamodel::npc::DriveSet base_impacts = std::visit(
       [&context](const auto& action_type) {
         return getActionImpacts(action_type, context);
       },
-      context.memory->action
+      context.memory->action()
     );
     
+    // Scale by how long the observation lasted
+    float span_weight = getSpanWeight(context.memory);
+    for (auto& value : base_impacts.values) {
+      value *= span_weight;
+    }
+    
+    return base_impacts;
+  }
+  
+  /**
+   * Evaluate how an observation impacts the observer's drives
+   * using std::visit and argument-dependent lookup
+   */
+  inline datamodel::npc::DriveSet evaluateImpact(const datamodel::drives::ActionContext& context) {
     // Adjust impacts based on current drive levels
-    return adjustImpacts(base_impacts, context.observer->drives);
+    return adjustImpacts(evaluateBaseImpact(context), context.observer->getDrives());
   }
   
   /**
-   * Determine if a sequence of observations has emotional significance
+   * Folds the impacts of a sequence of observations into a single set
+   * The first impact on a drive is taken as is; each later one is added to it
+   * and the sum weighted (effectively averaging them, but with weight toward
+   * stronger impacts). Works in place, without allocating.
+   */
+  struct ImpactAccumulator {
+    // Weight applied when a drive was already impacted
+    static constexpr float REPEAT_WEIGHT = 0.6f;
+    
+    datamodel::npc::DriveSet combined;
+    
+    void add(const datamodel::npc::DriveSet& impacts) {
+      uint8_t repeated = combined.present & impacts.present;
+      for (size_t i = 0; i < datamodel::npc::DriveSet::SIZE; ++i) {
+        float weight = ((repeated >> i) & 1u) ? REPEAT_WEIGHT : 1.0f;
+        combined.values[i] = (combined.values[i] + impacts.values[i]) * weight;
+      }
+      combined.present |= impacts.present;
+    }
+    
+    const datamodel::npc::DriveSet& result() const {
+      return combined;
+    }
+  };
+  
+  /**
+   * Determine if a set of impacts has emotional significance
    * (i.e., is worth remembering as an episode)
    */
   inline bool hasEmotionalSignificance(
-    const std::vector<std::vector<datamodel::npc::Drive>>& impacts,
+    const datamodel::npc::DriveSet& impacts,
     float significance_threshold = 0.5f
   ) {
-    // Sum the total magnitude of impacts
-    float total_magnitude = 0.0f;
-    int total_impacts = 0;
-    
-    for (const auto& impact_set : impacts) {
-      for (const auto& impact : impact_set) {
-        total_magnitude += std::abs(impact.intensity);
-        total_impacts++;
-      }
+    if (impacts.empty()) {
+      return false;
     }
     
-    // Calculate the average impact
-    float avg_impact = 0.0f;
-    if (total_impacts > 0) {
-      avg_impact = total_magnitude / static_cast<float>(total_impacts);
+    float total_magnitude = 0.0f;
+    for (float value : impacts.values) {
+      total_magnitude += std::abs(value);
     }
     
-    // Consider significant if above threshold
-    return avg_impact >= significance_threshold;
+    // Consider significant if the average impact is above threshold
+    return total_magnitude / static_cast<float>(impacts.size()) >= significance_threshold;
   }
 
 } // namespace drive_impact_system
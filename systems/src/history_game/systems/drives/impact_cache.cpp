@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/systems/drives/impact_cache.cpp
+#include <history_game/systems/drives/impact_cache.h>
+
+namespace history_game::systems::drives {
+// Empty implementation file
+}
\ No newline at end of file
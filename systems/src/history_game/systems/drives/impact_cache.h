@@ -0,0 +1,249 @@
+#ifndef HISTORY_GAME_SYSTEMS_DRIVES_IMPACT_CACHE_H
+#define HISTORY_GAME_SYSTEMS_DRIVES_IMPACT_CACHE_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <functional>
+#include <unordered_map>
+#include <history_game/datamodel/npc/npc.h>
+#include <history_game/datamodel/npc/drive_set.h>
+#include <history_game/datamodel/memory/memory_entry.h>
+#include <history_game/datamodel/drives/action_context.h>
+#include <history_game/datamodel/relationship/relationship.h>
+#include <history_game/datamodel/relationship/relationship_store.h>
+#include <history_game/datamodel/entity/entity_handle.h>
+#include <history_game/systems/drives/drive_impact.h>
+
+namespace history_game::systems::drives {
+
+/**
+ * Per-NPC cache of the base impact of observations
+ *
+ * The base impact of an observation only depends on what was observed (the
+ * action, the handles of the actor and its target, the location relationship
+ * of the place it happened in and how long it lasted) and on the observer's
+ * relationships. Observations of the
+ * same thing share one entry, and each NPC's entries are dropped as soon as
+ * its relationships change or decay (which only happens at relationship
+ * decay period boundaries). The observer's current drive levels are applied
+ * after the lookup, so drives changing every tick do not invalidate anything.
+ * NPCs that made no lookup for a whole decay period are forgotten, so the
+ * entries of NPCs removed from the world do not stay behind.
+ */
+class ImpactCache {
+public:
+  explicit ImpactCache(size_t max_entries_per_npc = 512)
+    : max_entries(max_entries_per_npc) {}
+
+  ImpactCache(const ImpactCache&) = delete;
+  ImpactCache& operator=(const ImpactCache&) = delete;
+
+  /**
+   * Evaluate how an observation impacts the observer's drives
+   * Same result as drive_impact_system::evaluateImpact
+   */
+  datamodel::npc::DriveSet evaluateImpact(const datamodel::drives::ActionContext& context) {
+    return drive_impact_system::adjustImpacts(
+      getBaseImpact(context),
+      context.observer->getDrives()
+    );
+  }
+
+  /**
+   * Base impact of an observation, from the cache when possible
+   */
+  datamodel::npc::DriveSet getBaseImpact(const datamodel::drives::ActionContext& context) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    NPCEntries& npc_entries = getEntries(context);
+    ObservationKey key = makeKey(context);
+
+    auto it = npc_entries.entries.find(key);
+    if (it != npc_entries.entries.end()) {
+      hit_count++;
+      return it->second;
+    }
+
+    miss_count++;
+    if (npc_entries.entries.size() >= max_entries) {
+      npc_entries.entries.clear();
+    }
+
+    datamodel::npc::DriveSet impacts = drive_impact_system::evaluateBaseImpact(context);
+    npc_entries.entries.emplace(key, impacts);
+    return impacts;
+  }
+
+  /**
+   * Drop the entries of an NPC, e.g. one removed from the world
+   */
+  void evict(datamodel::entity::EntityHandle npc_handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    npcs.erase(npc_handle);
+  }
+
+  /**
+   * Number of NPCs with entries in the cache
+   */
+  size_t npcCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return npcs.size();
+  }
+
+  /**
+   * Number of lookups answered from the cache
+   */
+  uint64_t hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hit_count;
+  }
+
+  /**
+   * Number of lookups that had to evaluate the observation
+   */
+  uint64_t misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return miss_count;
+  }
+
+private:
+  // What an observation's base impact depends on, besides relationships
+  struct ObservationKey {
+    size_t action;
+    datamodel::entity::EntityHandle actor;
+    datamodel::entity::EntityHandle target;
+
+    // Location relationship matching where it happened (null for none)
+    // The NPC's entries hold its relationship index, so the address is not reused
+    const void* location;
+
+    uint64_t span;
+
+    bool operator==(const ObservationKey& other) const {
+      return action == other.action && actor == other.actor &&
+             target == other.target && location == other.location &&
+             span == other.span;
+    }
+  };
+
+  struct ObservationKeyHash {
+    size_t operator()(const ObservationKey& key) const {
+      size_t hash = std::hash<datamodel::entity::EntityHandle>{}(key.actor);
+      hash = hash * 31 + std::hash<datamodel::entity::EntityHandle>{}(key.target);
+      hash = hash * 31 + std::hash<const void*>{}(key.location);
+      hash = hash * 31 + key.action;
+      return hash * 31 + std::hash<uint64_t>{}(key.span);
+    }
+  };
+
+  struct NPCEntries {
+    // Relationships the entries were computed with (none for an NPC without any)
+    // Held so the index is not freed and its identity reused by another one
+    std::optional<datamodel::relationship::RelationshipIndex::ref_type> relationships;
+
+    // Relationship decay period the entries were computed in
+    uint64_t decay_step = 0;
+
+    std::unordered_map<ObservationKey, datamodel::npc::DriveSet, ObservationKeyHash> entries;
+  };
+
+  static ObservationKey makeKey(const datamodel::drives::ActionContext& context) {
+    const datamodel::memory::MemoryEntry& memory = *context.memory;
+    const auto* target_entity = memory.targetEntity();
+
+    // Moving entities stay on the same entry as long as they match the same place
+    auto location = drive_impact_system::findLocationRelationship(context);
+
+    datamodel::entity::EntityHandle target;
+    if (target_entity) {
+      target = *target_entity;
+    } else if (const auto* target_object = memory.targetObject()) {
+      target = *target_object;
+    }
+
+    return ObservationKey{
+      memory.actionIndex(),
+      memory.actorHandle(),
+      target,
+      location ? static_cast<const void*>(&*location.value()) : nullptr,
+      memory.lastTimestamp() - memory.timestamp
+    };
+  }
+
+  // Relationship stores are immutable, so equal indexes mean equal relationships
+  static bool sameRelationships(
+    const std::optional<datamodel::relationship::RelationshipIndex::ref_type>& a,
+    const std::optional<datamodel::relationship::RelationshipIndex::ref_type>& b
+  ) {
+    if (!a || !b) {
+      return !a && !b;
+    }
+    return a.value() == b.value();
+  }
+
+  // Forgets the NPCs that made no lookup during the previous decay period
+  void sweepIdleNPCs(uint64_t decay_step) {
+    for (auto it = npcs.begin(); it != npcs.end();) {
+      if (it->second.decay_step + 1 < decay_step) {
+        it = npcs.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    sweep_step = decay_step;
+  }
+
+  // Entries of an NPC, dropped if its relationships changed or decayed since they were computed
+  NPCEntries& getEntries(const datamodel::drives::ActionContext& context) {
+    const datamodel::npc::NPC::ref_type& npc = context.observer;
+
+    // Decayed relationships only change from one decay period to the next
+    uint64_t decay_step = context.current_time / context.decay.period;
+    if (decay_step > sweep_step) {
+      sweepIdleNPCs(decay_step);
+    }
+
+    auto [found, inserted] = npcs.try_emplace(npc->getIdentity()->entity->handle);
+    NPCEntries& npc_entries = found->second;
+    if (inserted) {
+      if (npc->getRelationships().index) {
+        npc_entries.relationships.emplace(npc->getRelationships().index.value());
+      }
+      npc_entries.decay_step = decay_step;
+      return npc_entries;
+    }
+
+    if (npc_entries.decay_step != decay_step) {
+      if (npc->getRelationships().index) {
+        npc_entries.entries.clear();
+      }
+      npc_entries.decay_step = decay_step;
+    }
+
+    if (!sameRelationships(npc_entries.relationships, npc->getRelationships().index)) {
+      npc_entries.entries.clear();
+      npc_entries.relationships.reset();
+      if (npc->getRelationships().index) {
+        npc_entries.relationships.emplace(npc->getRelationships().index.value());
+      }
+    }
+    return npc_entries;
+  }
+
+  const size_t max_entries;
+  std::unordered_map<datamodel::entity::EntityHandle, NPCEntries> npcs;
+
+  // Decay period of the last sweep of idle NPCs
+  uint64_t sweep_step = 0;
+  uint64_t hit_count = 0;
+  uint64_t miss_count = 0;
+  mutable std::mutex mutex;
+};
+
+} // namespace history_game::systems::drives
+
+#endif // HISTORY_GAME_SYSTEMS_DRIVES_IMPACT_CACHE_H
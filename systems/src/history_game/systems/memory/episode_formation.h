@@ -2,15 +2,23 @@
 #define HISTORY_GAME_SYSTEMS_MEMORY_EPISODE_FORMATION_H
 
 #include <vector>
+#include <optional>
 #include <algorithm>
 #include <cpioo/managed_entity.hpp>
 #include <spdlog/spdlog.h>
 #include <history_game/datamodel/npc/npc.h>
 #include <history_game/datamodel/memory/memory_entry.h>
 #include <history_game/datamodel/memory/memory_episode.h>
+#include <history_game/datamodel/memory/episode_store.h>
+#include <history_game/datamodel/memory/segmentation_state.h>
 #include <history_game/datamodel/memory/perception_buffer.h>
 #include <history_game/datamodel/action/action_sequence.h>
+#include <history_game/datamodel/action/sequence_fingerprint.h>
+#include <history_game/datamodel/world/world.h>
 #include <history_game/systems/drives/drive_impact.h>
+#include <history_game/systems/drives/impact_cache.h>
+#include <history_game/systems/memory/memory_system.h>
+#include <history_game/systems/memory/sequence_trie.h>
 
 namespace history_game::systems::memory {
 
@@ -73,7 +81,10 @@ namespace history_game::systems::memory {
         const auto& last_action = current_sequence.back();
         
         // Check if this action is close enough in time to be part of the sequence
-        if (perception->timestamp - last_action->timestamp <= max_sequence_gap) {
+        // (measured from the end of the last one, which may span several ticks)
+        uint64_t gap = perception->timestamp > last_action->lastTimestamp() ?
+          perception->timestamp - last_action->lastTimestamp() : 0;
+        if (gap <= max_sequence_gap) {
           // Add to the current sequence
           current_sequence.push_back(perception);
         } else {
@@ -112,7 +123,10 @@ namespace history_game::systems::memory {
     
     // Add subsequent steps with calculated delays
     for (size_t i = 1; i < entries.size(); ++i) {
-      uint32_t delay = static_cast<uint32_t>(entries[i]->timestamp - entries[i-1]->timestamp);
+      // Delay counts from the end of the previous step
+      uint64_t previous_end = entries[i-1]->lastTimestamp();
+      uint32_t delay = entries[i]->timestamp > previous_end ?
+        static_cast<uint32_t>(entries[i]->timestamp - previous_end) : 0;
       steps.emplace_back(entries[i], delay);
     }
     
@@ -123,83 +137,53 @@ namespace history_game::systems::memory {
   
   /**
    * Evaluate the emotional impact of a sequence of memory entries
+   * Actors and targets are looked up in the given world.
+   * Observations already evaluated for this NPC are looked up in the impact cache, if given
    */
-  inline std::vector<datamodel::npc::Drive> evaluateSequenceImpact(
+  inline datamodel::npc::DriveSet evaluateSequenceImpact(
     const datamodel::npc::NPC::ref_type& npc,
+    const datamodel::world::World& world,
     const std::vector<datamodel::memory::MemoryEntry::ref_type>& sequence,
-    uint64_t current_time
+    uint64_t current_time,
+    const datamodel::relationship::RelationshipDecay& decay,
+    drives::ImpactCache* impact_cache = nullptr
   ) {
-    // Calculate individual impacts for each memory in the sequence
-    std::vector<std::vector<datamodel::npc::Drive>> all_impacts;
+    drives::drive_impact_system::ImpactAccumulator accumulator;
     
     for (const auto& memory : sequence) {
-      datamodel::drives::ActionContext context(npc, memory, current_time);
-      all_impacts.push_back(drives::drive_impact_system::evaluateImpact(context));
+      datamodel::drives::ActionContext context(npc, memory, world, current_time, decay);
+      accumulator.add(impact_cache ?
+        impact_cache->evaluateImpact(context) :
+        drives::drive_impact_system::evaluateImpact(context));
     }
     
-    // Combine all impacts into a single vector
-    std::vector<datamodel::npc::Drive> combined_impacts;
-    
-    // Track which drive types we've already processed
-    std::vector<datamodel::npc::DriveType> processed_types;
-    
-    // For each impact set
-    for (const auto& impacts : all_impacts) {
-      for (const auto& impact : impacts) {
-        // Check if we've already seen this drive type
-        auto it = std::find_if(processed_types.begin(), processed_types.end(),
-          [&impact](const datamodel::npc::DriveType& type) {
-            return drives::drive_impact_system::areSameDriveTypes(type, impact.type);
-          });
-        
-        if (it == processed_types.end()) {
-          // First time seeing this drive type, add it to combined impacts
-          combined_impacts.push_back(impact);
-          processed_types.push_back(impact.type);
-        } else {
-          // We've seen this drive type before, find it in combined impacts and add to it
-          for (auto& combined_impact : combined_impacts) {
-            if (drives::drive_impact_system::areSameDriveTypes(combined_impact.type, impact.type)) {
-              // Add the impacts (effectively averaging them, but with weight toward stronger impacts)
-              float new_intensity = (combined_impact.intensity + impact.intensity) * 0.6f;
-              
-              // Create a new vector with the updated impact
-              std::vector<datamodel::npc::Drive> new_impacts;
-              new_impacts.reserve(combined_impacts.size());
-              
-              for (size_t i = 0; i < combined_impacts.size(); ++i) {
-                if (i == &combined_impact - &combined_impacts[0]) {
-                  // Replace with updated drive
-                  new_impacts.emplace_back(combined_impact.type, new_intensity);
-                } else {
-                  // Copy other drives unchanged
-                  new_impacts.push_back(combined_impacts[i]);
-                }
-              }
-              
-              // Replace the vector
-              combined_impacts = std::move(new_impacts);
-              break;
-            }
-          }
-        }
-      }
+    return accumulator.result();
+  }
+  
+  /**
+   * Last tick covered by a sequence of observations (spans may end after later entries)
+   */
+  inline uint64_t getSequenceEndTime(const std::vector<datamodel::memory::MemoryEntry::ref_type>& sequence) {
+    uint64_t end_time = sequence.back()->lastTimestamp();
+    for (const auto& entry : sequence) {
+      end_time = std::max<uint64_t>(end_time, entry->lastTimestamp());
     }
-    
-    return combined_impacts;
+    return end_time;
   }
   
   /**
-   * Create a memory episode from a sequence of observations
+   * Create a memory episode from a sequence of observations and its action sequence
+   * @param fingerprint The fingerprint of the action sequence
    */
   inline datamodel::memory::MemoryEpisode::ref_type createMemoryEpisode(
     const std::vector<datamodel::memory::MemoryEntry::ref_type>& sequence,
-    const std::vector<datamodel::npc::Drive>& impacts,
-    const std::string& sequence_id,
+    const datamodel::npc::DriveSet& impacts,
+    const datamodel::action::ActionSequence::ref_type& action_sequence,
+    const datamodel::action::SequenceFingerprint& fingerprint,
     uint32_t repetition_count = 1
   ) {
     // Log memory episode creation
-    std::string npc_id = sequence.front()->actor->entity->id;
+    const std::string& sequence_id = action_sequence->id;
     std::string impact_summary;
     
     for (const auto& impact : impacts) {
@@ -207,159 +191,291 @@ namespace history_game::systems::memory {
                         std::to_string(impact.intensity) + " ";
     }
     
-    spdlog::info("NPC {} forms memory episode (id: {}, impacts: {})", 
-                 npc_id, sequence_id, impact_summary);
-    // Calculate start and end times
-    uint64_t start_time = sequence.front()->timestamp;
-    uint64_t end_time = sequence.back()->timestamp;
-    
-    // Create an action sequence
-    auto action_sequence = createActionSequence(sequence, sequence_id);
-    
+    spdlog::info("Memory episode formed (id: {}, impacts: {})", 
+                 sequence_id, impact_summary);
     // Create the memory episode
     datamodel::memory::MemoryEpisode episode(
-      start_time,
-      end_time,
+      sequence.front()->timestamp,
+      getSequenceEndTime(sequence),
       action_sequence,
       impacts,
-      repetition_count
+      repetition_count,
+      fingerprint
     );
     
     return datamodel::memory::MemoryEpisode::storage::make_entity(std::move(episode));
   }
   
   /**
-   * Find similar episodes in an NPC's memory
-   * Returns a matching episode if found, or nullptr if no match
+   * Create a memory episode from a sequence of observations and its action sequence
    */
-  inline datamodel::memory::MemoryEpisode::ref_type findSimilarEpisode(
-    const std::vector<datamodel::memory::MemoryEpisode::ref_type>& episodes,
+  inline datamodel::memory::MemoryEpisode::ref_type createMemoryEpisode(
+    const std::vector<datamodel::memory::MemoryEntry::ref_type>& sequence,
+    const datamodel::npc::DriveSet& impacts,
+    const datamodel::action::ActionSequence::ref_type& action_sequence,
+    uint32_t repetition_count = 1
+  ) {
+    return createMemoryEpisode(
+      sequence,
+      impacts,
+      action_sequence,
+      datamodel::action::sequence_fingerprint_system::computeFingerprint(action_sequence),
+      repetition_count
+    );
+  }
+  
+  /**
+   * Create a memory episode from a sequence of observations
+   */
+  inline datamodel::memory::MemoryEpisode::ref_type createMemoryEpisode(
+    const std::vector<datamodel::memory::MemoryEntry::ref_type>& sequence,
+    const datamodel::npc::DriveSet& impacts,
+    const std::string& sequence_id,
+    uint32_t repetition_count = 1
+  ) {
+    return createMemoryEpisode(
+      sequence,
+      impacts,
+      createActionSequence(sequence, sequence_id),
+      repetition_count
+    );
+  }
+  
+  /**
+   * Find the episode in an NPC's memory that records a similar sequence
+   * The same sequence is matched by its signature; otherwise the most similar
+   * episode by fingerprint is returned if it reaches the similarity threshold
+   */
+  inline std::optional<datamodel::memory::MemoryEpisode::ref_type> findSimilarEpisode(
+    const datamodel::memory::EpisodeStore& episodes,
     const datamodel::action::ActionSequence::ref_type& sequence,
     float similarity_threshold = 0.7f
   ) {
-    // For now, a simple implementation that just checks if the sequences have the same number of steps
-    // A more sophisticated implementation would compare the actual actions
-    for (const auto& episode : episodes) {
-      const auto& episode_sequence = episode->action_sequence;
+    return datamodel::memory::episode_store_system::findSimilar(episodes, sequence, similarity_threshold);
+  }
+  
+  /**
+   * Find the episode that records a similar sequence, given its fingerprint
+   */
+  inline std::optional<datamodel::memory::MemoryEpisode::ref_type> findSimilarEpisode(
+    const datamodel::memory::EpisodeStore& episodes,
+    const datamodel::action::ActionSequence::ref_type& sequence,
+    const datamodel::action::SequenceFingerprint& fingerprint,
+    float similarity_threshold = 0.7f
+  ) {
+    return datamodel::memory::episode_store_system::findSimilar(
+      episodes, sequence, fingerprint, similarity_threshold
+    );
+  }
+  
+  /**
+   * Sequences closed by one segmentation step, and the state to resume from
+   */
+  struct SegmentationResult {
+    // Sequences that can no longer grow and are long enough to form episodes
+    std::vector<std::vector<datamodel::memory::MemoryEntry::ref_type>> closed_sequences;
+    
+    // State for the next step (unset when nothing changed)
+    std::optional<datamodel::memory::SegmentationState::ref_type> state;
+  };
+  
+  /**
+   * Extend the open action sequence with perceptions newer than the watermark
+   * 
+   * Only entries that ended after the watermark are looked at. A sequence is
+   * closed when the next entry comes more than max_sequence_gap ticks after it,
+   * when it reaches max_sequence_length, or when current_time is already too far
+   * from its last entry for anything else to join it.
+   */
+  inline SegmentationResult segmentNewPerceptions(
+    const datamodel::memory::PerceptionBuffer::ref_type& buffer,
+    const std::optional<datamodel::memory::SegmentationState::ref_type>& previous_state,
+    uint64_t current_time,
+    uint64_t max_sequence_gap = 5,
+    size_t min_sequence_length = 2,
+    size_t max_sequence_length = 16
+  ) {
+    const auto& perceptions = buffer->recent_perceptions;
+    
+    std::optional<uint64_t> watermark;
+    if (previous_state) {
+      watermark = previous_state.value()->watermark;
+    }
+    std::vector<datamodel::memory::MemoryEntry::ref_type> open_sequence = previous_state ?
+      previous_state.value()->open_sequence :
+      std::vector<datamodel::memory::MemoryEntry::ref_type>();
+    
+    // Collect the entries that ended after the watermark, in time order
+    std::vector<size_t> fresh;
+    for (size_t i = 0; i < perceptions.size(); ++i) {
+      if (!watermark || perceptions[i]->lastTimestamp() > watermark.value()) {
+        fresh.push_back(i);
+      }
+    }
+    std::stable_sort(fresh.begin(), fresh.end(),
+      [&perceptions](size_t a, size_t b) {
+        return perceptions[a]->timestamp < perceptions[b]->timestamp;
+      });
+    
+    SegmentationResult result;
+    bool changed = !fresh.empty();
+    
+    auto close_sequence = [&]() {
+      if (open_sequence.size() >= min_sequence_length) {
+        result.closed_sequences.push_back(std::move(open_sequence));
+      }
+      open_sequence.clear();
+    };
+    
+    for (size_t index : fresh) {
+      const auto& entry = perceptions[index];
+      watermark = std::max(watermark.value_or(0), entry->lastTimestamp());
+      
+      // A coalesced observation replaces the shorter version it extends, which
+      // need not be the last entry when several observations continue at once
+      auto earlier = std::find_if(open_sequence.begin(), open_sequence.end(),
+        [&entry](const datamodel::memory::MemoryEntry::ref_type& open) {
+          return open->timestamp == entry->timestamp && isSameObservation(open, entry);
+        });
+      if (earlier != open_sequence.end()) {
+        std::vector<datamodel::memory::MemoryEntry::ref_type> replaced;
+        replaced.reserve(open_sequence.size());
+        for (auto it = open_sequence.begin(); it != open_sequence.end(); ++it) {
+          replaced.push_back(it == earlier ? entry : *it);
+        }
+        open_sequence = std::move(replaced);
+        continue;
+      }
       
-      // Check if the sequences have the same number of steps
-      if (episode_sequence->steps.size() == sequence->steps.size()) {
-        // Consider them similar for now
-        // TODO: Implement a more sophisticated comparison
-        return episode;
+      if (!open_sequence.empty()) {
+        const auto& last = open_sequence.back();
+        
+        uint64_t gap = entry->timestamp > last->lastTimestamp() ?
+          entry->timestamp - last->lastTimestamp() : 0;
+        if (gap > max_sequence_gap || open_sequence.size() >= max_sequence_length) {
+          close_sequence();
+        }
       }
+      
+      open_sequence.push_back(entry);
     }
     
-    // No similar episode found - just pick the first episode if any exist
-    // This is a workaround for the fact that we can't return a null reference
-    if (!episodes.empty()) {
-      return episodes[0];
+    // Nothing perceived from now on can join a sequence that ended too long ago
+    if (!open_sequence.empty() &&
+        current_time > open_sequence.back()->lastTimestamp() + max_sequence_gap) {
+      close_sequence();
+      changed = true;
     }
     
-    // If no episodes exist, create a dummy sequence and episode that we'll never use
-    // First create an empty action sequence with a special ID
-    datamodel::action::ActionSequence dummy_sequence("__dummy__", {});
-    auto dummy_sequence_ref = datamodel::action::ActionSequence::storage::make_entity(std::move(dummy_sequence));
+    if (changed) {
+      datamodel::memory::SegmentationState state(watermark, std::move(open_sequence));
+      result.state.emplace(datamodel::memory::SegmentationState::storage::make_entity(std::move(state)));
+    }
     
-    // Now create a dummy episode with the sequence and special repetition_count of 0
-    datamodel::memory::MemoryEpisode dummy(0, 0, dummy_sequence_ref, {}, 0);
-    return datamodel::memory::MemoryEpisode::storage::make_entity(std::move(dummy));
+    return result;
   }
   
   /**
    * Process an NPC's perceptions to form new episodic memories
+   * Only perceptions newer than the NPC's segmentation watermark are looked at,
+   * and an episode is formed once its sequence is closed.
+   * When a sequence trie is given, new episodes are counted in it; each NPC
+   * keeps its own action sequence.
    * Returns an updated NPC with new or updated episodic memories
    */
   inline datamodel::npc::NPC::ref_type formEpisodicMemories(
     const datamodel::npc::NPC::ref_type& npc,
+    const datamodel::world::World& world,
     uint64_t current_time,
+    const datamodel::relationship::RelationshipDecay& decay,
     float significance_threshold = 0.3f,
     uint64_t max_sequence_gap = 5,
-    size_t min_sequence_length = 2
+    size_t min_sequence_length = 2,
+    size_t max_sequence_length = 16,
+    SequenceTrie* sequence_trie = nullptr,
+    drives::ImpactCache* impact_cache = nullptr
   ) {
-    // Identify potential action sequences
-    auto sequences = identifyActionSequences(
-      npc->perception,
+    // Segment the perceptions that arrived since the last update
+    auto segmentation = segmentNewPerceptions(
+      npc->getPerception(),
+      npc->getSegmentation(),
+      current_time,
       max_sequence_gap,
-      min_sequence_length
+      min_sequence_length,
+      max_sequence_length
     );
     
-    if (sequences.empty()) {
-      // No potential sequences, return unchanged NPC
+    if (!segmentation.state) {
+      // Nothing new was perceived, return unchanged NPC
       return npc;
     }
     
-    // New episodes to add
-    std::vector<datamodel::memory::MemoryEpisode::ref_type> new_episodes;
+    const auto& sequences = segmentation.closed_sequences;
+    
+    // Episodic memory being updated; repeated episodes are replaced in place
+    std::optional<datamodel::memory::EpisodeStore> episodes;
+    episodes.emplace(npc->getEpisodicMemory());
     
     // Process each potential sequence
     for (const auto& sequence : sequences) {
       // Evaluate the emotional impact
-      auto impacts = evaluateSequenceImpact(npc, sequence, current_time);
+      auto impacts = evaluateSequenceImpact(npc, world, sequence, current_time, decay, impact_cache);
       
       // Check if it has enough emotional significance
-      if (drives::drive_impact_system::hasEmotionalSignificance({impacts}, significance_threshold)) {
+      if (drives::drive_impact_system::hasEmotionalSignificance(impacts, significance_threshold)) {
         // Create a unique ID for this sequence
         std::string sequence_id = "seq_" + std::to_string(current_time) + "_" + 
                                    std::to_string(sequence.size());
         
         // Create an action sequence for similarity checking
         auto action_sequence = createActionSequence(sequence, sequence_id);
+        auto fingerprint = datamodel::action::sequence_fingerprint_system::computeFingerprint(action_sequence);
         
         // Check if this is similar to an existing episode
-        auto similar_episode = findSimilarEpisode(npc->episodic_memory, action_sequence);
+        auto similar_episode = findSimilarEpisode(episodes.value(), action_sequence, fingerprint);
         
-        // Since we can't return a null reference, we need a way to check if it's a "real" episode
-        // The dummy one we return has repetition_count of 0, which is never valid for a real episode
-        if (similar_episode->repetition_count > 0) {
-          // Update the existing episode with a higher repetition count
+        if (similar_episode) {
+          // Replace the existing episode with one of higher repetition count
           datamodel::memory::MemoryEpisode updated_episode(
-            similar_episode->start_time,
-            similar_episode->end_time,
-            similar_episode->action_sequence,
-            similar_episode->drive_impacts,
-            similar_episode->repetition_count + 1
+            similar_episode.value()->start_time,
+            getSequenceEndTime(sequence),
+            similar_episode.value()->action_sequence,
+            similar_episode.value()->drive_impacts,
+            similar_episode.value()->repetition_count + 1,
+            similar_episode.value()->fingerprint
           );
           
-          new_episodes.push_back(
+          episodes.emplace(datamodel::memory::episode_store_system::insert(
+            episodes.value(),
             datamodel::memory::MemoryEpisode::storage::make_entity(std::move(updated_episode))
-          );
+          ));
         } else {
           // This is a new type of episode
-          new_episodes.push_back(
-            createMemoryEpisode(sequence, impacts, sequence_id)
-          );
+          if (sequence_trie) {
+            sequence_trie->intern(action_sequence, npc->getIdentity()->entity->handle);
+          }
+          episodes.emplace(datamodel::memory::episode_store_system::insert(
+            episodes.value(),
+            createMemoryEpisode(
+              sequence,
+              impacts,
+              action_sequence,
+              fingerprint
+            )
+          ));
         }
       }
     }
     
-    if (new_episodes.empty()) {
-      // No significant episodes formed, return unchanged NPC
-      return npc;
-    }
-    
-    // Combine existing episodes with new ones
-    std::vector<datamodel::memory::MemoryEpisode::ref_type> updated_episodes;
-    updated_episodes.reserve(npc->episodic_memory.size() + new_episodes.size());
-    
-    // Copy existing episodes
-    for (const auto& episode : npc->episodic_memory) {
-      updated_episodes.push_back(episode);
-    }
-    
-    // Add new episodes
-    for (const auto& episode : new_episodes) {
-      updated_episodes.push_back(episode);
-    }
-    
-    // Create updated NPC with new episodic memories
+    // Create updated NPC with new episodic memories and segmentation state
     datamodel::npc::NPC updated_npc(
-      npc->identity,
-      npc->drives,
-      npc->perception,
-      updated_episodes,
-      npc->observed_behaviors,
-      npc->relationships
+      npc->getIdentity(),
+      npc->getDrives(),
+      npc->getPerception(),
+      episodes.value(),
+      npc->getObservedBehaviors(),
+      npc->getRelationships(),
+      segmentation.state
     );
     
     return datamodel::npc::NPC::storage::make_entity(std::move(updated_npc));
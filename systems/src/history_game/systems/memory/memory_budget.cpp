@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/systems/memory/memory_budget.cpp
+#include <history_game/systems/memory/memory_budget.h>
+
+namespace history_game::systems::memory {
+// Empty implementation file
+}
\ No newline at end of file
@@ -0,0 +1,406 @@
+#ifndef HISTORY_GAME_SYSTEMS_MEMORY_MEMORY_BUDGET_H
+#define HISTORY_GAME_SYSTEMS_MEMORY_MEMORY_BUDGET_H
+
+#include <cmath>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include <history_game/datamodel/npc/npc.h>
+#include <history_game/datamodel/memory/memory_episode.h>
+#include <history_game/datamodel/memory/witnessed_sequence.h>
+#include <history_game/datamodel/action/action_sequence.h>
+#include <history_game/datamodel/relationship/relationship.h>
+#include <history_game/systems/memory/sequence_trie.h>
+
+namespace history_game::systems::memory {
+
+/**
+ * Per-NPC limits on long-term memory, and how to choose what to forget
+ */
+struct MemoryBudget {
+  // Maximum number of entries per collection
+  const size_t max_episodes;
+  const size_t max_observed_behaviors;
+  const size_t max_relationships;
+
+  // Maximum estimated bytes held by the three collections together
+  const size_t max_bytes;
+
+  // Weights of the retention score
+  const float repetition_weight;
+  const float impact_weight;
+  const float recency_weight;
+
+  // Ticks after which an untouched memory has lost half its recency
+  const float recency_half_life;
+
+  // Constructor with default values
+  MemoryBudget(
+    size_t episodes = 64,
+    size_t behaviors = 64,
+    size_t relationships = 128,
+    size_t bytes = 256 * 1024,
+    float repetition = 1.0f,
+    float impact = 1.0f,
+    float recency = 1.0f,
+    float half_life = 100.0f
+  ) : max_episodes(episodes),
+      max_observed_behaviors(behaviors),
+      max_relationships(relationships),
+      max_bytes(bytes),
+      repetition_weight(repetition),
+      impact_weight(impact),
+      recency_weight(recency),
+      recency_half_life(half_life) {}
+};
+
+/**
+ * Running totals of evicted memories, for telemetry
+ */
+struct EvictionStats {
+  std::atomic<uint64_t> episodes{0};
+  std::atomic<uint64_t> observed_behaviors{0};
+  std::atomic<uint64_t> relationships{0};
+  std::atomic<uint64_t> bytes{0};
+};
+
+namespace memory_budget_system {
+
+  /**
+   * Eviction counters shared by every NPC
+   */
+  inline EvictionStats& getEvictionStats() {
+    static EvictionStats stats;
+    return stats;
+  }
+
+  /**
+   * Reset the eviction counters
+   */
+  inline void resetEvictionStats() {
+    auto& stats = getEvictionStats();
+    stats.episodes = 0;
+    stats.observed_behaviors = 0;
+    stats.relationships = 0;
+    stats.bytes = 0;
+  }
+
+  /**
+   * Estimate the bytes held by an action sequence
+   * Sequences are never shared between NPCs (the sequence trie only counts
+   * them), so each one is charged to the episode that holds it.
+   */
+  inline size_t estimateBytes(const datamodel::action::ActionSequence::ref_type& sequence) {
+    return sizeof(datamodel::action::ActionSequence) +
+           sequence->id.capacity() +
+           sequence->steps.capacity() * sizeof(datamodel::action::ActionStep);
+  }
+
+  /**
+   * Estimate the bytes held by an episode
+   */
+  inline size_t estimateBytes(const datamodel::memory::MemoryEpisode::ref_type& episode) {
+    return sizeof(datamodel::memory::MemoryEpisode) +
+           estimateBytes(episode->action_sequence);
+  }
+
+  /**
+   * Estimate the bytes held by an observed behavior
+   */
+  inline size_t estimateBytes(const datamodel::memory::WitnessedSequence::ref_type& behavior) {
+    return sizeof(datamodel::memory::WitnessedSequence) +
+           behavior->effectiveness.heapCapacity() * sizeof(datamodel::memory::PerceivedEffectiveness) +
+           estimateBytes(behavior->sequence);
+  }
+
+  /**
+   * Estimate the bytes held by a relationship
+   */
+  inline size_t estimateBytes(const datamodel::relationship::Relationship::ref_type& relationship) {
+    return sizeof(datamodel::relationship::Relationship) +
+           relationship->affective_traces.heapCapacity() * sizeof(datamodel::relationship::AffectiveTrace);
+  }
+
+  /**
+   * Estimate the bytes held by an NPC's long-term memory
+   */
+  inline size_t estimateBytes(const datamodel::npc::NPC::ref_type& npc) {
+    size_t total = 0;
+    for (const auto& episode : npc->getEpisodicMemory()) {
+      total += estimateBytes(episode);
+    }
+    for (const auto& behavior : npc->getObservedBehaviors()) {
+      total += estimateBytes(behavior);
+    }
+    for (const auto& relationship : npc->getRelationships()) {
+      total += estimateBytes(relationship);
+    }
+    return total;
+  }
+
+  /**
+   * Combine repetitions, impact and age into a retention score
+   * Higher scores are kept longer
+   */
+  inline float retentionScore(
+    uint32_t repetitions,
+    float impact_magnitude,
+    uint64_t last_time,
+    uint64_t current_time,
+    const MemoryBudget& budget
+  ) {
+    float age = current_time > last_time ? static_cast<float>(current_time - last_time) : 0.0f;
+    float recency = budget.recency_half_life > 0.0f ?
+      std::exp2(-age / budget.recency_half_life) : 0.0f;
+
+    return budget.repetition_weight * std::log1p(static_cast<float>(repetitions)) +
+           budget.impact_weight * impact_magnitude +
+           budget.recency_weight * recency;
+  }
+
+  /**
+   * Retention score overloads for argument-dependent lookup
+   */
+  inline float scoreMemory(
+    const datamodel::memory::MemoryEpisode::ref_type& episode,
+    uint64_t current_time,
+    const MemoryBudget& budget
+  ) {
+    float magnitude = 0.0f;
+    for (float impact : episode->drive_impacts.values) {
+      magnitude += std::abs(impact);
+    }
+    return retentionScore(episode->repetition_count, magnitude, episode->end_time, current_time, budget);
+  }
+
+  inline float scoreMemory(
+    const datamodel::memory::WitnessedSequence::ref_type& behavior,
+    uint64_t current_time,
+    const MemoryBudget& budget
+  ) {
+    float magnitude = 0.0f;
+    for (const auto& effectiveness : behavior->effectiveness) {
+      magnitude += std::abs(effectiveness.value);
+    }
+
+    // The last witnessed step tells how recent the behavior is
+    uint64_t last_time = 0;
+    if (!behavior->sequence->steps.empty()) {
+      last_time = behavior->sequence->steps.back().memory->lastTimestamp();
+    }
+    return retentionScore(behavior->observation_count, magnitude, last_time, current_time, budget);
+  }
+
+  inline float scoreMemory(
+    const datamodel::relationship::Relationship::ref_type& relationship,
+    uint64_t current_time,
+    const MemoryBudget& budget,
+    const datamodel::relationship::RelationshipDecay& decay
+  ) {
+    // Relationships that faded are worth less
+    float magnitude = datamodel::relationship::relationship_system::getFamiliarity(*relationship, current_time, decay);
+    float trace_decay = datamodel::relationship::relationship_system::getDecayFactor(
+      relationship->last_interaction,
+      current_time,
+      decay.trace_half_life,
+      decay
+    );
+    for (const auto& trace : relationship->affective_traces) {
+      magnitude += std::abs(trace.value) * trace_decay;
+    }
+    return retentionScore(relationship->interaction_count, magnitude, relationship->last_interaction, current_time, budget);
+  }
+
+  /**
+   * A memory that may be evicted
+   */
+  struct EvictionCandidate {
+    float score;
+    size_t bytes;
+    size_t collection;
+    size_t index;
+  };
+
+  /**
+   * Collect eviction candidates from one collection
+   * @param score Retention score of one memory of the collection
+   */
+  template<typename T, typename Score>
+  inline void collectCandidates(
+    const std::vector<T>& memories,
+    size_t collection,
+    Score score,
+    std::vector<EvictionCandidate>& candidates
+  ) {
+    for (size_t i = 0; i < memories.size(); ++i) {
+      candidates.push_back({
+        score(memories[i]),
+        estimateBytes(memories[i]),
+        collection,
+        i
+      });
+    }
+  }
+
+  /**
+   * Copy the memories that were not evicted, keeping their order
+   */
+  template<typename T>
+  inline std::vector<T> keepSurvivors(
+    const std::vector<T>& memories,
+    const std::vector<bool>& evicted
+  ) {
+    std::vector<T> survivors;
+    survivors.reserve(memories.size());
+    for (size_t i = 0; i < memories.size(); ++i) {
+      if (!evicted[i]) {
+        survivors.push_back(memories[i]);
+      }
+    }
+    return survivors;
+  }
+
+  /**
+   * Enforce a memory budget on an NPC
+   *
+   * Each collection is first trimmed to its entry limit, then the lowest
+   * scoring memories of any collection are evicted until the estimated size
+   * fits the byte limit. Returns the same NPC when nothing was evicted.
+   * Evicted episodes are released from the sequence trie, if one is given.
+   */
+  inline datamodel::npc::NPC::ref_type enforceBudget(
+    const datamodel::npc::NPC::ref_type& npc,
+    const MemoryBudget& budget,
+    uint64_t current_time,
+    const datamodel::relationship::RelationshipDecay& decay,
+    SequenceTrie* sequence_trie = nullptr
+  ) {
+    enum Collection : size_t { EPISODES = 0, BEHAVIORS = 1, RELATIONSHIPS = 2 };
+
+    const size_t sizes[] = {
+      npc->getEpisodicMemory().size(),
+      npc->getObservedBehaviors().size(),
+      npc->getRelationships().size()
+    };
+    const size_t limits[] = {
+      budget.max_episodes,
+      budget.max_observed_behaviors,
+      budget.max_relationships
+    };
+
+    // Nothing to do while every limit is respected
+    size_t total_entries = sizes[EPISODES] + sizes[BEHAVIORS] + sizes[RELATIONSHIPS];
+    bool within_counts = sizes[EPISODES] <= limits[EPISODES] &&
+                         sizes[BEHAVIORS] <= limits[BEHAVIORS] &&
+                         sizes[RELATIONSHIPS] <= limits[RELATIONSHIPS];
+    if (within_counts && estimateBytes(npc) <= budget.max_bytes) {
+      return npc;
+    }
+
+    std::vector<EvictionCandidate> candidates;
+    candidates.reserve(total_entries);
+    std::vector<datamodel::memory::MemoryEpisode::ref_type> episodes(
+      npc->getEpisodicMemory().begin(),
+      npc->getEpisodicMemory().end()
+    );
+    auto score = [&](const auto& memory) {
+      return scoreMemory(memory, current_time, budget);
+    };
+    collectCandidates(episodes, EPISODES, score, candidates);
+    collectCandidates(npc->getObservedBehaviors(), BEHAVIORS, score, candidates);
+    collectCandidates(npc->getRelationships().all(), RELATIONSHIPS,
+      [&](const datamodel::relationship::Relationship::ref_type& relationship) {
+        return scoreMemory(relationship, current_time, budget, decay);
+      },
+      candidates);
+
+    // Weakest memories first
+    std::stable_sort(candidates.begin(), candidates.end(),
+      [](const EvictionCandidate& a, const EvictionCandidate& b) {
+        return a.score < b.score;
+      });
+
+    std::vector<bool> evicted[] = {
+      std::vector<bool>(sizes[EPISODES], false),
+      std::vector<bool>(sizes[BEHAVIORS], false),
+      std::vector<bool>(sizes[RELATIONSHIPS], false)
+    };
+    size_t remaining[] = { sizes[EPISODES], sizes[BEHAVIORS], sizes[RELATIONSHIPS] };
+    size_t total_bytes = 0;
+    for (const auto& candidate : candidates) {
+      total_bytes += candidate.bytes;
+    }
+    size_t evicted_count[] = { 0, 0, 0 };
+    size_t evicted_bytes = 0;
+
+    // Trim each collection to its entry limit
+    for (const auto& candidate : candidates) {
+      if (remaining[candidate.collection] > limits[candidate.collection]) {
+        evicted[candidate.collection][candidate.index] = true;
+        remaining[candidate.collection]--;
+        evicted_count[candidate.collection]++;
+        total_bytes -= candidate.bytes;
+        evicted_bytes += candidate.bytes;
+      }
+    }
+
+    // Evict across collections until the byte limit is met
+    for (const auto& candidate : candidates) {
+      if (total_bytes <= budget.max_bytes) {
+        break;
+      }
+      if (!evicted[candidate.collection][candidate.index]) {
+        evicted[candidate.collection][candidate.index] = true;
+        evicted_count[candidate.collection]++;
+        total_bytes -= candidate.bytes;
+        evicted_bytes += candidate.bytes;
+      }
+    }
+
+    if (evicted_count[EPISODES] + evicted_count[BEHAVIORS] + evicted_count[RELATIONSHIPS] == 0) {
+      return npc;
+    }
+
+    if (sequence_trie) {
+      for (size_t i = 0; i < episodes.size(); ++i) {
+        if (evicted[EPISODES][i]) {
+          sequence_trie->release(episodes[i]->action_sequence, npc->getIdentity()->entity->handle);
+        }
+      }
+    }
+
+    auto& stats = getEvictionStats();
+    stats.episodes += evicted_count[EPISODES];
+    stats.observed_behaviors += evicted_count[BEHAVIORS];
+    stats.relationships += evicted_count[RELATIONSHIPS];
+    stats.bytes += evicted_bytes;
+
+    spdlog::debug("NPC {} forgot {} episodes, {} behaviors and {} relationships ({} bytes)",
+                  npc->getIdentity()->entity->id,
+                  evicted_count[EPISODES], evicted_count[BEHAVIORS], evicted_count[RELATIONSHIPS],
+                  evicted_bytes);
+
+    datamodel::npc::NPC updated_npc(
+      npc->getIdentity(),
+      npc->getDrives(),
+      npc->getPerception(),
+      keepSurvivors(episodes, evicted[EPISODES]),
+      keepSurvivors(npc->getObservedBehaviors(), evicted[BEHAVIORS]),
+      // Keep the same store (and its index) when no relationship was forgotten
+      evicted_count[RELATIONSHIPS] == 0 ?
+        npc->getRelationships() :
+        datamodel::relationship::RelationshipStore(keepSurvivors(npc->getRelationships().all(), evicted[RELATIONSHIPS])),
+      npc->getSegmentation()
+    );
+
+    return datamodel::npc::NPC::storage::make_entity(std::move(updated_npc));
+  }
+
+} // namespace memory_budget_system
+
+} // namespace history_game::systems::memory
+
+#endif // HISTORY_GAME_SYSTEMS_MEMORY_MEMORY_BUDGET_H
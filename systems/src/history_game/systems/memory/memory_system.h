@@ -2,6 +2,8 @@
 #define HISTORY_GAME_SYSTEMS_MEMORY_MEMORY_SYSTEM_H
 
 #include <vector>
+#include <limits>
+#include <algorithm>
 #include <string>
 #include <functional>
 #include <unordered_map>
@@ -11,6 +13,7 @@
 #include <history_game/datamodel/memory/memory_entry.h>
 #include <history_game/datamodel/memory/perception_buffer.h>
 #include <history_game/systems/perception/perception_system.h>
+#include <history_game/systems/memory/perception_admission.h>
 #include <history_game/datamodel/action/action_type.h>
 
 namespace history_game::systems::memory {
@@ -19,7 +22,7 @@ namespace history_game::systems::memory {
    * Get the NPCIdentity from an NPC
    */
   inline datamodel::npc::NPCIdentity::ref_type getIdentity(const datamodel::npc::NPC::ref_type& npc) {
-    return npc->identity;
+    return npc->getIdentity();
   }
   
   /**
@@ -41,9 +44,9 @@ namespace history_game::systems::memory {
     // The observed is also an NPC, but we store only its identity
     datamodel::memory::MemoryEntry entry(
       timestamp, 
-      observer->identity,
+      observer->getIdentity(),
       datamodel::action::action_type::Observe{},
-      observed->identity->entity
+      observed->getIdentity()->entity
     );
     return datamodel::memory::MemoryEntry::storage::make_entity(std::move(entry));
   }
@@ -59,7 +62,7 @@ namespace history_game::systems::memory {
     // The observer is the full NPC, but we use its identity in the memory
     datamodel::memory::MemoryEntry entry(
       timestamp, 
-      observer->identity,
+      observer->getIdentity(),
       datamodel::action::action_type::Observe{},
       observed
     );
@@ -102,45 +105,176 @@ namespace history_game::systems::memory {
     return entries;
   }
   
+  /**
+   * Index the world's event records by the handle of the acting NPC
+   */
+  inline std::unordered_map<datamodel::entity::EntityHandle, size_t> indexEventsByActor(
+    const std::vector<datamodel::memory::MemoryEntry::ref_type>& events
+  ) {
+    std::unordered_map<datamodel::entity::EntityHandle, size_t> index;
+    index.reserve(events.size());
+    
+    for (size_t i = 0; i < events.size(); ++i) {
+      index.emplace(events[i]->actorHandle(), i);
+    }
+    
+    return index;
+  }
+  
+  /**
+   * Get the memory entry an observer forms from a perception
+   * A perceived NPC that acted this tick is remembered through the shared
+   * event record of its action; anything else gets its own observation entry.
+   */
+  inline datamodel::memory::MemoryEntry::ref_type getPerceivedMemory(
+    const perception::PerceptionPair& perception,
+    const std::vector<datamodel::memory::MemoryEntry::ref_type>& events,
+    const std::unordered_map<datamodel::entity::EntityHandle, size_t>& events_by_actor,
+    uint64_t timestamp
+  ) {
+    if (std::holds_alternative<datamodel::npc::NPC::ref_type>(perception.perceived)) {
+      auto event = events_by_actor.find(perception::getEntityHandle(perception.perceived));
+      if (event != events_by_actor.end()) {
+        return events[event->second];
+      }
+    }
+    
+    return createObservationMemory(perception, timestamp);
+  }
+  
+  /**
+   * Check if two memory entries record the same observation
+   * (same actor, same action and same target)
+   */
+  inline bool isSameObservation(
+    const datamodel::memory::MemoryEntry& a,
+    const datamodel::memory::MemoryEntry& b
+  ) {
+    if (a.actionIndex() != b.actionIndex()) {
+      return false;
+    }
+    
+    if (a.actorHandle() != b.actorHandle()) {
+      return false;
+    }
+    
+    return perception_admission_system::getTargetHandle(a) ==
+           perception_admission_system::getTargetHandle(b);
+  }
+
+  inline bool isSameObservation(
+    const datamodel::memory::MemoryEntry::ref_type& a,
+    const datamodel::memory::MemoryEntry::ref_type& b
+  ) {
+    return isSameObservation(*a, *b);
+  }
+  
+  /**
+   * Check if a new entry continues an observation already in the buffer,
+   * i.e. it is the same observation and starts no later than the tick after
+   * the buffered one ended, and the merged run still fits in one entry
+   */
+  inline bool continuesObservation(
+    const datamodel::memory::MemoryEntry::ref_type& buffered,
+    const datamodel::memory::MemoryEntry::ref_type& entry
+  ) {
+    return entry->timestamp >= buffered->timestamp &&
+           entry->timestamp <= buffered->lastTimestamp() + 1 &&
+           entry->lastTimestamp() <= buffered->timestamp + datamodel::memory::MemoryEntry::MAX_SPAN &&
+           isSameObservation(buffered, entry);
+  }
+  
+  /**
+   * Merge a continuing observation into a single entry spanning both
+   */
+  inline datamodel::memory::MemoryEntry::ref_type coalesceObservation(
+    const datamodel::memory::MemoryEntry::ref_type& buffered,
+    const datamodel::memory::MemoryEntry::ref_type& entry
+  ) {
+    // The new entry may already cover the whole run
+    if (entry->timestamp <= buffered->timestamp && entry->lastTimestamp() >= buffered->lastTimestamp()) {
+      return entry;
+    }
+    
+    datamodel::memory::MemoryEntry span(
+      *entry,
+      std::min(buffered->timestamp, entry->timestamp),
+      std::max(buffered->lastTimestamp(), entry->lastTimestamp())
+    );
+    return datamodel::memory::MemoryEntry::storage::make_entity(std::move(span));
+  }
+  
   /**
    * Update an NPC's perception buffer with new memory entries
+   * Only the new entries are written; the chunks holding the older entries are
+   * shared with the previous buffer, which stays valid for anyone holding it.
+   * A new entry that continues an observation already in the buffer replaces
+   * it with a single entry spanning both, so repeated observations use one slot.
    */
   inline datamodel::memory::PerceptionBuffer::ref_type updatePerceptionBuffer(
     const datamodel::memory::PerceptionBuffer::ref_type& buffer,
     const std::vector<datamodel::memory::MemoryEntry::ref_type>& new_entries,
     size_t max_buffer_size = 20
   ) {
-    // Combine existing entries with new ones
-    std::vector<datamodel::memory::MemoryEntry::ref_type> updated_entries;
-    updated_entries.reserve(buffer->recent_perceptions.size() + new_entries.size());
-    
-    // Copy existing entries
-    for (const auto& entry : buffer->recent_perceptions) {
-      updated_entries.push_back(entry);
-    }
+    const auto& window = buffer->recent_perceptions;
     
-    // Add new entries
+    // Only entries that ended right before a new one can be continued. Entries
+    // are appended in time order, so these are found at the end of the window.
+    uint64_t earliest = std::numeric_limits<uint64_t>::max();
     for (const auto& entry : new_entries) {
-      updated_entries.push_back(entry);
+      earliest = std::min<uint64_t>(earliest, entry->timestamp);
     }
+    size_t tail = window.size();
+    while (tail > 0 && window[tail - 1]->lastTimestamp() + 1 >= earliest) {
+      tail--;
+    }
+    
+    // Look for buffered observations that the new entries continue
+    std::vector<size_t> superseded;
+    std::vector<datamodel::memory::MemoryEntry::ref_type> appended;
+    appended.reserve(new_entries.size());
     
-    // Trim to max size if needed
-    if (updated_entries.size() > max_buffer_size) {
-      // Create a new vector with only the most recent entries
-      std::vector<datamodel::memory::MemoryEntry::ref_type> trimmed_entries;
-      trimmed_entries.reserve(max_buffer_size);
+    for (const auto& entry : new_entries) {
+      bool merged = false;
       
-      // Copy only the newest entries (from the end of the vector)
-      for (size_t i = updated_entries.size() - max_buffer_size; i < updated_entries.size(); ++i) {
-        trimmed_entries.push_back(updated_entries[i]);
+      // The most recent matching observation is the one being continued
+      for (size_t i = window.size(); i-- > tail;) {
+        if (std::find(superseded.begin(), superseded.end(), i) == superseded.end() &&
+            continuesObservation(window[i], entry)) {
+          superseded.push_back(i);
+          appended.push_back(coalesceObservation(window[i], entry));
+          merged = true;
+          break;
+        }
       }
       
-      // Replace with the trimmed vector
-      updated_entries = std::move(trimmed_entries);
+      if (!merged) {
+        appended.push_back(entry);
+      }
     }
     
-    // Create and return a new perception buffer
-    datamodel::memory::PerceptionBuffer new_buffer(std::move(updated_entries));
+    if (superseded.empty()) {
+      // Append to the persistent window, trimming to the newest max_buffer_size entries
+      datamodel::memory::PerceptionBuffer new_buffer(
+        datamodel::memory::perception_buffer_system::append(
+          window,
+          appended,
+          max_buffer_size
+        )
+      );
+      return datamodel::memory::PerceptionBuffer::storage::make_entity(std::move(new_buffer));
+    }
+    
+    // Continued entries move to the end of the buffer, leave out their old slots
+    std::sort(superseded.begin(), superseded.end());
+    datamodel::memory::PerceptionBuffer new_buffer(
+      datamodel::memory::perception_buffer_system::replace(
+        window,
+        superseded,
+        appended,
+        max_buffer_size
+      )
+    );
     return datamodel::memory::PerceptionBuffer::storage::make_entity(std::move(new_buffer));
   }
   
@@ -154,16 +288,17 @@ namespace history_game::systems::memory {
   ) {
     // Update the perception buffer
     datamodel::memory::PerceptionBuffer::ref_type updated_buffer = 
-      updatePerceptionBuffer(npc->perception, new_memories, max_buffer_size);
+      updatePerceptionBuffer(npc->getPerception(), new_memories, max_buffer_size);
     
     // Create a new NPC with the updated perception buffer
     datamodel::npc::NPC updated_npc(
-      npc->identity,
-      npc->drives,
+      npc->getIdentity(),
+      npc->getDrives(),
       updated_buffer,
-      npc->episodic_memory,
-      npc->observed_behaviors,
-      npc->relationships
+      npc->getEpisodicMemory(),
+      npc->getObservedBehaviors(),
+      npc->getRelationships(),
+      npc->getSegmentation()
     );
     
     return datamodel::npc::NPC::storage::make_entity(std::move(updated_npc));
@@ -171,14 +306,19 @@ namespace history_game::systems::memory {
   
   /**
    * Process all perceptions in the world and update NPCs' memory
+   * Candidate perceptions are scored first and only the ones admitted into
+   * each perceiver's buffer are turned into memory entries. Observers of an
+   * NPC that acted this tick share the world's event record for that action.
    */
   inline datamodel::world::World::ref_type processPerceptions(
     const datamodel::world::World::ref_type& world,
+    const datamodel::relationship::RelationshipDecay& decay,
     float perception_range = 10.0f,
-    size_t max_buffer_size = 20
+    size_t max_buffer_size = 20,
+    const AdmissionParams& admission_params = {}
   ) {
     // Get the current time from the simulation clock
-    uint64_t current_time = world->clock->current_tick;
+    uint64_t current_time = world->getClock()->current_tick;
         
     // Calculate all perceptible entities in the world
     auto perceptions = perception::calculatePerceptibleEntities(
@@ -189,28 +329,52 @@ namespace history_game::systems::memory {
     if (perceptions.size())
       spdlog::debug("Found {} perception events", perceptions.size());
     
-    // Group perceptions by perceiver ID
-    std::unordered_map<std::string, std::vector<datamodel::memory::MemoryEntry::ref_type>> npc_memories;
+    // Actions executed this tick, by actor
+    auto events_by_actor = indexEventsByActor(world->getEvents());
     
-    // Create memory entries and group by NPC
-    for (const auto& perception : perceptions) {
-      auto memory = createObservationMemory(perception, current_time);
-      npc_memories[perception::getId(perception.perceiver)].push_back(memory);
+    // Group candidate perceptions by perceiver handle
+    std::unordered_map<datamodel::entity::EntityHandle, std::vector<size_t>> npc_candidates;
+    
+    for (size_t i = 0; i < perceptions.size(); ++i) {
+      npc_candidates[perception::getHandle(perceptions[i].perceiver)].push_back(i);
     }
     
     // Create updated NPCs with new memories
     std::vector<datamodel::npc::NPC::ref_type> updated_npcs;
     int npcs_with_perceptions = 0;
+    size_t admitted_perceptions = 0;
     
-    for (const auto& npc : world->npcs) {
-      const auto& npc_id = perception::getId(npc);
+    for (const auto& npc : world->getNPCs()) {
+      auto candidates = npc_candidates.find(perception::getHandle(npc));
       
       // If this NPC perceived anything, update its perception buffer
-      if (npc_memories.count(npc_id) > 0) {
+      if (candidates != npc_candidates.end()) {
+        auto admitted = perception_admission_system::admitPerceptions(
+          perceptions,
+          candidates->second,
+          max_buffer_size,
+          perception_range,
+          current_time,
+          decay,
+          admission_params
+        );
+        
+        // Only the admitted perceptions become memory entries
+        std::vector<datamodel::memory::MemoryEntry::ref_type> new_memories;
+        new_memories.reserve(admitted.size());
+        for (size_t index : admitted) {
+          new_memories.push_back(getPerceivedMemory(
+            perceptions[index],
+            world->getEvents(),
+            events_by_actor,
+            current_time
+          ));
+        }
+        admitted_perceptions += new_memories.size();
                      
         auto updated_npc = updateNPCPerceptions(
           npc, 
-          npc_memories[npc_id],
+          new_memories,
           max_buffer_size
         );
         updated_npcs.push_back(updated_npc);
@@ -220,12 +384,18 @@ namespace history_game::systems::memory {
         updated_npcs.push_back(npc);
       }
     }
+    
+    if (perceptions.size())
+      spdlog::debug("Admitted {} of {} perceptions for {} NPCs", 
+                    admitted_perceptions, perceptions.size(), npcs_with_perceptions);
         
     // Create a new world with updated NPCs
     datamodel::world::World updated_world(
-      world->clock,
+      *world,
+      world->getClock(),
       std::move(updated_npcs),
-      world->objects
+      world->getObjects(),
+      world->getEvents()
     );
     
     return datamodel::world::World::storage::make_entity(std::move(updated_world));
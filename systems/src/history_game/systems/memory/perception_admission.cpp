@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/systems/memory/perception_admission.cpp
+#include <history_game/systems/memory/perception_admission.h>
+
+namespace history_game::systems::memory {
+// Empty implementation file
+}
\ No newline at end of file
@@ -0,0 +1,208 @@
+#ifndef HISTORY_GAME_SYSTEMS_MEMORY_PERCEPTION_ADMISSION_H
+#define HISTORY_GAME_SYSTEMS_MEMORY_PERCEPTION_ADMISSION_H
+
+#include <vector>
+#include <string>
+#include <queue>
+#include <utility>
+#include <functional>
+#include <algorithm>
+#include <unordered_set>
+#include <history_game/datamodel/npc/npc.h>
+#include <history_game/datamodel/memory/memory_entry.h>
+#include <history_game/datamodel/relationship/relationship.h>
+#include <history_game/systems/perception/perception_system.h>
+
+namespace history_game::systems::memory {
+
+/**
+ * Weights used to score how salient a perception is to its perceiver
+ */
+struct AdmissionParams {
+  // Weight for things the perceiver has not seen recently
+  const float novelty_weight;
+
+  // Weight for closeness to the perceiver
+  const float distance_weight;
+
+  // Weight for familiarity with the perceived entity
+  const float relationship_weight;
+
+  // Constructor with default values
+  AdmissionParams(
+    float novelty = 1.0f,
+    float distance = 0.5f,
+    float relationship = 0.5f
+  ) : novelty_weight(novelty),
+      distance_weight(distance),
+      relationship_weight(relationship) {}
+};
+
+namespace perception_admission_system {
+
+  /**
+   * Get the handle of the target of a memory entry (invalid if it has none)
+   */
+  inline datamodel::entity::EntityHandle getTargetHandle(const datamodel::memory::MemoryEntry& entry) {
+    if (const auto* target_entity = entry.targetEntity()) {
+      return *target_entity;
+    }
+    if (const auto* target_object = entry.targetObject()) {
+      return *target_object;
+    }
+    return datamodel::entity::EntityHandle();
+  }
+
+  inline datamodel::entity::EntityHandle getTargetHandle(const datamodel::memory::MemoryEntry::ref_type& entry) {
+    return getTargetHandle(*entry);
+  }
+
+  /**
+   * Collect the handles of everything the NPC currently holds in its perception buffer
+   * (the targets of its observations and the actors of the events it witnessed)
+   */
+  inline std::unordered_set<datamodel::entity::EntityHandle> getRecentlyPerceivedHandles(const datamodel::npc::NPC::ref_type& npc) {
+    std::unordered_set<datamodel::entity::EntityHandle> handles;
+    handles.reserve(npc->getPerception()->recent_perceptions.size());
+    const datamodel::entity::EntityHandle own_handle = npc->getIdentity()->entity->handle;
+
+    for (const auto& entry : npc->getPerception()->recent_perceptions) {
+      datamodel::entity::EntityHandle target = getTargetHandle(entry);
+      if (target.isValid()) {
+        handles.insert(target);
+      }
+      if (entry->actorHandle() != own_handle) {
+        handles.insert(entry->actorHandle());
+      }
+    }
+
+    return handles;
+  }
+
+  /**
+   * Familiarity overloads for argument-dependent lookup
+   */
+  inline float getFamiliarityWith(
+    const datamodel::npc::NPC::ref_type& perceiver,
+    const datamodel::npc::NPC::ref_type& perceived,
+    uint64_t current_time,
+    const datamodel::relationship::RelationshipDecay& decay
+  ) {
+    auto rel = datamodel::relationship::relationship_system::findRelationship(
+      perceiver->getRelationships(),
+      perceived->getIdentity()->entity
+    );
+    return rel ? datamodel::relationship::relationship_system::getFamiliarity(*rel.value(), current_time, decay) : 0.0f;
+  }
+
+  inline float getFamiliarityWith(
+    const datamodel::npc::NPC::ref_type& perceiver,
+    const datamodel::object::WorldObject::ref_type& perceived,
+    uint64_t current_time,
+    const datamodel::relationship::RelationshipDecay& decay
+  ) {
+    auto rel = datamodel::relationship::relationship_system::findRelationship(
+      perceiver->getRelationships(),
+      perceived
+    );
+    return rel ? datamodel::relationship::relationship_system::getFamiliarity(*rel.value(), current_time, decay) : 0.0f;
+  }
+
+  /**
+   * Score a candidate perception; higher means more worth remembering
+   */
+  inline float scorePerception(
+    const perception::PerceptionPair& perception,
+    const std::unordered_set<datamodel::entity::EntityHandle>& recently_perceived,
+    float perception_range,
+    const AdmissionParams& params,
+    uint64_t current_time,
+    const datamodel::relationship::RelationshipDecay& decay
+  ) {
+    // Things already in the buffer are not novel
+    float novelty = recently_perceived.count(perception::getEntityHandle(perception.perceived)) > 0 ? 0.0f : 1.0f;
+
+    // Closer things are more salient
+    float closeness = 0.0f;
+    if (perception_range > 0.0f) {
+      closeness = std::clamp(1.0f - perception.distance / perception_range, 0.0f, 1.0f);
+    }
+
+    // Familiar things are more salient
+    float familiarity = std::visit(
+      [&](const auto& perceived) {
+        return getFamiliarityWith(perception.perceiver, perceived, current_time, decay);
+      },
+      perception.perceived
+    );
+
+    return params.novelty_weight * novelty +
+           params.distance_weight * closeness +
+           params.relationship_weight * familiarity;
+  }
+
+  /**
+   * Select the most salient perceptions of a single perceiver
+   *
+   * Keeps the top `max_admitted` candidates in a bounded min-heap, so nothing is
+   * allocated for candidates that would be trimmed out of the buffer anyway.
+   *
+   * @param perceptions All perception pairs of this tick
+   * @param candidates Indices into `perceptions` that belong to one perceiver
+   * @param current_time Time the perceptions happen, for relationship decay
+   * @param decay How the perceiver's relationships decay
+   * @return The admitted indices, in their original order
+   */
+  inline std::vector<size_t> admitPerceptions(
+    const std::vector<perception::PerceptionPair>& perceptions,
+    const std::vector<size_t>& candidates,
+    size_t max_admitted,
+    float perception_range,
+    uint64_t current_time,
+    const datamodel::relationship::RelationshipDecay& decay,
+    const AdmissionParams& params = {}
+  ) {
+    if (candidates.size() <= max_admitted) {
+      return candidates;
+    }
+
+    if (max_admitted == 0) {
+      return {};
+    }
+
+    const auto& perceiver = perceptions[candidates.front()].perceiver;
+    auto recently_perceived = getRecentlyPerceivedHandles(perceiver);
+
+    // Min-heap of (score, index); the weakest admitted candidate sits on top
+    using Scored = std::pair<float, size_t>;
+    std::priority_queue<Scored, std::vector<Scored>, std::greater<Scored>> heap;
+
+    for (size_t index : candidates) {
+      float score = scorePerception(perceptions[index], recently_perceived, perception_range, params, current_time, decay);
+
+      if (heap.size() < max_admitted) {
+        heap.emplace(score, index);
+      } else if (score > heap.top().first) {
+        heap.pop();
+        heap.emplace(score, index);
+      }
+    }
+
+    std::vector<size_t> admitted;
+    admitted.reserve(heap.size());
+    while (!heap.empty()) {
+      admitted.push_back(heap.top().second);
+      heap.pop();
+    }
+
+    // Keep the perception order stable
+    std::sort(admitted.begin(), admitted.end());
+
+    return admitted;
+  }
+
+} // namespace perception_admission_system
+
+} // namespace history_game::systems::memory
+
+#endif // HISTORY_GAME_SYSTEMS_MEMORY_PERCEPTION_ADMISSION_H
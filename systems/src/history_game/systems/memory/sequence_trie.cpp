@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/systems/memory/sequence_trie.cpp
+#include <history_game/systems/memory/sequence_trie.h>
+
+namespace history_game::systems::memory {
+// Empty implementation file
+}
\ No newline at end of file
@@ -0,0 +1,219 @@
+#ifndef HISTORY_GAME_SYSTEMS_MEMORY_SEQUENCE_TRIE_H
+#define HISTORY_GAME_SYSTEMS_MEMORY_SEQUENCE_TRIE_H
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <history_game/datamodel/action/action_sequence.h>
+#include <history_game/datamodel/action/sequence_fingerprint.h>
+#include <history_game/datamodel/entity/entity_handle.h>
+#include <history_game/datamodel/memory/episode_store.h>
+
+namespace history_game::systems::memory {
+
+/**
+ * Population-wide trie of the action sequences NPCs remember
+ *
+ * Each path from the root spells the (action, target handle) steps of a
+ * sequence. Only these step keys are shared: every NPC keeps its own
+ * ActionSequence and MemoryEntries, so nothing one NPC remembers is reachable
+ * from another's episodes. Every node counts, per NPC, the episodes whose
+ * sequences pass through it and the ones that end there. Releasing an episode
+ * when it is forgotten drops its counts; a node nobody passes through any
+ * more is removed.
+ */
+class SequenceTrie {
+public:
+  using NodeId = uint32_t;
+  static constexpr NodeId ROOT = 0;
+
+  SequenceTrie() {
+    nodes.emplace_back();
+  }
+
+  SequenceTrie(const SequenceTrie&) = delete;
+  SequenceTrie& operator=(const SequenceTrie&) = delete;
+
+  /**
+   * Key of one step of a sequence: its action and the handle of its target
+   */
+  static uint64_t stepKey(const datamodel::action::ActionStep& step) {
+    uint64_t target_key = datamodel::memory::episode_store_system::getTargetKey(step.memory);
+    return datamodel::action::sequence_fingerprint_system::mix(
+      static_cast<uint64_t>(step.memory->actionIndex()) ^ (target_key << 4)
+    );
+  }
+
+  /**
+   * Record that an NPC remembers an episode of a sequence
+   * Each call counts one episode of the NPC until it is released.
+   */
+  void intern(
+    const datamodel::action::ActionSequence::ref_type& sequence,
+    datamodel::entity::EntityHandle performer_handle
+  ) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<NodeId> path;
+    path.reserve(sequence->steps.size() + 1);
+    path.push_back(ROOT);
+
+    for (const auto& step : sequence->steps) {
+      uint64_t key = stepKey(step);
+      auto child = nodes[path.back()].children.find(key);
+      if (child == nodes[path.back()].children.end()) {
+        NodeId next = allocateNode();
+        nodes[path.back()].children.emplace(key, next);
+        path.push_back(next);
+      } else {
+        path.push_back(child->second);
+      }
+    }
+
+    uint32_t performer = performer_handle.value;
+    for (NodeId node : path) {
+      nodes[node].performers[performer]++;
+    }
+
+    Node& last = nodes[path.back()];
+    if (last.endings.empty()) {
+      sequence_count++;
+    }
+    last.endings[performer]++;
+  }
+
+  /**
+   * Record that an NPC forgot an episode of a sequence it interned
+   * Sequences the NPC has no episode of are ignored.
+   * @return Whether the episode was counted by the trie
+   */
+  bool release(
+    const datamodel::action::ActionSequence::ref_type& sequence,
+    datamodel::entity::EntityHandle performer_handle
+  ) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint32_t performer = performer_handle.value;
+    std::vector<NodeId> path;
+    path.reserve(sequence->steps.size() + 1);
+    path.push_back(ROOT);
+    for (const auto& step : sequence->steps) {
+      auto child = nodes[path.back()].children.find(stepKey(step));
+      if (child == nodes[path.back()].children.end()) {
+        return false;
+      }
+      path.push_back(child->second);
+    }
+
+    Node& last = nodes[path.back()];
+    auto ending = last.endings.find(performer);
+    if (ending == last.endings.end()) {
+      return false;
+    }
+    if (--ending->second == 0) {
+      last.endings.erase(ending);
+      if (last.endings.empty()) {
+        sequence_count--;
+      }
+    }
+
+    for (size_t depth = 0; depth < path.size(); ++depth) {
+      Node& node = nodes[path[depth]];
+      auto count = node.performers.find(performer);
+      if (--count->second == 0) {
+        node.performers.erase(count);
+      }
+
+      // Nodes below one nobody passes through are unused as well
+      if (depth > 0 && node.performers.empty()) {
+        nodes[path[depth - 1]].children.erase(stepKey(sequence->steps[depth - 1]));
+        for (size_t below = depth; below < path.size(); ++below) {
+          freeNode(path[below]);
+        }
+        break;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Number of distinct NPCs that performed a sequence (or a longer one starting with it)
+   * Takes time proportional to the length of the sequence.
+   */
+  size_t countPerformers(const datamodel::action::ActionSequence::ref_type& sequence) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    NodeId node = ROOT;
+    for (const auto& step : sequence->steps) {
+      auto child = nodes[node].children.find(stepKey(step));
+      if (child == nodes[node].children.end()) {
+        return 0;
+      }
+      node = child->second;
+    }
+    return nodes[node].performers.size();
+  }
+
+  /**
+   * Number of nodes in the trie (including the root)
+   */
+  size_t nodeCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return nodes.size() - free_nodes.size();
+  }
+
+  /**
+   * Number of distinct sequences some NPC remembers an episode of
+   */
+  size_t sequenceCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sequence_count;
+  }
+
+private:
+  struct Node {
+    std::unordered_map<uint64_t, NodeId> children;
+
+    // Episodes passing through this node, by the handle of the NPC holding them
+    std::unordered_map<uint32_t, uint32_t> performers;
+
+    // Episodes whose sequence ends at this node, by the handle of the NPC holding them
+    std::unordered_map<uint32_t, uint32_t> endings;
+  };
+
+  NodeId allocateNode() {
+    if (free_nodes.empty()) {
+      nodes.emplace_back();
+      return static_cast<NodeId>(nodes.size() - 1);
+    }
+    NodeId node = free_nodes.back();
+    free_nodes.pop_back();
+    return node;
+  }
+
+  void freeNode(NodeId node) {
+    Node& freed = nodes[node];
+    freed.children.clear();
+    freed.performers.clear();
+    if (!freed.endings.empty()) {
+      freed.endings.clear();
+      sequence_count--;
+    }
+    free_nodes.push_back(node);
+  }
+
+  // Nodes never move once created; removed ones are reused
+  std::deque<Node> nodes;
+  std::vector<NodeId> free_nodes;
+  size_t sequence_count = 0;
+  mutable std::mutex mutex;
+};
+
+} // namespace history_game::systems::memory
+
+#endif // HISTORY_GAME_SYSTEMS_MEMORY_SEQUENCE_TRIE_H
@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/systems/perception/convergence_detector.cpp
+#include <history_game/systems/perception/convergence_detector.h>
+
+namespace history_game::systems::perception {
+// Empty implementation file
+}
\ No newline at end of file
@@ -0,0 +1,236 @@
+#ifndef HISTORY_GAME_SYSTEMS_PERCEPTION_CONVERGENCE_DETECTOR_H
+#define HISTORY_GAME_SYSTEMS_PERCEPTION_CONVERGENCE_DETECTOR_H
+
+#include <deque>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <functional>
+#include <unordered_map>
+#include <history_game/datamodel/world/position.h>
+#include <history_game/datamodel/action/action_type.h>
+#include <history_game/datamodel/memory/memory_entry.h>
+#include <history_game/datamodel/world/world.h>
+
+namespace history_game::systems::perception {
+
+  /**
+   * Parameters for convergence detection
+   */
+  struct ConvergenceParams {
+    // Side of the square grid cells NPCs are grouped in
+    const float cell_size;
+
+    // Number of ticks an action keeps counting towards a convergence
+    const uint64_t window;
+
+    // Number of distinct NPCs needed for a convergence
+    const size_t min_participants;
+
+    // Constructor
+    ConvergenceParams(
+      float cell = 20.0f,
+      uint64_t window_ticks = 10,
+      size_t participants = 3
+    ) : cell_size(cell),
+        window(window_ticks),
+        min_participants(participants) {}
+  };
+
+  /**
+   * Several NPCs performing the same action in the same place and time window
+   */
+  struct ConvergenceEvent {
+    // Tick at which the convergence was detected
+    uint64_t tick;
+
+    // Grid cell where it happens
+    int32_t cell_x;
+    int32_t cell_y;
+
+    // Action being performed
+    datamodel::action::ActionType action;
+
+    // Number of distinct NPCs that performed it within the window
+    size_t participants;
+
+    // Constructor
+    ConvergenceEvent(
+      uint64_t detection_tick,
+      int32_t x,
+      int32_t y,
+      datamodel::action::ActionType converging_action,
+      size_t participant_count
+    ) : tick(detection_tick),
+        cell_x(x),
+        cell_y(y),
+        action(std::move(converging_action)),
+        participants(participant_count) {}
+  };
+
+  /**
+   * Streaming detector of convergences over space-time windows
+   *
+   * Keeps, for every grid cell and action, the number of times each NPC
+   * performed that action there within the last `window` ticks. Each tick only
+   * the new action events and the samples leaving the window are touched, so
+   * detection never scans NPC memories. An event is raised when a cell and
+   * action first reaches `min_participants`, and again only after it drops
+   * below that count.
+   */
+  class ConvergenceDetector {
+  public:
+    explicit ConvergenceDetector(ConvergenceParams convergence_params = ConvergenceParams())
+      : params(convergence_params) {}
+
+    ConvergenceDetector(const ConvergenceDetector&) = delete;
+    ConvergenceDetector& operator=(const ConvergenceDetector&) = delete;
+
+    /**
+     * Add the action events of a world's tick and return the convergences they start
+     * Each action counts where its actor is in that world.
+     */
+    std::vector<ConvergenceEvent> observe(
+      const datamodel::world::World& world,
+      uint64_t current_tick
+    ) {
+      expire(current_tick);
+
+      const auto& events = world.getEvents();
+      std::vector<CellKey> touched;
+      touched.reserve(events.size());
+
+      for (const auto& event : events) {
+        const auto* actor_npc = world.findNPC(event->actorHandle());
+        if (!actor_npc) {
+          continue;
+        }
+        CellKey key = makeKey((*actor_npc)->getIdentity()->entity->position, event->action());
+        uint32_t actor = event->actorHandle().value;
+
+        auto window = windows.find(key);
+        if (window == windows.end()) {
+          window = windows.emplace(key, CellWindow(event->action())).first;
+        }
+        window->second.actors[actor]++;
+        samples.push_back(Sample{current_tick, key, actor});
+        touched.push_back(key);
+      }
+
+      std::vector<ConvergenceEvent> convergences;
+      for (const auto& key : touched) {
+        auto& window = windows.at(key);
+        if (!window.converging && window.actors.size() >= params.min_participants) {
+          window.converging = true;
+          convergences.emplace_back(current_tick, key.x, key.y, window.action, window.actors.size());
+        }
+      }
+
+      total_convergences += convergences.size();
+      return convergences;
+    }
+
+    /**
+     * Number of cells and actions currently converging
+     */
+    size_t activeCount() const {
+      size_t count = 0;
+      for (const auto& [key, window] : windows) {
+        if (window.converging) {
+          count++;
+        }
+      }
+      return count;
+    }
+
+    /**
+     * Number of convergence events raised so far
+     */
+    size_t totalConvergences() const {
+      return total_convergences;
+    }
+
+    /**
+     * Grid cell of a position
+     */
+    std::pair<int32_t, int32_t> getCell(const datamodel::world::Position& position) const {
+      return {
+        static_cast<int32_t>(std::floor(position.x / params.cell_size)),
+        static_cast<int32_t>(std::floor(position.y / params.cell_size))
+      };
+    }
+
+  private:
+    struct CellKey {
+      int32_t x;
+      int32_t y;
+      size_t action;
+
+      bool operator==(const CellKey& other) const {
+        return x == other.x && y == other.y && action == other.action;
+      }
+    };
+
+    struct CellKeyHash {
+      size_t operator()(const CellKey& key) const {
+        uint64_t packed = (static_cast<uint64_t>(static_cast<uint32_t>(key.x)) << 32) |
+                          static_cast<uint32_t>(key.y);
+        return std::hash<uint64_t>{}(packed * 31 + key.action);
+      }
+    };
+
+    struct CellWindow {
+      // Times each NPC performed the action within the window
+      std::unordered_map<uint32_t, uint32_t> actors;
+      datamodel::action::ActionType action;
+      bool converging = false;
+
+      explicit CellWindow(datamodel::action::ActionType window_action)
+        : action(std::move(window_action)) {}
+    };
+
+    struct Sample {
+      uint64_t tick;
+      CellKey key;
+      uint32_t actor;
+    };
+
+    CellKey makeKey(
+      const datamodel::world::Position& position,
+      const datamodel::action::ActionType& action
+    ) const {
+      auto [x, y] = getCell(position);
+      return CellKey{x, y, action.index()};
+    }
+
+    // Drop the samples that left the window
+    void expire(uint64_t current_tick) {
+      while (!samples.empty() && samples.front().tick + params.window <= current_tick) {
+        const Sample& sample = samples.front();
+        auto window = windows.find(sample.key);
+        auto actor = window->second.actors.find(sample.actor);
+        if (--actor->second == 0) {
+          window->second.actors.erase(actor);
+        }
+        if (window->second.actors.size() < params.min_participants) {
+          window->second.converging = false;
+        }
+        if (window->second.actors.empty()) {
+          windows.erase(window);
+        }
+        samples.pop_front();
+      }
+    }
+
+    const ConvergenceParams params;
+    std::deque<Sample> samples;
+    std::unordered_map<CellKey, CellWindow, CellKeyHash> windows;
+    size_t total_convergences = 0;
+  };
+
+} // namespace history_game::systems::perception
+
+#endif // HISTORY_GAME_SYSTEMS_PERCEPTION_CONVERGENCE_DETECTOR_H
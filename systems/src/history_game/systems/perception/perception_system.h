@@ -25,13 +25,13 @@ namespace history_game::systems::perception {
    */
   struct PerceptionPair {
     // The perceiving NPC
-    const datamodel::npc::NPC::ref_type perceiver;
+    datamodel::npc::NPC::ref_type perceiver;
     
     // The entity being perceived (NPC or WorldObject)
-    const PerceivableEntity perceived;
+    PerceivableEntity perceived;
     
     // Distance between them
-    const float distance;
+    float distance;
     
     // Constructor
     PerceptionPair(
@@ -55,7 +55,7 @@ namespace history_game::systems::perception {
    * Position getter function overloads for argument-dependent lookup
    */
   inline const datamodel::world::Position& getPosition(const datamodel::npc::NPC::ref_type& npc) {
-    return npc->identity->entity->position;
+    return npc->getIdentity()->entity->position;
   }
 
   inline const datamodel::world::Position& getPosition(const datamodel::object::WorldObject::ref_type& obj) {
@@ -63,14 +63,14 @@ namespace history_game::systems::perception {
   }
 
   /**
-   * ID getter function overloads for argument-dependent lookup
+   * Handle getter function overloads for argument-dependent lookup
    */
-  inline const std::string& getId(const datamodel::npc::NPC::ref_type& npc) {
-    return npc->identity->entity->id;
+  inline datamodel::entity::EntityHandle getHandle(const datamodel::npc::NPC::ref_type& npc) {
+    return npc->getIdentity()->entity->handle;
   }
 
-  inline const std::string& getId(const datamodel::object::WorldObject::ref_type& obj) {
-    return obj->entity->id;
+  inline datamodel::entity::EntityHandle getHandle(const datamodel::object::WorldObject::ref_type& obj) {
+    return obj->entity->handle;
   }
 
   /**
@@ -90,10 +90,10 @@ namespace history_game::systems::perception {
   }
   
   /**
-   * Get ID of any perceivable entity using std::visit with a lambda
+   * Get handle of any perceivable entity using std::visit with a lambda
    */
-  inline const std::string& getEntityId(const PerceivableEntity& entity) {
-    return std::visit([](const auto& e) -> const std::string& { return getId(e); }, entity);
+  inline datamodel::entity::EntityHandle getEntityHandle(const PerceivableEntity& entity) {
+    return std::visit([](const auto& e) { return getHandle(e); }, entity);
   }
   
   /**
@@ -125,7 +125,7 @@ namespace history_game::systems::perception {
    * Get entity ID for logging
    */
   inline std::string get_entity_id(const datamodel::npc::NPC::ref_type& npc) {
-    return npc->identity->entity->id;
+    return npc->getIdentity()->entity->id;
   }
   
   /**
@@ -182,21 +182,21 @@ namespace history_game::systems::perception {
     std::unordered_map<int64_t, SpatialCell> grid;
     
     // Populate the grid with NPCs
-    for (const auto& npc : world->npcs) {
+    for (const auto& npc : world->getNPCs()) {
       const datamodel::world::Position& pos = getPosition(npc);
       auto [x_idx, y_idx] = getCellIndices(pos, cell_size);
       grid[getCellKey(x_idx, y_idx)].npcs.push_back(npc);
     }
     
     // Populate the grid with objects
-    for (const auto& obj : world->objects) {
+    for (const auto& obj : world->getObjects()) {
       const datamodel::world::Position& pos = getPosition(obj);
       auto [x_idx, y_idx] = getCellIndices(pos, cell_size);
       grid[getCellKey(x_idx, y_idx)].objects.push_back(obj);
     }
     
     // For each NPC, check nearby cells for perceptible entities
-    for (const auto& npc : world->npcs) {
+    for (const auto& npc : world->getNPCs()) {
       const datamodel::world::Position& npc_pos = getPosition(npc);
       auto [center_x, center_y] = getCellIndices(npc_pos, cell_size);
       
@@ -217,7 +217,7 @@ namespace history_game::systems::perception {
           // Check other NPCs in this cell
           for (const auto& other_npc : cell.npcs) {
             // Skip self
-            if (getId(npc) == getId(other_npc)) {
+            if (getHandle(npc) == getHandle(other_npc)) {
               continue;
             }
             
@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/systems/relationship/relationship_update.cpp
+#include <history_game/systems/relationship/relationship_update.h>
+
+namespace history_game::systems::relationship {
+// Empty implementation file
+}
\ No newline at end of file
@@ -0,0 +1,499 @@
+#ifndef HISTORY_GAME_SYSTEMS_RELATIONSHIP_RELATIONSHIP_UPDATE_H
+#define HISTORY_GAME_SYSTEMS_RELATIONSHIP_RELATIONSHIP_UPDATE_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <variant>
+#include <optional>
+#include <algorithm>
+#include <type_traits>
+#include <unordered_map>
+#include <spdlog/spdlog.h>
+#include <history_game/datamodel/npc/npc.h>
+#include <history_game/datamodel/npc/drive_set.h>
+#include <history_game/datamodel/world/world.h>
+#include <history_game/datamodel/memory/memory_entry.h>
+#include <history_game/datamodel/drives/action_context.h>
+#include <history_game/datamodel/relationship/relationship.h>
+#include <history_game/datamodel/relationship/relationship_store.h>
+#include <history_game/datamodel/relationship/relationship_target.h>
+#include <history_game/systems/drives/drive_impact.h>
+#include <history_game/systems/drives/impact_cache.h>
+#include <history_game/systems/memory/memory_system.h>
+
+namespace history_game::systems::relationship {
+
+/**
+ * Parameters controlling how interactions change relationships
+ */
+struct RelationshipParameters {
+  // Familiarity gained for each tick a target is perceived
+  const float perception_familiarity;
+
+  // Familiarity gained for each tick a target is acted upon
+  const float action_familiarity;
+
+  // Fraction of an observation's drive impacts added to the actor's affective traces
+  const float trace_rate;
+
+  // Radius of the places an NPC gets to know by resting there
+  const float location_radius;
+
+  // Ticks between applying the recorded interactions
+  const uint64_t batch_interval;
+
+  // How relationships decay; every reader of the relationships uses this one
+  const datamodel::relationship::RelationshipDecay decay;
+
+  // Constructor with default values
+  RelationshipParameters(
+    float perception = 0.02f,
+    float action = 0.05f,
+    float traces = 0.1f,
+    float radius = 5.0f,
+    uint64_t interval = 10,
+    datamodel::relationship::RelationshipDecay relationship_decay = {}
+  ) : perception_familiarity(perception),
+      action_familiarity(action),
+      trace_rate(traces),
+      location_radius(radius),
+      batch_interval(interval),
+      decay(relationship_decay) {}
+};
+
+/**
+ * Applies interactions to the NPCs' relationships in batches
+ *
+ * Each tick's perceptions and executed actions are recorded as pending deltas
+ * per NPC and target. Every batch_interval ticks the deltas are folded into
+ * the relationships they touch, creating the ones that do not exist yet.
+ * Relationships nobody interacted with are left alone: their decay is applied
+ * when they are read (see RelationshipDecay), so they cost nothing per tick.
+ */
+class RelationshipUpdater {
+public:
+  explicit RelationshipUpdater(RelationshipParameters relationship_params = RelationshipParameters())
+    : params(relationship_params) {}
+
+  RelationshipUpdater(const RelationshipUpdater&) = delete;
+  RelationshipUpdater& operator=(const RelationshipUpdater&) = delete;
+
+  /**
+   * Parameters of the updater, including the relationship decay to read relationships with
+   */
+  const RelationshipParameters& parameters() const {
+    return params;
+  }
+
+  /**
+   * Record the tick's interactions and apply them at the end of each batch
+   */
+  datamodel::world::World::ref_type update(
+    const datamodel::world::World::ref_type& world,
+    drives::ImpactCache* impact_cache = nullptr
+  ) {
+    recordInteractions(world, impact_cache);
+
+    if ((world->getClock()->current_tick + 1) % params.batch_interval != 0) {
+      return world;
+    }
+    return applyInteractions(world);
+  }
+
+  /**
+   * Record the interactions of the world's current tick
+   * Every observation made this tick familiarizes the observer with the actor
+   * (and the object acted on), and leaves part of its drive impacts as an
+   * affective trace toward the actor. The NPC's own observations of an entity
+   * or object familiarize it with what it observed. Every executed action
+   * familiarizes the actor with its target, and resting with the place it
+   * rested in.
+   */
+  void recordInteractions(
+    const datamodel::world::World::ref_type& world,
+    drives::ImpactCache* impact_cache = nullptr
+  ) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint64_t current_time = world->getClock()->current_tick;
+    auto events_by_actor = memory::indexEventsByActor(world->getEvents());
+
+    for (const auto& npc : world->getNPCs()) {
+      const auto& self = npc->getIdentity()->entity;
+      PendingInteractions* npc_pending = nullptr;
+      auto getPending = [&]() -> PendingInteractions& {
+        if (!npc_pending) {
+          npc_pending = &pending[self->handle];
+        }
+        return *npc_pending;
+      };
+
+      // Observations made this tick (including ones continuing an earlier run)
+      for (const auto& memory : npc->getPerception()->recent_perceptions) {
+        if (memory->lastTimestamp() != current_time) {
+          continue;
+        }
+
+        // Perceiving something is recorded as the NPC observing it
+        if (memory->actorHandle() == self->handle) {
+          if (!std::holds_alternative<datamodel::action::action_type::Observe>(memory->action())) {
+            continue;
+          }
+          addTargetInteractions(getPending(), *world, *memory, self->handle, params.perception_familiarity, current_time);
+          continue;
+        }
+
+        // Actors that already left the world are not related to any more
+        const auto* actor = world->findNPC(memory->actorHandle());
+        if (!actor) {
+          continue;
+        }
+
+        datamodel::drives::ActionContext context(npc, memory, *world, current_time, params.decay);
+        datamodel::npc::DriveSet impacts = impact_cache ?
+          impact_cache->getBaseImpact(context) :
+          drives::drive_impact_system::evaluateBaseImpact(context);
+        for (auto& value : impacts.values) {
+          value *= params.trace_rate;
+        }
+
+        addInteraction(getPending(), (*actor)->getIdentity()->entity, params.perception_familiarity, impacts, current_time);
+        if (const auto* target_object = memory->targetObject()) {
+          if (const auto* current = world->findObject(*target_object)) {
+            addInteraction(getPending(), *current, params.perception_familiarity, {}, current_time);
+          }
+        }
+      }
+
+      // The NPC's own action this tick
+      auto event = events_by_actor.find(self->handle);
+      if (event == events_by_actor.end()) {
+        continue;
+      }
+
+      const auto& action = world->getEvents()[event->second];
+      addTargetInteractions(getPending(), *world, *action, self->handle, params.action_familiarity, current_time);
+      if (std::holds_alternative<datamodel::action::action_type::Rest>(action->action())) {
+        addLocationInteraction(getPending(), self->position, params.action_familiarity, current_time);
+      }
+    }
+  }
+
+  /**
+   * Fold the pending interactions into the relationships of the world's NPCs
+   * Only NPCs with pending interactions are rebuilt.
+   */
+  datamodel::world::World::ref_type applyInteractions(const datamodel::world::World::ref_type& world) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (pending.empty()) {
+      return world;
+    }
+
+    std::vector<datamodel::npc::NPC::ref_type> updated_npcs;
+    updated_npcs.reserve(world->getNPCs().size());
+    size_t updated_before = updated_count;
+    size_t created_before = created_count;
+
+    for (const auto& npc : world->getNPCs()) {
+      auto it = pending.find(npc->getIdentity()->entity->handle);
+      if (it == pending.end()) {
+        updated_npcs.push_back(npc);
+        continue;
+      }
+
+      datamodel::npc::NPC updated_npc(
+        npc->getIdentity(),
+        npc->getDrives(),
+        npc->getPerception(),
+        npc->getEpisodicMemory(),
+        npc->getObservedBehaviors(),
+        applyToRelationships(npc->getRelationships(), it->second),
+        npc->getSegmentation()
+      );
+      updated_npcs.push_back(datamodel::npc::NPC::storage::make_entity(std::move(updated_npc)));
+    }
+
+    spdlog::debug("Applied interactions of {} NPCs: {} relationships updated, {} formed",
+                  pending.size(), updated_count - updated_before, created_count - created_before);
+    pending.clear();
+
+    datamodel::world::World updated_world(
+      *world,
+      world->getClock(),
+      std::move(updated_npcs),
+      world->getObjects(),
+      world->getEvents()
+    );
+    return datamodel::world::World::storage::make_entity(std::move(updated_world));
+  }
+
+  /**
+   * Number of NPCs with interactions waiting to be applied
+   */
+  size_t pendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+  }
+
+  /**
+   * Number of existing relationships updated by interactions
+   */
+  uint64_t updatedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return updated_count;
+  }
+
+  /**
+   * Number of relationships formed by interactions
+   */
+  uint64_t createdCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return created_count;
+  }
+
+private:
+  // Accumulated interactions with one target
+  struct Interaction {
+    datamodel::relationship::RelationshipTarget target;
+    float familiarity;
+    datamodel::npc::DriveSet traces;
+    uint32_t count;
+    uint64_t last_time;
+  };
+
+  struct PendingInteractions {
+    std::vector<Interaction> interactions;
+
+    // Position of the interactions with each entity or object (by handle)
+    std::unordered_map<datamodel::entity::EntityHandle, size_t> by_target;
+
+    // Positions of the interactions with locations
+    std::vector<size_t> locations;
+  };
+
+  static void accumulate(
+    Interaction& interaction,
+    float familiarity,
+    const datamodel::npc::DriveSet& traces,
+    uint64_t time
+  ) {
+    interaction.familiarity += familiarity;
+    for (size_t i = 0; i < datamodel::npc::DriveSet::SIZE; ++i) {
+      interaction.traces.values[i] += traces.values[i];
+    }
+    interaction.traces.present |= traces.present;
+    interaction.count++;
+    interaction.last_time = time;
+  }
+
+  template<typename T>
+  static void addInteraction(
+    PendingInteractions& npc_pending,
+    const T& target,
+    float familiarity,
+    const datamodel::npc::DriveSet& traces,
+    uint64_t time
+  ) {
+    auto [it, inserted] = npc_pending.by_target.emplace(
+      datamodel::relationship::relationship_store_system::getHandle(target),
+      npc_pending.interactions.size()
+    );
+    if (inserted) {
+      npc_pending.interactions.push_back(Interaction{target, 0.0f, {}, 0, time});
+    }
+    accumulate(npc_pending.interactions[it->second], familiarity, traces, time);
+  }
+
+  // Interactions with the current versions of an action's targets
+  // (targets that left the world, and the NPC itself, are skipped)
+  static void addTargetInteractions(
+    PendingInteractions& npc_pending,
+    const datamodel::world::World& world,
+    const datamodel::memory::MemoryEntry& action,
+    datamodel::entity::EntityHandle self,
+    float familiarity,
+    uint64_t time
+  ) {
+    const auto* target_entity = action.targetEntity();
+    if (target_entity && *target_entity != self) {
+      if (const auto* current = world.findEntity(*target_entity)) {
+        addInteraction(npc_pending, *current, familiarity, {}, time);
+      }
+    }
+    if (const auto* target_object = action.targetObject()) {
+      if (const auto* current = world.findObject(*target_object)) {
+        addInteraction(npc_pending, *current, familiarity, {}, time);
+      }
+    }
+  }
+
+  void addLocationInteraction(
+    PendingInteractions& npc_pending,
+    const datamodel::world::Position& position,
+    float familiarity,
+    uint64_t time
+  ) {
+    // Interactions close enough together are with the same place
+    for (size_t index : npc_pending.locations) {
+      auto& interaction = npc_pending.interactions[index];
+      if (std::get<datamodel::relationship::LocationPoint>(interaction.target).contains(position)) {
+        accumulate(interaction, familiarity, {}, time);
+        return;
+      }
+    }
+
+    npc_pending.locations.push_back(npc_pending.interactions.size());
+    npc_pending.interactions.push_back(Interaction{
+      datamodel::relationship::LocationPoint(position, params.location_radius), 0.0f, {}, 0, time
+    });
+    accumulate(npc_pending.interactions.back(), familiarity, {}, time);
+  }
+
+  // Relationship after its pending interactions, with the decay up to them applied
+  datamodel::relationship::Relationship::ref_type applyInteraction(
+    const datamodel::relationship::Relationship& relationship,
+    const Interaction& interaction
+  ) const {
+    namespace relationship_system = datamodel::relationship::relationship_system;
+
+    uint64_t time = std::max(interaction.last_time, relationship.last_interaction);
+    float familiarity = relationship_system::getFamiliarity(relationship, time, params.decay) + interaction.familiarity;
+
+    datamodel::npc::DriveSet traces = interaction.traces;
+    for (const auto& trace : relationship.affective_traces) {
+      traces.set(
+        trace.drive_type,
+        traces.get(trace.drive_type) +
+          relationship_system::getAffectiveTrace(relationship, trace.drive_type, time, params.decay)
+      );
+    }
+
+    return makeRelationship(
+      relationship.target,
+      familiarity,
+      traces,
+      time,
+      relationship.interaction_count + interaction.count
+    );
+  }
+
+  static datamodel::relationship::Relationship::ref_type makeRelationship(
+    const datamodel::relationship::RelationshipTarget& target,
+    float familiarity,
+    const datamodel::npc::DriveSet& traces,
+    uint64_t time,
+    uint32_t count
+  ) {
+    datamodel::relationship::AffectiveTraces affective_traces;
+    for (const auto& trace : traces) {
+      float value = std::clamp(trace.intensity, -1.0f, 1.0f);
+      std::visit([&affective_traces, value](const auto& drive_type) {
+        affective_traces.emplace_back(drive_type, value);
+      }, trace.type);
+    }
+
+    datamodel::relationship::Relationship relationship(
+      target,
+      std::clamp(familiarity, 0.0f, 1.0f),
+      std::move(affective_traces),
+      time,
+      count
+    );
+    return datamodel::relationship::Relationship::storage::make_entity(std::move(relationship));
+  }
+
+  // Interactions matching an existing relationship's target
+  static void findMatches(
+    const datamodel::relationship::Relationship& relationship,
+    const PendingInteractions& npc_pending,
+    const std::vector<bool>& applied,
+    std::vector<size_t>& matches
+  ) {
+    matches.clear();
+
+    if (const auto* location = std::get_if<datamodel::relationship::LocationPoint>(&relationship.target)) {
+      // The first location relationship containing the place takes it
+      for (size_t index : npc_pending.locations) {
+        const auto& place = std::get<datamodel::relationship::LocationPoint>(npc_pending.interactions[index].target);
+        if (!applied[index] && location->contains(place.position)) {
+          matches.push_back(index);
+        }
+      }
+      return;
+    }
+
+    datamodel::entity::EntityHandle handle = std::visit([](const auto& target) {
+      using T = std::decay_t<decltype(target)>;
+      if constexpr (std::is_same_v<T, datamodel::relationship::LocationPoint>) {
+        return datamodel::entity::EntityHandle();
+      } else {
+        return datamodel::relationship::relationship_store_system::getHandle(target);
+      }
+    }, relationship.target);
+
+    auto it = npc_pending.by_target.find(handle);
+    if (it != npc_pending.by_target.end() && !applied[it->second]) {
+      matches.push_back(it->second);
+    }
+  }
+
+  datamodel::relationship::RelationshipStore applyToRelationships(
+    const datamodel::relationship::RelationshipStore& relationships,
+    const PendingInteractions& npc_pending
+  ) {
+    std::vector<datamodel::relationship::Relationship::ref_type> result;
+    result.reserve(relationships.size() + npc_pending.interactions.size());
+    std::vector<bool> applied(npc_pending.interactions.size(), false);
+    std::vector<size_t> matches;
+
+    for (const auto& relationship : relationships) {
+      findMatches(*relationship, npc_pending, applied, matches);
+      if (matches.empty()) {
+        result.push_back(relationship);
+        continue;
+      }
+
+      std::optional<datamodel::relationship::Relationship::ref_type> updated;
+      updated.emplace(relationship);
+      for (size_t index : matches) {
+        auto next = applyInteraction(*updated.value(), npc_pending.interactions[index]);
+        updated.emplace(next);
+        applied[index] = true;
+      }
+      result.push_back(updated.value());
+      updated_count++;
+    }
+
+    // Targets the NPC had no relationship with yet
+    for (size_t i = 0; i < npc_pending.interactions.size(); ++i) {
+      if (applied[i]) {
+        continue;
+      }
+      const auto& interaction = npc_pending.interactions[i];
+      result.push_back(makeRelationship(
+        interaction.target,
+        interaction.familiarity,
+        interaction.traces,
+        interaction.last_time,
+        interaction.count
+      ));
+      created_count++;
+    }
+
+    return datamodel::relationship::RelationshipStore(std::move(result));
+  }
+
+  const RelationshipParameters params;
+  std::unordered_map<datamodel::entity::EntityHandle, PendingInteractions> pending;
+  uint64_t updated_count = 0;
+  uint64_t created_count = 0;
+  mutable std::mutex mutex;
+};
+
+} // namespace history_game::systems::relationship
+
+#endif // HISTORY_GAME_SYSTEMS_RELATIONSHIP_RELATIONSHIP_UPDATE_H
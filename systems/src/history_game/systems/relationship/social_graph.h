@@ -0,0 +1,635 @@
+#ifndef HISTORY_GAME_SYSTEMS_RELATIONSHIP_SOCIAL_GRAPH_H
+#define HISTORY_GAME_SYSTEMS_RELATIONSHIP_SOCIAL_GRAPH_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <variant>
+#include <optional>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+#include <history_game/datamodel/npc/npc.h>
+#include <history_game/datamodel/pool/ref_count.h>
+#include <history_game/datamodel/npc/drive_set.h>
+#include <history_game/datamodel/world/world.h>
+#include <history_game/datamodel/relationship/relationship.h>
+#include <history_game/datamodel/relationship/relationship_store.h>
+
+namespace history_game::systems::relationship {
+
+namespace social_graph_system {
+
+  /**
+   * Number of threads to use when none is requested
+   */
+  inline size_t getDefaultThreadCount() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+
+  /**
+   * Threads kept for the lifetime of a graph to run its analytics
+   * The calling thread takes part in every run, so a pool of n threads keeps
+   * n - 1 workers waiting for work.
+   */
+  class WorkerPool {
+  public:
+    explicit WorkerPool(size_t thread_count) : thread_count(std::max<size_t>(1, thread_count)) {
+      workers.reserve(this->thread_count - 1);
+      for (size_t t = 1; t < this->thread_count; ++t) {
+        workers.emplace_back([this, t]() { work(t); });
+      }
+    }
+
+    ~WorkerPool() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      wake.notify_all();
+      for (auto& worker : workers) {
+        worker.join();
+      }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t size() const { return thread_count; }
+
+    /**
+     * Run work(begin, end, worker) over [0, count) split in contiguous chunks,
+     * one per thread (the calling thread takes the first chunk)
+     */
+    template<typename F>
+    void parallelFor(size_t count, F&& work) {
+      size_t threads = std::max<size_t>(1, std::min(thread_count, count));
+      if (threads <= 1) {
+        if (count > 0) {
+          work(size_t{0}, count, size_t{0});
+        }
+        return;
+      }
+
+      size_t chunk = (count + threads - 1) / threads;
+      std::function<void(size_t)> task = [&work, count, chunk](size_t t) {
+        size_t begin = t * chunk;
+        size_t end = std::min(count, begin + chunk);
+        if (begin < end) {
+          work(begin, end, t);
+        }
+      };
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &task;
+        job_threads = threads;
+        pending = threads - 1;
+        generation++;
+      }
+      wake.notify_all();
+
+      task(0);
+
+      std::unique_lock<std::mutex> lock(mutex);
+      while (pending > 0) {
+        done.wait_until(lock, std::chrono::steady_clock::now() + POLL_INTERVAL, [this]() {
+          return pending == 0;
+        });
+      }
+      job = nullptr;
+    }
+
+  private:
+    // How long a waiting thread sleeps before checking again without being notified
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{100};
+
+    void work(size_t index) {
+      uint64_t seen = 0;
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true) {
+        wake.wait_until(lock, std::chrono::steady_clock::now() + POLL_INTERVAL, [this, &seen]() {
+          return stopping || generation != seen;
+        });
+        if (stopping) {
+          return;
+        }
+        if (generation == seen) {
+          continue;
+        }
+        seen = generation;
+
+        // Runs over fewer items than there are threads leave the last workers idle
+        if (index >= job_threads) {
+          continue;
+        }
+
+        const std::function<void(size_t)>* task = job;
+        lock.unlock();
+        (*task)(index);
+        // References the task copied or dropped are counted by the next flush
+        if constexpr (datamodel::pool::ref_count_system::DEFERRED) {
+          datamodel::pool::ref_count_system::publishChanges();
+        }
+        lock.lock();
+        if (--pending == 0) {
+          done.notify_all();
+        }
+      }
+    }
+
+    const size_t thread_count;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t job_threads = 0;
+    size_t pending = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+  };
+
+  /**
+   * Number of distinct labels in a labelling
+   */
+  inline size_t countLabels(const std::vector<uint32_t>& labels) {
+    std::vector<bool> seen(labels.size(), false);
+    size_t count = 0;
+    for (uint32_t label : labels) {
+      if (!seen[label]) {
+        seen[label] = true;
+        count++;
+      }
+    }
+    return count;
+  }
+
+} // namespace social_graph_system
+
+/**
+ * Population-wide view of the relationships between NPCs
+ *
+ * Nodes are the world's NPCs and edges their relationships with other NPCs
+ * (relationships with objects and places are left out), stored in compressed
+ * sparse row form: the edges of node i are [offsets[i], offsets[i + 1]), with
+ * the familiarity and affective traces of each edge in parallel arrays, as
+ * decayed at the time of the last sync. Edges are matched to NPCs by entity
+ * handle, and several relationships of an NPC with the same NPC are merged into
+ * the most recent one.
+ *
+ * sync() keeps the graph up to date with a world: only the NPCs whose
+ * relationships changed since the previous sync are read again, and the
+ * analytics only run over the flat arrays.
+ */
+class SocialGraph {
+public:
+  explicit SocialGraph(
+    const datamodel::relationship::RelationshipDecay& relationship_decay,
+    size_t thread_count = 0
+  ) : decay(relationship_decay),
+      threads(thread_count ? thread_count : social_graph_system::getDefaultThreadCount()),
+      workers(threads) {}
+
+  SocialGraph(const SocialGraph&) = delete;
+  SocialGraph& operator=(const SocialGraph&) = delete;
+
+  /**
+   * Bring the graph up to date with a world
+   */
+  void sync(const datamodel::world::World::ref_type& world) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const auto& npcs = world->getNPCs();
+    std::unordered_map<datamodel::entity::EntityHandle, Row> previous = std::move(rows);
+    rows.clear();
+
+    // Reuse the rows of NPCs whose relationships did not change
+    std::vector<std::optional<Row>> next(npcs.size());
+    std::vector<size_t> stale;
+    for (size_t i = 0; i < npcs.size(); ++i) {
+      const auto& npc = npcs[i];
+      auto it = previous.find(npc->getIdentity()->entity->handle);
+      if (it != previous.end() && sameSource(it->second.source, npc->getRelationships().index)) {
+        next[i].emplace(std::move(it->second));
+      } else {
+        stale.push_back(i);
+      }
+    }
+
+    workers.parallelFor(stale.size(), [&](size_t begin, size_t end, size_t) {
+      for (size_t s = begin; s < end; ++s) {
+        next[stale[s]].emplace(readRow(npcs[stale[s]]));
+      }
+    });
+    reread_count = stale.size();
+
+    node_ids.clear();
+    node_ids.reserve(npcs.size());
+    std::unordered_map<datamodel::entity::EntityHandle, uint32_t> nodes;
+    nodes.reserve(npcs.size());
+    for (size_t i = 0; i < npcs.size(); ++i) {
+      node_ids.push_back(npcs[i]->getIdentity()->entity->id);
+      nodes.emplace(npcs[i]->getIdentity()->entity->handle, static_cast<uint32_t>(i));
+    }
+
+    assemble(next, nodes, world->getClock()->current_tick);
+
+    for (size_t i = 0; i < npcs.size(); ++i) {
+      rows.emplace(npcs[i]->getIdentity()->entity->handle, std::move(next[i].value()));
+    }
+    node_index = std::move(nodes);
+  }
+
+  const datamodel::relationship::RelationshipDecay& getDecay() const { return decay; }
+
+  size_t nodeCount() const { return node_ids.size(); }
+  size_t edgeCount() const { return targets.size(); }
+
+  /**
+   * Number of NPCs read again by the last sync
+   */
+  size_t rereadCount() const { return reread_count; }
+
+  /**
+   * Entity ID of the NPC at a node
+   */
+  const std::string& getNodeId(size_t node) const { return node_ids[node]; }
+
+  /**
+   * Node of the NPC with a given entity handle, if it is in the graph
+   */
+  std::optional<uint32_t> findNode(datamodel::entity::EntityHandle handle) const {
+    auto it = node_index.find(handle);
+    if (it == node_index.end()) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  // Compressed sparse row arrays
+  const std::vector<size_t>& getOffsets() const { return offsets; }
+  const std::vector<uint32_t>& getTargets() const { return targets; }
+  const std::vector<float>& getFamiliarity() const { return familiarity; }
+  const std::vector<datamodel::npc::DriveSet>& getTraces() const { return traces; }
+
+  /**
+   * Degrees of every node
+   */
+  struct Degrees {
+    // Number of NPCs each NPC has a relationship with
+    std::vector<uint32_t> out;
+
+    // Number of NPCs that have a relationship with each NPC
+    std::vector<uint32_t> in;
+
+    // Sum of the familiarity other NPCs have with each NPC
+    std::vector<float> strength;
+  };
+
+  Degrees getDegrees() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t n = nodeCount();
+    Degrees degrees{std::vector<uint32_t>(n), std::vector<uint32_t>(n, 0), std::vector<float>(n, 0.0f)};
+
+    std::vector<std::vector<uint32_t>> in_partial(threads);
+    std::vector<std::vector<float>> strength_partial(threads);
+    workers.parallelFor(n, [&](size_t begin, size_t end, size_t worker) {
+      auto& in = in_partial[worker];
+      auto& strength = strength_partial[worker];
+      in.assign(n, 0);
+      strength.assign(n, 0.0f);
+      for (size_t i = begin; i < end; ++i) {
+        degrees.out[i] = static_cast<uint32_t>(offsets[i + 1] - offsets[i]);
+        for (size_t e = offsets[i]; e < offsets[i + 1]; ++e) {
+          in[targets[e]]++;
+          strength[targets[e]] += familiarity[e];
+        }
+      }
+    });
+
+    for (size_t t = 0; t < threads; ++t) {
+      for (size_t i = 0; i < in_partial[t].size(); ++i) {
+        degrees.in[i] += in_partial[t][i];
+        degrees.strength[i] += strength_partial[t][i];
+      }
+    }
+    return degrees;
+  }
+
+  /**
+   * Weakly connected components
+   * Each node is labelled with the smallest node of its component.
+   */
+  std::vector<uint32_t> getConnectedComponents() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t n = nodeCount();
+    std::vector<uint32_t> labels(n);
+    for (size_t i = 0; i < n; ++i) {
+      labels[i] = static_cast<uint32_t>(i);
+    }
+    std::vector<uint32_t> next(n);
+
+    std::atomic<bool> changed{true};
+    while (changed) {
+      changed = false;
+      workers.parallelFor(n, [&](size_t begin, size_t end, size_t) {
+        bool local_change = false;
+        for (size_t i = begin; i < end; ++i) {
+          uint32_t label = labels[labels[i]];
+          for (size_t e = undirected_offsets[i]; e < undirected_offsets[i + 1]; ++e) {
+            label = std::min(label, labels[undirected_targets[e]]);
+          }
+          next[i] = label;
+          local_change |= label != labels[i];
+        }
+        if (local_change) {
+          changed = true;
+        }
+      });
+      labels.swap(next);
+    }
+    return labels;
+  }
+
+  /**
+   * Communities found by label propagation
+   * Each node takes the label with the highest familiarity among its
+   * neighbors (in either direction), keeping its own on ties, until a round
+   * changes nothing or max_rounds is reached. Nodes are updated one color
+   * class at a time; nodes of the same color are never neighbors, so they
+   * are updated in parallel and the result does not depend on the number of
+   * threads. Each node starts with its own label.
+   */
+  std::vector<uint32_t> getCommunities(size_t max_rounds = 20) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t n = nodeCount();
+    std::vector<uint32_t> labels(n);
+    for (size_t i = 0; i < n; ++i) {
+      labels[i] = static_cast<uint32_t>(i);
+    }
+
+    for (size_t round = 0; round < max_rounds; ++round) {
+      std::atomic<bool> changed{false};
+
+      for (size_t color = 0; color + 1 < color_offsets.size(); ++color) {
+        size_t first = color_offsets[color];
+        workers.parallelFor(color_offsets[color + 1] - first, [&](size_t begin, size_t end, size_t) {
+          std::unordered_map<uint32_t, float> weights;
+          bool local_change = false;
+          for (size_t c = first + begin; c < first + end; ++c) {
+            uint32_t i = color_nodes[c];
+            weights.clear();
+            for (size_t e = undirected_offsets[i]; e < undirected_offsets[i + 1]; ++e) {
+              weights[labels[undirected_targets[e]]] += undirected_weights[e];
+            }
+
+            float best_weight = 0.0f;
+            for (const auto& entry : weights) {
+              best_weight = std::max(best_weight, entry.second);
+            }
+
+            // Keep the current label when it is among the best, else take the smallest
+            uint32_t best = labels[i];
+            auto own = weights.find(best);
+            if (!weights.empty() && (own == weights.end() || own->second < best_weight)) {
+              best = UINT32_MAX;
+              for (const auto& [label, weight] : weights) {
+                if (weight == best_weight) {
+                  best = std::min(best, label);
+                }
+              }
+            }
+
+            local_change |= best != labels[i];
+            labels[i] = best;
+          }
+          if (local_change) {
+            changed = true;
+          }
+        });
+      }
+
+      if (!changed) {
+        break;
+      }
+    }
+    return labels;
+  }
+
+  /**
+   * Affective trace for a drive that each NPC receives from everyone
+   * relating to it (how much others associate it with that drive)
+   */
+  std::vector<float> getIncomingAffect(const datamodel::npc::DriveType& drive) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t n = nodeCount();
+    size_t d = drive.index();
+
+    std::vector<std::vector<float>> partial(threads);
+    workers.parallelFor(n, [&](size_t begin, size_t end, size_t worker) {
+      auto& affect = partial[worker];
+      affect.assign(n, 0.0f);
+      for (size_t i = begin; i < end; ++i) {
+        for (size_t e = offsets[i]; e < offsets[i + 1]; ++e) {
+          affect[targets[e]] += traces[e].values[d];
+        }
+      }
+    });
+
+    std::vector<float> affect(n, 0.0f);
+    for (const auto& part : partial) {
+      for (size_t i = 0; i < part.size(); ++i) {
+        affect[i] += part[i];
+      }
+    }
+    return affect;
+  }
+
+private:
+  // Relationship with another NPC, as read from the NPC
+  struct RowEdge {
+    datamodel::entity::EntityHandle target;
+    float familiarity;
+    std::vector<std::pair<size_t, float>> traces;
+    uint64_t last_interaction;
+  };
+
+  struct Row {
+    // Relationships the row was read from (none for an NPC without any)
+    std::optional<datamodel::relationship::RelationshipIndex::ref_type> source;
+    std::vector<RowEdge> edges;
+  };
+
+  static bool sameSource(
+    const std::optional<datamodel::relationship::RelationshipIndex::ref_type>& a,
+    const std::optional<datamodel::relationship::RelationshipIndex::ref_type>& b
+  ) {
+    if (!a || !b) {
+      return !a && !b;
+    }
+    return a.value() == b.value();
+  }
+
+  static Row readRow(const datamodel::npc::NPC::ref_type& npc) {
+    Row row;
+    if (npc->getRelationships().index) {
+      row.source.emplace(npc->getRelationships().index.value());
+    }
+
+    std::unordered_map<datamodel::entity::EntityHandle, size_t> by_target;
+    for (const auto& relationship : npc->getRelationships()) {
+      const auto* entity = std::get_if<datamodel::entity::Entity::ref_type>(&relationship->target);
+      if (!entity || (*entity)->handle == npc->getIdentity()->entity->handle) {
+        continue;
+      }
+
+      RowEdge edge{(*entity)->handle, relationship->familiarity, {}, relationship->last_interaction};
+      for (const auto& trace : relationship->affective_traces) {
+        edge.traces.emplace_back(trace.drive_type.index(), trace.value);
+      }
+
+      // Keep the most recent relationship with each NPC
+      auto [it, inserted] = by_target.emplace(edge.target, row.edges.size());
+      if (inserted) {
+        row.edges.push_back(std::move(edge));
+      } else if (edge.last_interaction > row.edges[it->second].last_interaction) {
+        row.edges[it->second] = std::move(edge);
+      }
+    }
+    return row;
+  }
+
+  // Build the CSR arrays, their undirected counterpart and the node coloring from the rows
+  void assemble(
+    const std::vector<std::optional<Row>>& next,
+    const std::unordered_map<datamodel::entity::EntityHandle, uint32_t>& nodes,
+    uint64_t current_time
+  ) {
+    size_t n = next.size();
+
+    offsets.assign(n + 1, 0);
+    targets.clear();
+    familiarity.clear();
+    traces.clear();
+
+    for (size_t i = 0; i < n; ++i) {
+      for (const auto& edge : next[i]->edges) {
+        auto node = nodes.find(edge.target);
+        if (node == nodes.end()) {
+          continue;
+        }
+
+        targets.push_back(node->second);
+        familiarity.push_back(edge.familiarity * datamodel::relationship::relationship_system::getDecayFactor(
+          edge.last_interaction, current_time, decay.familiarity_half_life, decay));
+
+        float trace_decay = datamodel::relationship::relationship_system::getDecayFactor(
+          edge.last_interaction, current_time, decay.trace_half_life, decay);
+        datamodel::npc::DriveSet edge_traces;
+        for (const auto& [drive, value] : edge.traces) {
+          edge_traces.set(drive, value * trace_decay);
+        }
+        traces.push_back(edge_traces);
+      }
+      offsets[i + 1] = targets.size();
+    }
+
+    // Every edge appears in the lists of both of its ends
+    undirected_offsets.assign(n + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+      undirected_offsets[i + 1] += offsets[i + 1] - offsets[i];
+      for (size_t e = offsets[i]; e < offsets[i + 1]; ++e) {
+        undirected_offsets[targets[e] + 1]++;
+      }
+    }
+    for (size_t i = 0; i < n; ++i) {
+      undirected_offsets[i + 1] += undirected_offsets[i];
+    }
+
+    undirected_targets.assign(undirected_offsets[n], 0);
+    undirected_weights.assign(undirected_offsets[n], 0.0f);
+    std::vector<size_t> fill(undirected_offsets.begin(), undirected_offsets.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t e = offsets[i]; e < offsets[i + 1]; ++e) {
+        uint32_t j = targets[e];
+        undirected_targets[fill[i]] = j;
+        undirected_weights[fill[i]++] = familiarity[e];
+        undirected_targets[fill[j]] = static_cast<uint32_t>(i);
+        undirected_weights[fill[j]++] = familiarity[e];
+      }
+    }
+
+    // Greedy coloring, so that label propagation can update independent nodes together
+    std::vector<uint32_t> colors(n, UINT32_MAX);
+    std::vector<size_t> color_sizes;
+    std::vector<bool> taken;
+    for (size_t i = 0; i < n; ++i) {
+      taken.assign(color_sizes.size() + 1, false);
+      for (size_t e = undirected_offsets[i]; e < undirected_offsets[i + 1]; ++e) {
+        uint32_t neighbor_color = colors[undirected_targets[e]];
+        if (neighbor_color < taken.size()) {
+          taken[neighbor_color] = true;
+        }
+      }
+
+      uint32_t color = 0;
+      while (taken[color]) {
+        color++;
+      }
+      if (color == color_sizes.size()) {
+        color_sizes.push_back(0);
+      }
+      colors[i] = color;
+      color_sizes[color]++;
+    }
+
+    color_offsets.assign(color_sizes.size() + 1, 0);
+    for (size_t c = 0; c < color_sizes.size(); ++c) {
+      color_offsets[c + 1] = color_offsets[c] + color_sizes[c];
+    }
+    color_nodes.assign(n, 0);
+    std::vector<size_t> color_fill(color_offsets.begin(), color_offsets.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+      color_nodes[color_fill[colors[i]]++] = static_cast<uint32_t>(i);
+    }
+  }
+
+  const datamodel::relationship::RelationshipDecay decay;
+  const size_t threads;
+
+  // Workers shared by sync() and the analytics, used under the graph mutex
+  mutable social_graph_system::WorkerPool workers;
+
+  std::vector<std::string> node_ids;
+  std::unordered_map<datamodel::entity::EntityHandle, uint32_t> node_index;
+  std::unordered_map<datamodel::entity::EntityHandle, Row> rows;
+  size_t reread_count = 0;
+
+  std::vector<size_t> offsets;
+  std::vector<uint32_t> targets;
+  std::vector<float> familiarity;
+  std::vector<datamodel::npc::DriveSet> traces;
+
+  std::vector<size_t> undirected_offsets;
+  std::vector<uint32_t> undirected_targets;
+  std::vector<float> undirected_weights;
+
+  // Nodes grouped by color (no two neighbors share one)
+  std::vector<size_t> color_offsets;
+  std::vector<uint32_t> color_nodes;
+
+  mutable std::mutex mutex;
+};
+
+} // namespace history_game::systems::relationship
+
+#endif // HISTORY_GAME_SYSTEMS_RELATIONSHIP_SOCIAL_GRAPH_H
@@ -8,6 +8,7 @@
 #include <history_game/systems/drives/drive_dynamics.h>
 #include <history_game/systems/behavior/action_selection.h>
 #include <history_game/systems/memory/episode_formation.h>
+#include <history_game/systems/memory/memory_budget.h>
 
 namespace history_game::systems::simulation {
 
@@ -27,6 +28,10 @@ struct NPCUpdateParams {
   const float significance_threshold;
   const uint64_t max_sequence_gap;
   const size_t min_sequence_length;
+  const size_t max_sequence_length;
+  
+  // Per-NPC long-term memory limits
+  const memory::MemoryBudget memory_budget;
   
   // Constructor with default values
   NPCUpdateParams(
@@ -36,14 +41,18 @@ struct NPCUpdateParams {
     float rand = 0.2f,
     float sig_threshold = 0.3f,
     uint64_t max_gap = 5,
-    size_t min_length = 2
+    size_t min_length = 2,
+    size_t max_length = 16,
+    memory::MemoryBudget budget = {}
   ) : drive_params(std::move(drives)),
       familiarity_preference(f_pref),
       social_preference(s_pref),
       randomness(rand),
       significance_threshold(sig_threshold),
       max_sequence_gap(max_gap),
-      min_sequence_length(min_length) {}
+      min_sequence_length(min_length),
+      max_sequence_length(max_length),
+      memory_budget(budget) {}
 };
 
 namespace npc_update_system {
@@ -55,9 +64,12 @@ namespace npc_update_system {
     const datamodel::npc::NPC::ref_type& npc,
     const datamodel::world::World::ref_type& world,
     const NPCUpdateParams& params,
-    uint64_t current_time
+    uint64_t current_time,
+    const datamodel::relationship::RelationshipDecay& relationship_decay,
+    memory::SequenceTrie* sequence_trie = nullptr,
+    drives::ImpactCache* impact_cache = nullptr
   ) {
-    const std::string& npc_id = npc->identity->entity->id;
+    const std::string& npc_id = npc->getIdentity()->entity->id;
     
     // 1. Update drives based on natural increase
     auto npc_with_drives = drives::drive_dynamics_system::updateDrives(
@@ -69,22 +81,36 @@ namespace npc_update_system {
     // 2. Process perception to form episodic memories
     auto npc_with_memories = memory::formEpisodicMemories(
       npc_with_drives,
+      *world,
       current_time,
+      relationship_decay,
       params.significance_threshold,
       params.max_sequence_gap,
-      params.min_sequence_length
+      params.min_sequence_length,
+      params.max_sequence_length,
+      sequence_trie,
+      impact_cache
     );
     
-    // 3. Select the next action based on drives and context
+    // 3. Forget the least significant memories if over budget
+    auto npc_within_budget = memory::memory_budget_system::enforceBudget(
+      npc_with_memories,
+      params.memory_budget,
+      current_time,
+      relationship_decay,
+      sequence_trie
+    );
+    
+    // 4. Select the next action based on drives and context
     behavior::ActionSelectionCriteria criteria(
-      npc_with_memories->drives,
+      npc_within_budget->getDrives(),
       params.familiarity_preference,
       params.social_preference,
       params.randomness
     );
     
     auto npc_with_action = behavior::action_selection_system::selectNextAction(
-      npc_with_memories,
+      npc_within_budget,
       world,
       criteria
     );
@@ -97,29 +123,34 @@ namespace npc_update_system {
    */
   inline datamodel::world::World::ref_type updateAllNPCs(
     const datamodel::world::World::ref_type& world,
-    const NPCUpdateParams& params
+    const NPCUpdateParams& params,
+    const datamodel::relationship::RelationshipDecay& relationship_decay,
+    memory::SequenceTrie* sequence_trie = nullptr,
+    drives::ImpactCache* impact_cache = nullptr
   ) {
     // Get the current time from the simulation clock
-    uint64_t current_time = world->clock->current_tick;
+    uint64_t current_time = world->getClock()->current_tick;
     
     spdlog::info("Updating all {} NPCs at tick {}", 
-                world->npcs.size(), current_time);
+                world->getNPCs().size(), current_time);
     
     // Update each NPC
     std::vector<datamodel::npc::NPC::ref_type> updated_npcs;
-    updated_npcs.reserve(world->npcs.size());
+    updated_npcs.reserve(world->getNPCs().size());
     
-    for (const auto& npc : world->npcs) {
+    for (const auto& npc : world->getNPCs()) {
       updated_npcs.push_back(
-        updateNPC(npc, world, params, current_time)
+        updateNPC(npc, world, params, current_time, relationship_decay, sequence_trie, impact_cache)
       );
     }
     
     // Create a new world with updated NPCs
     datamodel::world::World updated_world(
-      world->clock,
+      *world,
+      world->getClock(),
       std::move(updated_npcs),
-      world->objects
+      world->getObjects(),
+      world->getEvents()
     );
     
     spdlog::info("Completed updating all NPCs at tick {}", current_time);
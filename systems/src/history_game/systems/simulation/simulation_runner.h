@@ -1,15 +1,22 @@
 #ifndef HISTORY_GAME_SYSTEMS_SIMULATION_SIMULATION_RUNNER_H
 #define HISTORY_GAME_SYSTEMS_SIMULATION_SIMULATION_RUNNER_H
 
+#include <optional>
 #include <functional>
 #include <spdlog/spdlog.h>
 #include <chrono>
 #include <history_game/datamodel/world/world.h>
+#include <history_game/datamodel/entity/entity_registry.h>
 #include <history_game/systems/simulation/npc_update.h>
 #include <history_game/systems/memory/memory_system.h>
 #include <history_game/datamodel/world/simulation_clock.h>
 #include <history_game/systems/utility/serialization.h>
 #include <history_game/systems/action/action_execution.h>
+#include <history_game/systems/perception/convergence_detector.h>
+#include <history_game/systems/relationship/relationship_update.h>
+#include <history_game/systems/relationship/social_graph.h>
+#include <history_game/systems/simulation/world_reclaimer.h>
+#include <history_game/datamodel/pool/hash_cons.h>
 
 namespace history_game::systems::simulation {
 
@@ -59,9 +66,13 @@ namespace history_game::systems::simulation {
     const datamodel::world::World::ref_type& world,
     const NPCUpdateParams& params,
     float perception_range = 10.0f,
-    utility::SimulationLogger* logger = nullptr
+    utility::SimulationLogger* logger = nullptr,
+    memory::SequenceTrie* sequence_trie = nullptr,
+    perception::ConvergenceDetector* convergence_detector = nullptr,
+    drives::ImpactCache* impact_cache = nullptr,
+    relationship::RelationshipUpdater* relationship_updater = nullptr
   ) {
-    spdlog::info("Processing simulation tick {}", world->clock->current_tick);
+    spdlog::info("Processing simulation tick {}", world->getClock()->current_tick);
     
     // Log tick start event if logger is provided
     if (logger && logger->isInitialized()) {
@@ -70,34 +81,77 @@ namespace history_game::systems::simulation {
       
       logger->logEvent(utility::createTickStartEvent(
         current_time, 
-        world->clock->current_tick, 
-        world->clock->current_generation
+        world->getClock()->current_tick, 
+        world->getClock()->current_generation
       ));
     }
     
+    // Relationships are read with the decay they are updated with
+    const datamodel::relationship::RelationshipDecay relationship_decay = relationship_updater ?
+      relationship_updater->parameters().decay :
+      datamodel::relationship::RelationshipDecay();
+    
     // 1. Update all NPCs (including action selection)
-    spdlog::debug("Updating NPCs (count: {})", world->npcs.size());
-    auto world_with_actions = npc_update_system::updateAllNPCs(world, params);
+    spdlog::debug("Updating NPCs (count: {})", world->getNPCs().size());
+    auto world_with_actions = npc_update_system::updateAllNPCs(
+      world, params, relationship_decay, sequence_trie, impact_cache);
 
     // 2. Execute NPC actions
     spdlog::debug("Executing NPC actions");
     auto world_after_actions = action::executeAllActions(world_with_actions, logger);
     
+    // Detect NPCs converging on the same action in the same place
+    if (convergence_detector) {
+      auto convergences = convergence_detector->observe(
+        *world_after_actions,
+        world->getClock()->current_tick
+      );
+      
+      for (const auto& convergence : convergences) {
+        std::string action_name = behavior::action_selection_system::get_action_name(convergence.action);
+        spdlog::info("{} NPCs converge on {} in cell ({}, {})",
+                     convergence.participants, action_name,
+                     convergence.cell_x, convergence.cell_y);
+        
+        if (logger && logger->isInitialized()) {
+          uint64_t current_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+          
+          logger->logEvent(utility::createConvergenceEvent(
+            current_time,
+            convergence.tick,
+            action_name,
+            convergence.cell_x,
+            convergence.cell_y,
+            static_cast<uint32_t>(convergence.participants)
+          ));
+        }
+      }
+    }
+    
     // 3. Process perceptions based on the new actions
     spdlog::debug("Processing perceptions (range: {:.2f})", perception_range);
     auto world_with_perceptions = memory::processPerceptions(
       world_after_actions,
+      relationship_decay,
       perception_range
     );
     
+    // Fold the tick's interactions into relationships (applied in batches)
+    auto world_with_relationships = relationship_updater ?
+      relationship_updater->update(world_with_perceptions, impact_cache) :
+      world_with_perceptions;
+    
     // 3. Advance the simulation clock
-    auto updated_clock = advanceClock(world_with_perceptions->clock);
+    auto updated_clock = advanceClock(world_with_relationships->getClock());
     
     // 4. Create a new world with the updated clock
     datamodel::world::World updated_world(
+      *world_with_relationships,
       updated_clock,
-      world_with_perceptions->npcs,
-      world_with_perceptions->objects
+      world_with_relationships->getNPCs(),
+      world_with_relationships->getObjects(),
+      world_with_relationships->getEvents()
     );
     
     auto result = datamodel::world::World::storage::make_entity(std::move(updated_world));
@@ -110,28 +164,28 @@ namespace history_game::systems::simulation {
       // Log tick end event
       logger->logEvent(utility::createTickEndEvent(
         current_time, 
-        world->clock->current_tick, 
-        world->clock->current_generation,
-        result->npcs.size(),
-        result->objects.size()
+        world->getClock()->current_tick, 
+        world->getClock()->current_generation,
+        result->getNPCs().size(),
+        result->getObjects().size()
       ));
       
       // Log entity updates - sample a few NPCs and objects to avoid too much data
-      int npc_count = std::min(10, static_cast<int>(result->npcs.size()));
-      int obj_count = std::min(10, static_cast<int>(result->objects.size()));
+      int npc_count = std::min(10, static_cast<int>(result->getNPCs().size()));
+      int obj_count = std::min(10, static_cast<int>(result->getObjects().size()));
       
       // Log NPC positions and states
       for (int i = 0; i < npc_count; i++) {
-        const auto& npc = result->npcs[i];
+        const auto& npc = result->getNPCs()[i];
         
         // Create position JSON
         json position;
-        position["x"] = npc->identity->entity->position.x;
-        position["y"] = npc->identity->entity->position.y;
+        position["x"] = npc->getIdentity()->entity->position.x;
+        position["y"] = npc->getIdentity()->entity->position.y;
         
         // Create drives JSON
         json drives = json::array();
-        for (const auto& drive : npc->drives) {
+        for (const auto& drive : npc->getDrives()) {
           json drive_json;
           drive_json["type"] = drives::drive_dynamics_system::get_drive_name(drive.type);
           drive_json["value"] = drive.intensity;
@@ -140,14 +194,14 @@ namespace history_game::systems::simulation {
         
         // Get current action if any
         std::optional<std::string> action;
-        if (npc->identity->current_action) {
-          action = behavior::action_selection_system::get_action_name(npc->identity->current_action.value());
+        if (npc->getIdentity()->current_action) {
+          action = behavior::action_selection_system::get_action_name(npc->getIdentity()->current_action.value());
         }
         
         // Log entity update event
         logger->logEvent(utility::createEntityUpdateEvent(
           current_time, 
-          npc->identity->entity->id, 
+          npc->getIdentity()->entity->id, 
           "NPC", 
           position, 
           drives, 
@@ -157,7 +211,7 @@ namespace history_game::systems::simulation {
       
       // Log object positions
       for (int i = 0; i < obj_count; i++) {
-        const auto& object = result->objects[i];
+        const auto& object = result->getObjects()[i];
         
         // Create position JSON
         json position;
@@ -174,11 +228,37 @@ namespace history_game::systems::simulation {
       }
     }
     
-    spdlog::debug("Completed processing tick {}", world->clock->current_tick);
+    spdlog::debug("Completed processing tick {}", world->getClock()->current_tick);
     
     return result;
   }
   
+  /**
+   * Release the handles of the NPCs and objects of a world missing from its next version
+   */
+  inline void releaseDeparted(
+    const datamodel::world::World& previous,
+    const datamodel::world::World& next,
+    datamodel::entity::EntityRegistry& registry
+  ) {
+    // A shared directory means nobody arrived or left
+    if (previous.getDirectory() == next.getDirectory()) {
+      return;
+    }
+    
+    auto release_if_gone = [&](datamodel::entity::EntityHandle handle) {
+      if (!next.findNPC(handle) && !next.findObject(handle)) {
+        registry.release(handle);
+      }
+    };
+    for (const auto& npc : previous.getNPCs()) {
+      release_if_gone(npc->getIdentity()->entity->handle);
+    }
+    for (const auto& object : previous.getObjects()) {
+      release_if_gone(object->entity->handle);
+    }
+  }
+  
   /**
    * Run the simulation for a specified number of ticks
    * 
@@ -187,6 +267,13 @@ namespace history_game::systems::simulation {
    * @param params Parameters for NPC updates
    * @param perception_range The distance at which NPCs can perceive others
    * @param callback Optional callback to call after each tick
+   * @param sequence_trie Optional population-wide trie counting who remembers each action sequence
+   * @param convergence_detector Optional detector of NPCs converging on the same action
+   * @param impact_cache Optional per-NPC cache of observation impacts
+   * @param relationship_updater Optional batched updater of NPC relationships
+   * @param world_reclaimer Optional reclaimer freeing the retired world versions
+   * @param social_graph Optional social graph, synced with the world at every relationship decay step
+   * @param entity_registry Optional registry of the world's entities, releasing the handles of those that leave it
    * @return The final world state after all ticks
    */
   // Helper function to run a single tick
@@ -197,10 +284,16 @@ namespace history_game::systems::simulation {
     uint64_t tick_number,
     uint64_t total_ticks,
     const std::function<void(const datamodel::world::World::ref_type&, uint64_t)>& callback,
-    utility::SimulationLogger* logger = nullptr
+    utility::SimulationLogger* logger = nullptr,
+    memory::SequenceTrie* sequence_trie = nullptr,
+    perception::ConvergenceDetector* convergence_detector = nullptr,
+    drives::ImpactCache* impact_cache = nullptr,
+    relationship::RelationshipUpdater* relationship_updater = nullptr
   ) {
     // Process one tick
-    datamodel::world::World::ref_type next_world = processTick(world, params, perception_range, logger);
+    datamodel::world::World::ref_type next_world = processTick(world, params, perception_range, logger,
+                                                           sequence_trie, convergence_detector,
+                                                           impact_cache, relationship_updater);
     
     // Call the callback if provided
     if (callback) {
@@ -216,50 +309,71 @@ namespace history_game::systems::simulation {
     return next_world;
   }
 
-  // Recursive implementation to avoid reassigning references
-  inline datamodel::world::World::ref_type runSimulationRecursive(
-    const datamodel::world::World::ref_type& world,
-    uint64_t remaining_ticks,
-    uint64_t total_ticks,
-    uint64_t current_tick,
-    const NPCUpdateParams& params,
-    float perception_range,
-    const std::function<void(const datamodel::world::World::ref_type&, uint64_t)>& callback,
-    utility::SimulationLogger* logger = nullptr
-  ) {
-    if (remaining_ticks == 0) {
-      return world;
-    }
-    
-    // Process one tick
-    datamodel::world::World::ref_type next_world = runTick(world, params, perception_range, 
-                                        current_tick, total_ticks, callback, logger);
-    
-    // Process remaining ticks recursively
-    return runSimulationRecursive(next_world, remaining_ticks - 1, total_ticks, 
-                                current_tick + 1, params, perception_range, callback, logger);
-  }
-
   inline datamodel::world::World::ref_type runSimulation(
     const datamodel::world::World::ref_type& world,
     uint64_t ticks,
     const NPCUpdateParams& params,
     float perception_range = 10.0f,
     utility::SimulationLogger* logger = nullptr,
-    const std::function<void(const datamodel::world::World::ref_type&, uint64_t)>& callback = nullptr
+    const std::function<void(const datamodel::world::World::ref_type&, uint64_t)>& callback = nullptr,
+    memory::SequenceTrie* sequence_trie = nullptr,
+    perception::ConvergenceDetector* convergence_detector = nullptr,
+    drives::ImpactCache* impact_cache = nullptr,
+    relationship::RelationshipUpdater* relationship_updater = nullptr,
+    WorldReclaimer* world_reclaimer = nullptr,
+    relationship::SocialGraph* social_graph = nullptr,
+    datamodel::entity::EntityRegistry* entity_registry = nullptr
   ) {
     spdlog::info("Starting simulation for {} ticks (initial tick: {})", 
-                ticks, world->clock->current_tick);
+                ticks, world->getClock()->current_tick);
     spdlog::info("World contains {} NPCs and {} objects", 
-                world->npcs.size(), world->objects.size());
+                world->getNPCs().size(), world->getObjects().size());
+    
+    // Keep only the current world version, replacing it without reassigning references
+    std::optional<datamodel::world::World::ref_type> current_world;
+    current_world.emplace(world);
+    
+    for (uint64_t tick = 1; tick <= ticks; ++tick) {
+      datamodel::world::World::ref_type next_world = runTick(current_world.value(), params, perception_range,
+                                                             tick, ticks, callback, logger, sequence_trie,
+                                                             convergence_detector, impact_cache,
+                                                             relationship_updater);
+      
+      // NPCs and objects that left the world give their handles back
+      if (entity_registry) {
+        releaseDeparted(*current_world.value(), *next_world, *entity_registry);
+      }
+      
+      // Free the previous version away from the tick if there is a reclaimer
+      if (world_reclaimer) {
+        world_reclaimer->retire(current_world.value());
+        world_reclaimer->advanceEpoch();
+      }
+      current_world.emplace(next_world);
+      
+      // Keep the social graph up to date at every relationship decay step
+      if (social_graph && social_graph->getDecay().period > 0 &&
+          current_world.value()->getClock()->current_tick % social_graph->getDecay().period == 0) {
+        social_graph->sync(current_world.value());
+      }
+      
+      // Values shared by hash-consing are kept from one tick to the next
+      datamodel::pool::hash_cons_system::advanceGeneration();
+      
+      // Apply the references copied and dropped during the tick when counts are
+      // deferred, unless the reclaimer already does it in the background
+      if constexpr (datamodel::pool::ref_count_system::DEFERRED) {
+        if (!world_reclaimer) {
+          datamodel::pool::ref_count_system::flushChanges();
+        }
+      }
+    }
     
-    // Use recursion to avoid reassigning references
-    datamodel::world::World::ref_type final_world = runSimulationRecursive(world, ticks, ticks, 1, 
-                                                        params, perception_range, callback, logger);
+    const datamodel::world::World::ref_type& final_world = current_world.value();
     
     spdlog::info("Simulation complete - final tick: {}, generation: {}", 
-                final_world->clock->current_tick,
-                final_world->clock->current_generation);
+                final_world->getClock()->current_tick,
+                final_world->getClock()->current_generation);
     
     return final_world;
   }
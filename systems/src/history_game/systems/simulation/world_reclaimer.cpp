@@ -0,0 +1,6 @@
+// filepath: /home/ruoso/devel/history-game/src/history_game/systems/simulation/world_reclaimer.cpp
+#include <history_game/systems/simulation/world_reclaimer.h>
+
+namespace history_game::systems::simulation {
+// Empty implementation file
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+#ifndef HISTORY_GAME_SYSTEMS_SIMULATION_WORLD_RECLAIMER_H
+#define HISTORY_GAME_SYSTEMS_SIMULATION_WORLD_RECLAIMER_H
+
+#include <mutex>
+#include <deque>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <condition_variable>
+#include <history_game/datamodel/world/world.h>
+#include <history_game/datamodel/pool/ref_count.h>
+#include <history_game/datamodel/pool/pool_stats.h>
+
+namespace history_game::systems::simulation {
+
+/**
+ * Frees retired world versions away from the tick
+ *
+ * Worlds retired during a tick make up that tick's epoch. When the epoch
+ * advances, the batch is handed to a background thread, which drops the
+ * references and with them everything only those worlds kept alive (NPCs,
+ * perception buffers, memories, episodes...). Anything still referenced
+ * elsewhere survives, as with any other dropped reference.
+ *
+ * References can only be dropped on another thread when every datamodel type
+ * counts them atomically (HISTORY_GAME_REFCOUNT=atomic) or defers the counts
+ * (HISTORY_GAME_REFCOUNT=deferred, the default). With deferred counts the
+ * background thread also flushes the counts once per epoch, so everything
+ * dropped during the tick, not only the retired worlds, is freed there.
+ * With plain counts the batches are freed on the calling thread when the
+ * epoch advances, so the tick still pays for them, only once per tick.
+ */
+class WorldReclaimer {
+public:
+  // Whether batches are freed by a background thread in this build
+  static constexpr bool BACKGROUND = datamodel::pool::ref_count_system::RELEASE_ON_ANY_THREAD;
+
+  WorldReclaimer() {
+    if constexpr (BACKGROUND) {
+      worker = std::thread([this] { run(); });
+    }
+  }
+
+  WorldReclaimer(const WorldReclaimer&) = delete;
+  WorldReclaimer& operator=(const WorldReclaimer&) = delete;
+
+  ~WorldReclaimer() {
+    advanceEpoch();
+    if (worker.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      wake.notify_one();
+      worker.join();
+    }
+  }
+
+  /**
+   * Hand over a world version no longer needed by the simulation
+   */
+  void retire(const datamodel::world::World::ref_type& world) {
+    retiring.push_back(world);
+  }
+
+  /**
+   * Close the current epoch and queue its worlds for reclamation
+   */
+  void advanceEpoch() {
+    // Deferred counts are flushed every epoch, even without retired worlds
+    if constexpr (datamodel::pool::ref_count_system::DEFERRED) {
+      datamodel::pool::ref_count_system::publishChanges();
+    } else if (retiring.empty()) {
+      return;
+    }
+
+    std::vector<datamodel::world::World::ref_type> batch;
+    batch.swap(retiring);
+
+    if constexpr (!BACKGROUND) {
+      reclaim(batch);
+    } else {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(std::move(batch));
+      }
+      wake.notify_one();
+    }
+  }
+
+  /**
+   * Wait until every queued batch is freed
+   */
+  void drain() {
+    advanceEpoch();
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (!drained.wait_until(lock, std::chrono::steady_clock::now() + POLL_INTERVAL,
+                                 [this] { return queued.empty() && !reclaiming; })) {}
+    }
+    if constexpr (datamodel::pool::ref_count_system::DEFERRED) {
+      datamodel::pool::ref_count_system::settleChanges();
+    }
+  }
+
+  uint64_t retiredCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reclaimed_worlds + queuedWorlds() + retiring.size();
+  }
+
+  uint64_t reclaimedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reclaimed_worlds;
+  }
+
+  uint64_t batchCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reclaimed_batches;
+  }
+
+  /**
+   * Time spent freeing the reclaimed worlds
+   */
+  std::chrono::nanoseconds reclaimTime() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reclaim_time;
+  }
+
+private:
+  // Longest a waiting thread sleeps before checking again
+  static constexpr std::chrono::milliseconds POLL_INTERVAL{100};
+
+  size_t queuedWorlds() const {
+    size_t count = 0;
+    for (const auto& batch : queued) {
+      count += batch.size();
+    }
+    return count;
+  }
+
+  void reclaim(std::vector<datamodel::world::World::ref_type>& batch) {
+    auto start = std::chrono::steady_clock::now();
+    size_t count = batch.size();
+    batch.clear();
+    if constexpr (datamodel::pool::ref_count_system::DEFERRED) {
+      datamodel::pool::ref_count_system::flushChanges();
+    }
+    // The worker counts the freed objects in its own counters, add them now
+    datamodel::pool::pool_system::flushThreadCounts();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    reclaimed_worlds += count;
+    if (count > 0) {
+      reclaimed_batches++;
+    }
+    reclaim_time += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      wake.wait_until(lock, std::chrono::steady_clock::now() + POLL_INTERVAL,
+                      [this] { return stopping || !queued.empty(); });
+      if (queued.empty()) {
+        if (stopping) {
+          return;
+        }
+        continue;
+      }
+
+      std::vector<datamodel::world::World::ref_type> batch = std::move(queued.front());
+      queued.pop_front();
+      reclaiming = true;
+      lock.unlock();
+      reclaim(batch);
+      lock.lock();
+      reclaiming = false;
+      drained.notify_all();
+    }
+  }
+
+  // Worlds retired in the current epoch (only touched by the simulation thread)
+  std::vector<datamodel::world::World::ref_type> retiring;
+
+  std::deque<std::vector<datamodel::world::World::ref_type>> queued;
+  bool reclaiming = false;
+  bool stopping = false;
+  uint64_t reclaimed_worlds = 0;
+  uint64_t reclaimed_batches = 0;
+  std::chrono::nanoseconds reclaim_time{0};
+  mutable std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable drained;
+  std::thread worker;
+};
+
+} // namespace history_game::systems::simulation
+
+#endif // HISTORY_GAME_SYSTEMS_SIMULATION_WORLD_RECLAIMER_H
@@ -122,6 +122,23 @@ json ActionExecutionData::serialize() const {
     return j;
 }
 
+ConvergenceData::ConvergenceData(uint64_t time, uint64_t tick, const std::string& action,
+                                 int32_t x, int32_t y, uint32_t participant_count)
+    : EventData(time), tick_number(tick), action_type(action),
+      cell_x(x), cell_y(y), participants(participant_count) {}
+
+json ConvergenceData::serialize() const {
+    json j;
+    j["timestamp"] = timestamp;
+    j["type"] = event_type::Convergence{}.name;
+    j["tick_number"] = tick_number;
+    j["action_type"] = action_type;
+    j["cell"] = {{"x", cell_x}, {"y", cell_y}};
+    j["participants"] = participants;
+    
+    return j;
+}
+
 /**
  * Serialize any event using std::visit
  */
@@ -164,6 +181,11 @@ SimulationEvent createActionExecutionEvent(uint64_t time, const std::string& id,
     return ActionExecutionData(time, id, action, target);
 }
 
+SimulationEvent createConvergenceEvent(uint64_t time, uint64_t tick, const std::string& action,
+                                     int32_t cell_x, int32_t cell_y, uint32_t participants) {
+    return ConvergenceData(time, tick, action, cell_x, cell_y, participants);
+}
+
 /**
  * SimulationLogger implementation
  */
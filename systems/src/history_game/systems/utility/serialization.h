@@ -29,6 +29,7 @@ namespace event_type {
     struct RelationshipUpdate { static constexpr auto name = "RELATIONSHIP_UPDATE"; };
     struct SimulationStart { static constexpr auto name = "SIMULATION_START"; };
     struct SimulationEnd { static constexpr auto name = "SIMULATION_END"; };
+    struct Convergence { static constexpr auto name = "CONVERGENCE"; };
 }
 
 /**
@@ -44,7 +45,8 @@ using EventType = std::variant<
     event_type::MemoryFormation,
     event_type::RelationshipUpdate,
     event_type::SimulationStart,
-    event_type::SimulationEnd
+    event_type::SimulationEnd,
+    event_type::Convergence
 >;
 
 /**
@@ -147,6 +149,21 @@ struct ActionExecutionData : EventData {
     json serialize() const override;
 };
 
+/**
+ * Event for several NPCs performing the same action in the same place and time window
+ */
+struct ConvergenceData : EventData {
+    uint64_t tick_number;
+    std::string action_type;
+    int32_t cell_x;
+    int32_t cell_y;
+    uint32_t participants;
+    
+    ConvergenceData(uint64_t time, uint64_t tick, const std::string& action,
+                    int32_t x, int32_t y, uint32_t participant_count);
+    json serialize() const override;
+};
+
 /**
  * Variant type for all event data types
  */
@@ -156,7 +173,8 @@ using SimulationEvent = std::variant<
     SimulationStartData,
     SimulationEndData,
     EntityUpdateData,
-    ActionExecutionData
+    ActionExecutionData,
+    ConvergenceData
 >;
 
 /**
@@ -181,6 +199,8 @@ SimulationEvent createEntityUpdateEvent(uint64_t time, const std::string& id,
 SimulationEvent createActionExecutionEvent(uint64_t time, const std::string& id,
                                          const std::string& action,
                                          const std::optional<std::string>& target = std::nullopt);
+SimulationEvent createConvergenceEvent(uint64_t time, uint64_t tick, const std::string& action,
+                                     int32_t cell_x, int32_t cell_y, uint32_t participants);
 
 /**
  * Logger for simulation events
@@ -3,8 +3,11 @@
 #include <history_game/datamodel/npc/npc.h>
 #include <history_game/systems/drives/drive_dynamics.h>
 #include <history_game/systems/drives/drive_impact.h>
+#include <history_game/systems/drives/impact_cache.h>
 #include <history_game/datamodel/memory/memory_entry.h>
 #include <history_game/datamodel/action/action_type.h>
+#include <history_game/datamodel/world/world.h>
+#include <history_game/datamodel/world/simulation_clock.h>
 
 // Use namespaces to avoid repetition, but only up to two levels
 using namespace history_game::datamodel;
@@ -36,8 +39,9 @@ TEST(DriveDynamicsTest, UpdateDrive) {
 
 // Test drive impact context creation
 TEST(DriveImpactTest, ActionContext) {
+    entity::EntityRegistry registry;
     // Create entity
-    entity::Entity entity("test_entity", world::Position(10.0f, 20.0f));
+    entity::Entity entity("test_entity", world::Position(10.0f, 20.0f), registry);
     auto entity_ref = entity::Entity::storage::make_entity(std::move(entity));
     
     // Create NPCIdentity
@@ -45,7 +49,7 @@ TEST(DriveImpactTest, ActionContext) {
     auto identity_ref = npc::NPCIdentity::storage::make_entity(std::move(identity));
     
     // Create NPC
-    std::vector<npc::Drive> drives = {
+    npc::DriveSet drives = {
         npc::Drive(npc::drive::Sustenance{}, 50.0f),
         npc::Drive(npc::drive::Curiosity{}, 60.0f)
     };
@@ -65,25 +69,31 @@ TEST(DriveImpactTest, ActionContext) {
     );
     auto memory_ref = memory::MemoryEntry::storage::make_entity(std::move(entry));
     
+    // The world the NPC is in
+    auto clock_ref = world::SimulationClock::storage::make_entity(100, 0, 100);
+    world::World current_world(clock_ref, {npc_ref}, {});
+    
     // Create action context
-    history_game::datamodel::drives::ActionContext context(npc_ref, memory_ref, 100);
+    history_game::datamodel::drives::ActionContext context(npc_ref, memory_ref, current_world, 100, relationship::RelationshipDecay());
     
     // Check context
     EXPECT_EQ(context.observer, npc_ref);
     EXPECT_EQ(context.memory, memory_ref);
+    EXPECT_EQ(&context.world, &current_world);
     EXPECT_EQ(context.current_time, 100);
 }
 
 // Test drive impact evaluation for Observe action
 TEST(DriveImpactTest, ObserveImpact) {
+    entity::EntityRegistry registry;
     // Set up an observation context
-    entity::Entity entity("test_entity", world::Position(10.0f, 20.0f));
+    entity::Entity entity("test_entity", world::Position(10.0f, 20.0f), registry);
     auto entity_ref = entity::Entity::storage::make_entity(std::move(entity));
     
     npc::NPCIdentity identity(entity_ref);
     auto identity_ref = npc::NPCIdentity::storage::make_entity(std::move(identity));
     
-    std::vector<npc::Drive> drives = {
+    npc::DriveSet drives = {
         npc::Drive(npc::drive::Curiosity{}, 60.0f)  // High curiosity
     };
     
@@ -102,11 +112,14 @@ TEST(DriveImpactTest, ObserveImpact) {
     );
     auto memory_ref = memory::MemoryEntry::storage::make_entity(std::move(entry));
     
+    auto clock_ref = world::SimulationClock::storage::make_entity(100, 0, 100);
+    world::World current_world(clock_ref, {npc_ref}, {});
+    
     // Create action context
-    history_game::datamodel::drives::ActionContext context(npc_ref, memory_ref, 100);
+    history_game::datamodel::drives::ActionContext context(npc_ref, memory_ref, current_world, 100, relationship::RelationshipDecay());
     
     // Get impacts
-    std::vector<npc::Drive> impacts = history_game::systems::drives::drive_impact_system::evaluateImpact(context);
+    npc::DriveSet impacts = history_game::systems::drives::drive_impact_system::evaluateImpact(context);
     
     // Check impacts - Observe should reduce curiosity
     EXPECT_FALSE(impacts.empty());
@@ -121,4 +134,114 @@ TEST(DriveImpactTest, ObserveImpact) {
     }
     
     EXPECT_TRUE(found_curiosity_impact);
-}
\ No newline at end of file
+}
+
+// Test folding the impacts of several observations
+TEST(DriveImpactTest, AccumulateImpacts) {
+    history_game::systems::drives::drive_impact_system::ImpactAccumulator accumulator;
+    
+    accumulator.add(npc::DriveSet{ npc::Drive(npc::drive::Curiosity{}, -1.0f) });
+    accumulator.add(npc::DriveSet{
+        npc::Drive(npc::drive::Curiosity{}, -0.5f),
+        npc::Drive(npc::drive::Shelter{}, -0.2f)
+    });
+    
+    const npc::DriveSet& combined = accumulator.result();
+    EXPECT_EQ(combined.size(), 2);
+    
+    // A repeated drive is weighted, a new one is taken as is
+    EXPECT_FLOAT_EQ(combined.get(npc::drive::Curiosity{}), -1.5f * 0.6f);
+    EXPECT_FLOAT_EQ(combined.get(npc::drive::Shelter{}), -0.2f);
+    
+    // Average magnitude is (0.9 + 0.2) / 2
+    EXPECT_TRUE(history_game::systems::drives::drive_impact_system::hasEmotionalSignificance(combined, 0.5f));
+    EXPECT_FALSE(history_game::systems::drives::drive_impact_system::hasEmotionalSignificance(combined, 0.6f));
+}
+
+// Test caching observation impacts per NPC
+TEST(DriveImpactTest, ImpactCache) {
+    entity::EntityRegistry registry;
+    entity::Entity observer_entity("observer", world::Position(0.0f, 0.0f), registry);
+    npc::NPCIdentity observer_identity(entity::Entity::storage::make_entity(std::move(observer_entity)));
+    auto observer_identity_ref = npc::NPCIdentity::storage::make_entity(std::move(observer_identity));
+    
+    entity::Entity other_entity("other", world::Position(5.0f, 0.0f), registry);
+    auto other_entity_ref = entity::Entity::storage::make_entity(std::move(other_entity));
+    npc::NPCIdentity other_identity(other_entity_ref);
+    auto other_identity_ref = npc::NPCIdentity::storage::make_entity(std::move(other_identity));
+    
+    memory::PerceptionBuffer buffer({});
+    auto perception = memory::PerceptionBuffer::storage::make_entity(std::move(buffer));
+    npc::DriveSet drives = { npc::Drive(npc::drive::Curiosity{}, 60.0f) };
+    
+    npc::NPC stranger(observer_identity_ref, drives, perception, {}, {}, {});
+    auto stranger_ref = npc::NPC::storage::make_entity(std::move(stranger));
+    
+    // The same thing observed at two different times
+    memory::MemoryEntry first(100, other_identity_ref, action::action_type::Observe{});
+    auto first_ref = memory::MemoryEntry::storage::make_entity(std::move(first));
+    memory::MemoryEntry second(110, other_identity_ref, action::action_type::Observe{});
+    auto second_ref = memory::MemoryEntry::storage::make_entity(std::move(second));
+    
+    // Both NPCs are in the world the observations are looked up in
+    auto other_ref = npc::NPC::storage::make_entity(npc::NPC(other_identity_ref, drives, perception, {}, {}, {}));
+    auto clock_ref = world::SimulationClock::storage::make_entity(110, 0, 100);
+    world::World current_world(clock_ref, {stranger_ref, other_ref}, {});
+    
+    history_game::systems::drives::ImpactCache cache;
+    history_game::datamodel::drives::ActionContext first_context(stranger_ref, first_ref, current_world, 110, relationship::RelationshipDecay());
+    history_game::datamodel::drives::ActionContext second_context(stranger_ref, second_ref, current_world, 110, relationship::RelationshipDecay());
+    
+    auto first_impacts = cache.evaluateImpact(first_context);
+    auto second_impacts = cache.evaluateImpact(second_context);
+    EXPECT_EQ(cache.misses(), 1);
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_FLOAT_EQ(first_impacts.get(npc::drive::Curiosity{}), second_impacts.get(npc::drive::Curiosity{}));
+    EXPECT_FLOAT_EQ(
+        second_impacts.get(npc::drive::Curiosity{}),
+        history_game::systems::drives::drive_impact_system::evaluateImpact(second_context).get(npc::drive::Curiosity{}));
+    
+    // Once the observer knows the actor, the cached impacts are dropped
+    relationship::Relationship known(other_entity_ref, 1.0f, {}, 100, 10);
+    std::vector<relationship::Relationship::ref_type> relationships;
+    relationships.push_back(relationship::Relationship::storage::make_entity(std::move(known)));
+    npc::NPC acquaintance(observer_identity_ref, drives, perception, {}, {}, relationships);
+    auto acquaintance_ref = npc::NPC::storage::make_entity(std::move(acquaintance));
+    
+    history_game::datamodel::drives::ActionContext known_context(acquaintance_ref, second_ref, current_world, 110, relationship::RelationshipDecay());
+    auto known_impacts = cache.evaluateImpact(known_context);
+    EXPECT_EQ(cache.misses(), 2);
+    EXPECT_FLOAT_EQ(
+        known_impacts.get(npc::drive::Curiosity{}),
+        history_game::systems::drives::drive_impact_system::evaluateImpact(known_context).get(npc::drive::Curiosity{}));
+    EXPECT_NE(known_impacts.get(npc::drive::Curiosity{}), second_impacts.get(npc::drive::Curiosity{}));
+    
+    // The actor moved, but no known place covers either position: same observation
+    entity::Entity other_version("other", world::Position(6.5f, 1.0f), other_entity_ref->handle);
+    npc::NPCIdentity other_version_identity(entity::Entity::storage::make_entity(std::move(other_version)));
+    auto other_version_identity_ref = npc::NPCIdentity::storage::make_entity(std::move(other_version_identity));
+    auto moved_ref = npc::NPC::storage::make_entity(npc::NPC(other_version_identity_ref, drives, perception, {}, {}, {}));
+    world::World moved_world(current_world, clock_ref, {acquaintance_ref, moved_ref}, {});
+    memory::MemoryEntry third(120, other_version_identity_ref, action::action_type::Observe{});
+    history_game::datamodel::drives::ActionContext third_context(
+        acquaintance_ref, memory::MemoryEntry::storage::make_entity(std::move(third)), moved_world, 110, relationship::RelationshipDecay());
+    cache.evaluateImpact(third_context);
+    EXPECT_EQ(cache.misses(), 2);
+    EXPECT_EQ(cache.hits(), 2);
+    
+    // Entries of a removed NPC are dropped
+    EXPECT_EQ(cache.npcCount(), 1);
+    cache.evict(observer_identity_ref->entity->handle);
+    EXPECT_EQ(cache.npcCount(), 0);
+    
+    // So are those of an NPC that looked nothing up for a whole decay period
+    cache.evaluateImpact(known_context);
+    history_game::datamodel::drives::ActionContext later_context(
+        npc::NPC::storage::make_entity(npc::NPC(other_identity_ref, drives, perception, {}, {}, {})),
+        first_ref,
+        current_world,
+        110 + 2 * relationship::RelationshipDecay().period,
+        relationship::RelationshipDecay());
+    cache.evaluateImpact(later_context);
+    EXPECT_EQ(cache.npcCount(), 1);
+}
@@ -1,22 +1,30 @@
+#include <map>
 #include <gtest/gtest.h>
 #include <history_game/datamodel/memory/memory_entry.h>
 #include <history_game/datamodel/memory/memory_episode.h>
 #include <history_game/datamodel/memory/perception_buffer.h>
 #include <history_game/systems/memory/memory_system.h>
 #include <history_game/systems/memory/episode_formation.h>
+#include <history_game/systems/memory/memory_budget.h>
+#include <history_game/systems/memory/sequence_trie.h>
+#include <history_game/systems/action/action_execution.h>
+#include <history_game/systems/relationship/relationship_update.h>
 #include <history_game/datamodel/entity/entity.h>
 #include <history_game/datamodel/npc/npc.h>
 #include <history_game/datamodel/npc/npc_identity.h>
 #include <history_game/datamodel/action/action_type.h>
 #include <history_game/datamodel/action/action_sequence.h>
 #include <history_game/datamodel/world/position.h>
+#include <history_game/datamodel/world/world.h>
+#include <history_game/datamodel/world/simulation_clock.h>
 
 // Don't use "using namespace" for the ambiguous namespaces
 
 // Test memory entry creation
 TEST(MemoryTest, CreateMemoryEntry) {
+    history_game::datamodel::entity::EntityRegistry registry;
     // Create entity and identity
-    history_game::datamodel::entity::Entity entity("test_entity", history_game::datamodel::world::Position(10.0f, 20.0f));
+    history_game::datamodel::entity::Entity entity("test_entity", history_game::datamodel::world::Position(10.0f, 20.0f), registry);
     auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
     
     history_game::datamodel::npc::NPCIdentity identity(entity_ref);
@@ -32,17 +40,42 @@ TEST(MemoryTest, CreateMemoryEntry) {
     
     // Check fields
     EXPECT_EQ(entry.timestamp, 100);
-    EXPECT_EQ(entry.actor, identity_ref);
-    EXPECT_TRUE(std::holds_alternative<history_game::datamodel::action::action_type::Move>(entry.action));
-    EXPECT_TRUE(entry.target_entity.has_value());
-    EXPECT_EQ(entry.target_entity.value(), entity_ref);
-    EXPECT_FALSE(entry.target_object.has_value());
+    EXPECT_EQ(entry.actorHandle(), identity_ref->entity->handle);
+    EXPECT_TRUE(std::holds_alternative<history_game::datamodel::action::action_type::Move>(entry.action()));
+    ASSERT_NE(entry.targetEntity(), nullptr);
+    EXPECT_EQ(*entry.targetEntity(), entity_ref->handle);
+    EXPECT_EQ(entry.targetObject(), nullptr);
+    EXPECT_EQ(entry.lastTimestamp(), 100);
+    
+    // A run of the same observation keeps the target
+    history_game::datamodel::memory::MemoryEntry run(entry, 100, 130);
+    EXPECT_EQ(run.timestamp, 100);
+    EXPECT_EQ(run.lastTimestamp(), 130);
+    EXPECT_EQ(run.target_kind, history_game::datamodel::memory::TargetKind::Entity);
+    EXPECT_EQ(*run.targetEntity(), entity_ref->handle);
+    
+    // Moving keeps the target
+    history_game::datamodel::memory::MemoryEntry moved(std::move(run));
+    EXPECT_EQ(moved.lastTimestamp(), 130);
+    EXPECT_EQ(*moved.targetEntity(), entity_ref->handle);
+    
+    // Ticks and runs that do not fit saturate
+    history_game::datamodel::memory::MemoryEntry late(
+        uint64_t(1) << 32, identity_ref, history_game::datamodel::action::action_type::Rest{});
+    EXPECT_EQ(late.lastTimestamp(), history_game::datamodel::memory::MemoryEntry::MAX_TICK);
+    history_game::datamodel::memory::MemoryEntry long_run(
+        entry, 0, history_game::datamodel::memory::MemoryEntry::MAX_SPAN + 1);
+    EXPECT_EQ(long_run.lastTimestamp(), history_game::datamodel::memory::MemoryEntry::MAX_SPAN);
+    
+    // Two handles, the tick, the span, the action and the target kind
+    EXPECT_EQ(sizeof(history_game::datamodel::memory::MemoryEntry), 16);
 }
 
 // Test perception buffer
 TEST(MemoryTest, PerceptionBuffer) {
+    history_game::datamodel::entity::EntityRegistry registry;
     // Create some memory entries
-    history_game::datamodel::entity::Entity entity("test_entity", history_game::datamodel::world::Position(10.0f, 20.0f));
+    history_game::datamodel::entity::Entity entity("test_entity", history_game::datamodel::world::Position(10.0f, 20.0f), registry);
     auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
     
     history_game::datamodel::npc::NPCIdentity identity(entity_ref);
@@ -66,8 +99,9 @@ TEST(MemoryTest, PerceptionBuffer) {
 
 // Test action sequence creation
 TEST(MemoryTest, ActionSequence) {
+    history_game::datamodel::entity::EntityRegistry registry;
     // Create memory entries
-    history_game::datamodel::entity::Entity entity("test_entity", history_game::datamodel::world::Position(10.0f, 20.0f));
+    history_game::datamodel::entity::Entity entity("test_entity", history_game::datamodel::world::Position(10.0f, 20.0f), registry);
     auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
     
     history_game::datamodel::npc::NPCIdentity identity(entity_ref);
@@ -99,8 +133,9 @@ TEST(MemoryTest, ActionSequence) {
 
 // Test memory episode creation
 TEST(MemoryTest, MemoryEpisode) {
+    history_game::datamodel::entity::EntityRegistry registry;
     // Create action sequence
-    history_game::datamodel::entity::Entity entity("test_entity", history_game::datamodel::world::Position(10.0f, 20.0f));
+    history_game::datamodel::entity::Entity entity("test_entity", history_game::datamodel::world::Position(10.0f, 20.0f), registry);
     auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
     
     history_game::datamodel::npc::NPCIdentity identity(entity_ref);
@@ -114,7 +149,7 @@ TEST(MemoryTest, MemoryEpisode) {
     auto sequence_ref = history_game::datamodel::action::ActionSequence::storage::make_entity(std::move(sequence));
     
     // Create impacts
-    std::vector<history_game::datamodel::npc::Drive> impacts = {
+    history_game::datamodel::npc::DriveSet impacts = {
         history_game::datamodel::npc::Drive(history_game::datamodel::npc::drive::Curiosity{}, -0.5f)  // Satisfied curiosity
     };
     
@@ -132,15 +167,16 @@ TEST(MemoryTest, MemoryEpisode) {
     EXPECT_EQ(episode.end_time, 110);
     EXPECT_EQ(episode.action_sequence, sequence_ref);
     EXPECT_EQ(episode.drive_impacts.size(), 1);
-    EXPECT_TRUE(std::holds_alternative<history_game::datamodel::npc::drive::Curiosity>(episode.drive_impacts[0].type));
-    EXPECT_FLOAT_EQ(episode.drive_impacts[0].intensity, -0.5f);
+    EXPECT_TRUE(episode.drive_impacts.has(history_game::datamodel::npc::drive::Curiosity{}));
+    EXPECT_FLOAT_EQ(episode.drive_impacts.get(history_game::datamodel::npc::drive::Curiosity{}), -0.5f);
     EXPECT_EQ(episode.repetition_count, 1);
 }
 
 // Test perception buffer update
 TEST(MemorySystemTest, UpdatePerceptionBuffer) {
+    history_game::datamodel::entity::EntityRegistry registry;
     // Create initial buffer
-    history_game::datamodel::entity::Entity entity("test_entity", history_game::datamodel::world::Position(10.0f, 20.0f));
+    history_game::datamodel::entity::Entity entity("test_entity", history_game::datamodel::world::Position(10.0f, 20.0f), registry);
     auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
     
     history_game::datamodel::npc::NPCIdentity identity(entity_ref);
@@ -166,4 +202,648 @@ TEST(MemorySystemTest, UpdatePerceptionBuffer) {
     EXPECT_EQ(updated_buffer->recent_perceptions.size(), 2);
     EXPECT_EQ(updated_buffer->recent_perceptions[0], entry1_ref);
     EXPECT_EQ(updated_buffer->recent_perceptions[1], entry2_ref);
-}
\ No newline at end of file
+}
+
+// Test that appending to a full buffer keeps the newest entries and leaves older versions intact
+TEST(MemorySystemTest, PerceptionBufferStructuralSharing) {
+    history_game::datamodel::entity::EntityRegistry registry;
+    history_game::datamodel::entity::Entity entity("test_entity", history_game::datamodel::world::Position(10.0f, 20.0f), registry);
+    auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
+    
+    history_game::datamodel::npc::NPCIdentity identity(entity_ref);
+    auto identity_ref = history_game::datamodel::npc::NPCIdentity::storage::make_entity(std::move(identity));
+    
+    // Create ten entries with increasing timestamps (spaced out so they are not coalesced)
+    std::vector<history_game::datamodel::memory::MemoryEntry::ref_type> entries;
+    for (uint64_t t = 0; t < 10; ++t) {
+        history_game::datamodel::memory::MemoryEntry entry(t * 2, identity_ref, history_game::datamodel::action::action_type::Observe{}, entity_ref);
+        entries.push_back(history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(entry)));
+    }
+    
+    history_game::datamodel::memory::PerceptionBuffer empty_buffer({});
+    auto buffer_v0 = history_game::datamodel::memory::PerceptionBuffer::storage::make_entity(std::move(empty_buffer));
+    
+    // Fill a buffer of capacity 4 with the first three entries
+    std::vector<history_game::datamodel::memory::MemoryEntry::ref_type> first_batch = { entries[0], entries[1], entries[2] };
+    auto buffer_v1 = history_game::systems::memory::updatePerceptionBuffer(buffer_v0, first_batch, 4);
+    
+    // Overflow the buffer with three more entries
+    std::vector<history_game::datamodel::memory::MemoryEntry::ref_type> second_batch = { entries[3], entries[4], entries[5] };
+    auto buffer_v2 = history_game::systems::memory::updatePerceptionBuffer(buffer_v1, second_batch, 4);
+    
+    // Branch from v1 again, which must not disturb v2
+    std::vector<history_game::datamodel::memory::MemoryEntry::ref_type> branch_batch = { entries[9] };
+    auto buffer_branch = history_game::systems::memory::updatePerceptionBuffer(buffer_v1, branch_batch, 4);
+    
+    // The newest version holds only the last four entries, oldest first
+    ASSERT_EQ(buffer_v2->recent_perceptions.size(), 4);
+    EXPECT_EQ(buffer_v2->recent_perceptions[0], entries[2]);
+    EXPECT_EQ(buffer_v2->recent_perceptions[1], entries[3]);
+    EXPECT_EQ(buffer_v2->recent_perceptions[2], entries[4]);
+    EXPECT_EQ(buffer_v2->recent_perceptions[3], entries[5]);
+    
+    // The older versions are unchanged
+    EXPECT_TRUE(buffer_v0->recent_perceptions.empty());
+    ASSERT_EQ(buffer_v1->recent_perceptions.size(), 3);
+    EXPECT_EQ(buffer_v1->recent_perceptions[0], entries[0]);
+    EXPECT_EQ(buffer_v1->recent_perceptions[2], entries[2]);
+    
+    // The branch sees v1 followed by its own entry
+    ASSERT_EQ(buffer_branch->recent_perceptions.size(), 4);
+    EXPECT_EQ(buffer_branch->recent_perceptions[0], entries[0]);
+    EXPECT_EQ(buffer_branch->recent_perceptions[3], entries[9]);
+}
+
+// Test that consecutive identical observations are coalesced into a single span
+TEST(MemorySystemTest, CoalesceRepeatedObservations) {
+    history_game::datamodel::entity::EntityRegistry registry;
+    history_game::datamodel::entity::Entity entity("observer", history_game::datamodel::world::Position(0.0f, 0.0f), registry);
+    auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
+    
+    history_game::datamodel::npc::NPCIdentity identity(entity_ref);
+    auto identity_ref = history_game::datamodel::npc::NPCIdentity::storage::make_entity(std::move(identity));
+    
+    history_game::datamodel::entity::Entity food_entity("food", history_game::datamodel::world::Position(1.0f, 0.0f), registry);
+    auto food_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(food_entity));
+    
+    history_game::datamodel::memory::PerceptionBuffer empty_buffer({});
+    std::optional<history_game::datamodel::memory::PerceptionBuffer::ref_type> buffer;
+    buffer.emplace(history_game::datamodel::memory::PerceptionBuffer::storage::make_entity(std::move(empty_buffer)));
+    
+    // Observe the same food for five ticks
+    for (uint64_t t = 10; t < 15; ++t) {
+        history_game::datamodel::memory::MemoryEntry entry(t, identity_ref, history_game::datamodel::action::action_type::Observe{}, food_ref);
+        std::vector<history_game::datamodel::memory::MemoryEntry::ref_type> batch = {
+            history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(entry))
+        };
+        buffer.emplace(history_game::systems::memory::updatePerceptionBuffer(buffer.value(), batch));
+    }
+    
+    // One entry covers the whole run
+    ASSERT_EQ(buffer.value()->recent_perceptions.size(), 1);
+    EXPECT_EQ(buffer.value()->recent_perceptions[0]->timestamp, 10);
+    EXPECT_EQ(buffer.value()->recent_perceptions[0]->lastTimestamp(), 14);
+    
+    // A different action, then the same observation after a gap, are kept apart
+    history_game::datamodel::memory::MemoryEntry move(15, identity_ref, history_game::datamodel::action::action_type::Move{}, food_ref);
+    history_game::datamodel::memory::MemoryEntry later(20, identity_ref, history_game::datamodel::action::action_type::Observe{}, food_ref);
+    std::vector<history_game::datamodel::memory::MemoryEntry::ref_type> batch = {
+        history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(move)),
+        history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(later))
+    };
+    auto final_buffer = history_game::systems::memory::updatePerceptionBuffer(buffer.value(), batch);
+    ASSERT_EQ(final_buffer->recent_perceptions.size(), 3);
+    
+    // Episode formation measures gaps from the end of the span
+    auto sequences = history_game::systems::memory::identifyActionSequences(final_buffer, 1, 2);
+    ASSERT_EQ(sequences.size(), 1);
+    EXPECT_EQ(sequences[0].size(), 2);
+    
+    auto sequence = history_game::systems::memory::createActionSequence(sequences[0], "span");
+    EXPECT_EQ(sequence->steps[1].delay_after_previous, 1);
+    
+    // Continuing the observation leaves the older slot out without touching the previous version
+    history_game::datamodel::memory::MemoryEntry continued(21, identity_ref, history_game::datamodel::action::action_type::Observe{}, food_ref);
+    history_game::datamodel::memory::MemoryEntry rest(21, identity_ref, history_game::datamodel::action::action_type::Rest{});
+    std::vector<history_game::datamodel::memory::MemoryEntry::ref_type> next_batch = {
+        history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(continued)),
+        history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(rest))
+    };
+    auto next_buffer = history_game::systems::memory::updatePerceptionBuffer(final_buffer, next_batch);
+    ASSERT_EQ(next_buffer->recent_perceptions.size(), 4);
+    EXPECT_EQ(next_buffer->recent_perceptions[1]->actionIndex(), final_buffer->recent_perceptions[1]->actionIndex());
+    EXPECT_EQ(next_buffer->recent_perceptions[2]->timestamp, 20);
+    EXPECT_EQ(next_buffer->recent_perceptions[2]->lastTimestamp(), 21);
+    EXPECT_EQ(next_buffer->recent_perceptions[3], next_batch[1]);
+    ASSERT_EQ(final_buffer->recent_perceptions.size(), 3);
+    EXPECT_EQ(final_buffer->recent_perceptions[2]->lastTimestamp(), 20);
+}
+
+// Test that admission keeps the most salient perceptions of a perceiver
+TEST(MemorySystemTest, PerceptionAdmission) {
+    history_game::datamodel::entity::EntityRegistry registry;
+    history_game::datamodel::entity::Entity entity("perceiver", history_game::datamodel::world::Position(0.0f, 0.0f), registry);
+    auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
+    
+    history_game::datamodel::npc::NPCIdentity identity(entity_ref);
+    auto identity_ref = history_game::datamodel::npc::NPCIdentity::storage::make_entity(std::move(identity));
+    
+    // Three food objects at increasing distances
+    std::vector<history_game::datamodel::object::WorldObject::ref_type> objects;
+    for (int i = 0; i < 3; ++i) {
+        history_game::datamodel::entity::Entity object_entity("food_" + std::to_string(i), history_game::datamodel::world::Position(1.0f + 4.0f * i, 0.0f), registry);
+        auto object_entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(object_entity));
+        history_game::datamodel::object::WorldObject object(object_entity_ref, history_game::datamodel::object::object_category::Food{}, identity_ref);
+        objects.push_back(history_game::datamodel::object::WorldObject::storage::make_entity(std::move(object)));
+    }
+    
+    // A perceiver that already remembers the closest object
+    history_game::datamodel::memory::MemoryEntry seen(1, identity_ref, history_game::datamodel::action::action_type::Observe{}, objects[0]);
+    auto seen_ref = history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(seen));
+    
+    history_game::datamodel::memory::PerceptionBuffer empty_buffer({});
+    auto empty_perception = history_game::datamodel::memory::PerceptionBuffer::storage::make_entity(std::move(empty_buffer));
+    history_game::datamodel::npc::NPC fresh_npc(identity_ref, {}, empty_perception, {}, {}, {});
+    auto fresh_ref = history_game::datamodel::npc::NPC::storage::make_entity(std::move(fresh_npc));
+    
+    history_game::datamodel::memory::PerceptionBuffer seen_buffer({ seen_ref });
+    auto seen_perception = history_game::datamodel::memory::PerceptionBuffer::storage::make_entity(std::move(seen_buffer));
+    history_game::datamodel::npc::NPC familiar_npc(identity_ref, {}, seen_perception, {}, {}, {});
+    auto familiar_ref = history_game::datamodel::npc::NPC::storage::make_entity(std::move(familiar_npc));
+    
+    std::vector<history_game::systems::perception::PerceptionPair> perceptions;
+    for (int i = 0; i < 3; ++i) {
+        perceptions.emplace_back(fresh_ref, history_game::systems::perception::PerceivableEntity{objects[i]}, 1.0f + 4.0f * i);
+    }
+    for (int i = 0; i < 3; ++i) {
+        perceptions.emplace_back(familiar_ref, history_game::systems::perception::PerceivableEntity{objects[i]}, 1.0f + 4.0f * i);
+    }
+    
+    // With nothing remembered, the two closest objects win
+    auto fresh_admitted = history_game::systems::memory::perception_admission_system::admitPerceptions(
+        perceptions, {0, 1, 2}, 2, 10.0f, 2, history_game::datamodel::relationship::RelationshipDecay());
+    EXPECT_EQ(fresh_admitted, (std::vector<size_t>{0, 1}));
+    
+    // The closest object is no longer novel, so it is the one left out
+    auto familiar_admitted = history_game::systems::memory::perception_admission_system::admitPerceptions(
+        perceptions, {3, 4, 5}, 2, 10.0f, 2, history_game::datamodel::relationship::RelationshipDecay());
+    EXPECT_EQ(familiar_admitted, (std::vector<size_t>{4, 5}));
+}
+
+// Test that observers of an action share the world's event record for it
+TEST(MemorySystemTest, SharedActionEvents) {
+    history_game::datamodel::entity::EntityRegistry registry;
+    history_game::datamodel::memory::PerceptionBuffer empty_buffer({});
+    auto empty_perception = history_game::datamodel::memory::PerceptionBuffer::storage::make_entity(std::move(empty_buffer));
+    
+    // An NPC resting between two idle observers
+    std::vector<history_game::datamodel::npc::NPC::ref_type> npcs;
+    for (int i = 0; i < 3; ++i) {
+        history_game::datamodel::entity::Entity entity("npc_" + std::to_string(i), history_game::datamodel::world::Position(2.0f * i, 0.0f), registry);
+        auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
+        
+        std::optional<history_game::datamodel::npc::NPCIdentity::ref_type> identity_ref;
+        if (i == 1) {
+            history_game::datamodel::npc::NPCIdentity identity(entity_ref, history_game::datamodel::action::action_type::Rest{});
+            identity_ref.emplace(history_game::datamodel::npc::NPCIdentity::storage::make_entity(std::move(identity)));
+        } else {
+            history_game::datamodel::npc::NPCIdentity identity(entity_ref);
+            identity_ref.emplace(history_game::datamodel::npc::NPCIdentity::storage::make_entity(std::move(identity)));
+        }
+        
+        history_game::datamodel::npc::NPC npc(identity_ref.value(), {}, empty_perception, {}, {}, {});
+        npcs.push_back(history_game::datamodel::npc::NPC::storage::make_entity(std::move(npc)));
+    }
+    
+    history_game::datamodel::world::SimulationClock clock(5, 0, 100);
+    auto clock_ref = history_game::datamodel::world::SimulationClock::storage::make_entity(std::move(clock));
+    history_game::datamodel::world::World world(clock_ref, npcs, {});
+    auto world_ref = history_game::datamodel::world::World::storage::make_entity(std::move(world));
+    
+    // Only the resting NPC produces an event
+    auto world_after_actions = history_game::systems::action::executeAllActions(world_ref);
+    ASSERT_EQ(world_after_actions->getEvents().size(), 1);
+    const auto& event = world_after_actions->getEvents()[0];
+    EXPECT_EQ(event->actorHandle(), npcs[1]->getIdentity()->entity->handle);
+    EXPECT_EQ(event->timestamp, 5);
+    
+    // Both observers hold the very same record
+    auto world_with_perceptions = history_game::systems::memory::processPerceptions(
+        world_after_actions, history_game::datamodel::relationship::RelationshipDecay(), 10.0f);
+    for (int i : {0, 2}) {
+        const auto& buffer = world_with_perceptions->getNPCs()[i]->getPerception()->recent_perceptions;
+        auto shared = std::find(buffer.begin(), buffer.end(), event);
+        EXPECT_NE(shared, buffer.end());
+    }
+    
+    // Continuing the action in the next tick extends the record
+    auto continued = history_game::systems::action::createActionEvent(world_after_actions->getNPCs()[1], 6, &event);
+    EXPECT_EQ(continued->timestamp, 5);
+    EXPECT_EQ(continued->lastTimestamp(), 6);
+}
+
+// Test that the memory budget evicts the least significant memories first
+TEST(MemorySystemTest, MemoryBudgetEviction) {
+    history_game::datamodel::entity::EntityRegistry registry;
+    history_game::datamodel::entity::Entity entity("npc", history_game::datamodel::world::Position(0.0f, 0.0f), registry);
+    auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
+    
+    history_game::datamodel::npc::NPCIdentity identity(entity_ref);
+    auto identity_ref = history_game::datamodel::npc::NPCIdentity::storage::make_entity(std::move(identity));
+    
+    history_game::datamodel::memory::PerceptionBuffer empty_buffer({});
+    auto empty_perception = history_game::datamodel::memory::PerceptionBuffer::storage::make_entity(std::move(empty_buffer));
+    
+    // Four equally old episodes of different sequences, repeated 1 to 4 times
+    std::vector<history_game::datamodel::memory::MemoryEpisode::ref_type> episodes;
+    for (uint32_t repetitions = 1; repetitions <= 4; ++repetitions) {
+        history_game::datamodel::entity::Entity target("target_" + std::to_string(repetitions), history_game::datamodel::world::Position(1.0f, 0.0f), registry);
+        auto target_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(target));
+        history_game::datamodel::memory::MemoryEntry entry(10, identity_ref, history_game::datamodel::action::action_type::Observe{}, target_ref);
+        auto entry_ref = history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(entry));
+        
+        std::vector<history_game::datamodel::action::ActionStep> steps;
+        steps.emplace_back(entry_ref, 0);
+        history_game::datamodel::action::ActionSequence sequence("seq_" + std::to_string(repetitions), std::move(steps));
+        auto sequence_ref = history_game::datamodel::action::ActionSequence::storage::make_entity(std::move(sequence));
+        
+        history_game::datamodel::npc::DriveSet impacts = {
+            history_game::datamodel::npc::Drive(history_game::datamodel::npc::drive::Curiosity{}, -0.5f)
+        };
+        history_game::datamodel::memory::MemoryEpisode episode(10, 20, sequence_ref, impacts, repetitions);
+        episodes.push_back(history_game::datamodel::memory::MemoryEpisode::storage::make_entity(std::move(episode)));
+    }
+    
+    history_game::datamodel::npc::NPC npc(identity_ref, {}, empty_perception, episodes, {}, {});
+    auto npc_ref = history_game::datamodel::npc::NPC::storage::make_entity(std::move(npc));
+    
+    history_game::systems::memory::memory_budget_system::resetEvictionStats();
+    
+    // Within budget, the NPC is left untouched
+    history_game::systems::memory::MemoryBudget generous;
+    auto unchanged = history_game::systems::memory::memory_budget_system::enforceBudget(
+        npc_ref, generous, 30, history_game::datamodel::relationship::RelationshipDecay());
+    EXPECT_EQ(unchanged, npc_ref);
+    
+    // Only the two most repeated episodes survive
+    history_game::systems::memory::MemoryBudget tight(2);
+    auto trimmed = history_game::systems::memory::memory_budget_system::enforceBudget(
+        npc_ref, tight, 30, history_game::datamodel::relationship::RelationshipDecay());
+    ASSERT_EQ(trimmed->getEpisodicMemory().size(), 2);
+    EXPECT_TRUE(history_game::datamodel::memory::episode_store_system::find(trimmed->getEpisodicMemory(), episodes[2]->action_sequence));
+    EXPECT_TRUE(history_game::datamodel::memory::episode_store_system::find(trimmed->getEpisodicMemory(), episodes[3]->action_sequence));
+    
+    const auto& stats = history_game::systems::memory::memory_budget_system::getEvictionStats();
+    EXPECT_EQ(stats.episodes.load(), 2);
+    EXPECT_GT(stats.bytes.load(), 0);
+    
+    // The byte limit alone also forces evictions
+    size_t one_episode = history_game::systems::memory::memory_budget_system::estimateBytes(episodes[0]);
+    history_game::systems::memory::MemoryBudget small(64, 64, 128, one_episode);
+    auto squeezed = history_game::systems::memory::memory_budget_system::enforceBudget(
+        npc_ref, small, 30, history_game::datamodel::relationship::RelationshipDecay());
+    ASSERT_EQ(squeezed->getEpisodicMemory().size(), 1);
+    EXPECT_EQ(*squeezed->getEpisodicMemory().begin(), episodes[3]);
+}
+
+// Test that the episode store keeps one live record per distinct sequence
+TEST(MemorySystemTest, EpisodeStoreReplacesInPlace) {
+    history_game::datamodel::entity::EntityRegistry registry;
+    history_game::datamodel::entity::Entity entity("npc", history_game::datamodel::world::Position(0.0f, 0.0f), registry);
+    auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
+    
+    history_game::datamodel::npc::NPCIdentity identity(entity_ref);
+    auto identity_ref = history_game::datamodel::npc::NPCIdentity::storage::make_entity(std::move(identity));
+    
+    // Build enough distinct sequences to make the table grow
+    std::vector<history_game::datamodel::entity::Entity::ref_type> targets;
+    for (int i = 0; i < 40; ++i) {
+        history_game::datamodel::entity::Entity target("target_" + std::to_string(i), history_game::datamodel::world::Position(1.0f, 0.0f), registry);
+        targets.push_back(history_game::datamodel::entity::Entity::storage::make_entity(std::move(target)));
+    }
+    
+    auto make_episode = [&](int target_index, uint32_t repetitions) {
+        history_game::datamodel::memory::MemoryEntry entry(target_index, identity_ref, history_game::datamodel::action::action_type::Observe{}, targets[target_index]);
+        auto entry_ref = history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(entry));
+        
+        std::vector<history_game::datamodel::action::ActionStep> steps;
+        steps.emplace_back(entry_ref, 0);
+        history_game::datamodel::action::ActionSequence sequence("seq_" + std::to_string(target_index), std::move(steps));
+        auto sequence_ref = history_game::datamodel::action::ActionSequence::storage::make_entity(std::move(sequence));
+        
+        history_game::datamodel::memory::MemoryEpisode episode(target_index, target_index, sequence_ref, {}, repetitions);
+        return history_game::datamodel::memory::MemoryEpisode::storage::make_entity(std::move(episode));
+    };
+    
+    std::optional<history_game::datamodel::memory::EpisodeStore> store;
+    store.emplace();
+    for (int i = 0; i < 40; ++i) {
+        store.emplace(history_game::datamodel::memory::episode_store_system::insert(store.value(), make_episode(i, 1)));
+    }
+    ASSERT_EQ(store.value().size(), 40);
+    
+    // The same sequence seen again replaces its record instead of adding one
+    history_game::datamodel::memory::EpisodeStore before = store.value();
+    auto repeated = make_episode(7, 2);
+    auto after = history_game::datamodel::memory::episode_store_system::insert(before, repeated);
+    EXPECT_EQ(after.size(), 40);
+    
+    auto found = history_game::datamodel::memory::episode_store_system::find(after, repeated->action_sequence);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(found.value()->repetition_count, 2);
+    EXPECT_EQ(std::count(after.begin(), after.end(), repeated), 1);
+    
+    // Only the chunk holding the changed bucket was copied
+    const auto& before_chunks = before.table.value()->chunks;
+    const auto& after_chunks = after.table.value()->chunks;
+    ASSERT_EQ(after_chunks.size(), 2);
+    EXPECT_EQ((before_chunks[0] == after_chunks[0]) + (before_chunks[1] == after_chunks[1]), 1);
+    
+    // The previous version still sees the original record
+    auto original = history_game::datamodel::memory::episode_store_system::find(before, repeated->action_sequence);
+    ASSERT_TRUE(original);
+    EXPECT_EQ(original.value()->repetition_count, 1);
+    EXPECT_EQ(std::distance(before.begin(), before.end()), 40);
+}
+
+// Test that segmentation only looks at new perceptions and closes sequences on gaps
+TEST(MemorySystemTest, IncrementalSegmentation) {
+    history_game::datamodel::entity::EntityRegistry registry;
+    history_game::datamodel::entity::Entity entity("npc", history_game::datamodel::world::Position(0.0f, 0.0f), registry);
+    auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
+    
+    history_game::datamodel::npc::NPCIdentity identity(entity_ref);
+    auto identity_ref = history_game::datamodel::npc::NPCIdentity::storage::make_entity(std::move(identity));
+    
+    std::map<std::string, history_game::datamodel::entity::Entity::ref_type> targets;
+    auto make_entry = [&](uint64_t time, const std::string& target_id) {
+        history_game::datamodel::entity::Entity target(target_id, history_game::datamodel::world::Position(1.0f, 0.0f), registry);
+        auto target_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(target));
+        targets.emplace(target_id, target_ref);
+        history_game::datamodel::memory::MemoryEntry entry(time, identity_ref, history_game::datamodel::action::action_type::Observe{}, target_ref);
+        return history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(entry));
+    };
+    
+    // Two related perceptions open a sequence
+    history_game::datamodel::memory::PerceptionBuffer first_buffer({ make_entry(1, "a"), make_entry(2, "b") });
+    auto first_ref = history_game::datamodel::memory::PerceptionBuffer::storage::make_entity(std::move(first_buffer));
+    auto first = history_game::systems::memory::segmentNewPerceptions(first_ref, std::nullopt, 3);
+    EXPECT_TRUE(first.closed_sequences.empty());
+    ASSERT_TRUE(first.state);
+    EXPECT_EQ(first.state.value()->watermark, 2);
+    EXPECT_EQ(first.state.value()->open_sequence.size(), 2);
+    
+    // Running again over the same buffer finds nothing new
+    auto again = history_game::systems::memory::segmentNewPerceptions(first_ref, first.state, 3);
+    EXPECT_TRUE(again.closed_sequences.empty());
+    EXPECT_FALSE(again.state);
+    
+    // A perception after a long gap closes the open sequence and starts a new one
+    std::vector<history_game::datamodel::memory::MemoryEntry::ref_type> later = { make_entry(10, "c") };
+    auto second_ref = history_game::systems::memory::updatePerceptionBuffer(first_ref, later);
+    auto second = history_game::systems::memory::segmentNewPerceptions(second_ref, first.state, 11);
+    ASSERT_EQ(second.closed_sequences.size(), 1);
+    EXPECT_EQ(second.closed_sequences[0].size(), 2);
+    ASSERT_TRUE(second.state);
+    EXPECT_EQ(second.state.value()->watermark, 10);
+    EXPECT_EQ(second.state.value()->open_sequence.size(), 1);
+    
+    // Once nothing else can join, the single-entry sequence is dropped
+    auto expired = history_game::systems::memory::segmentNewPerceptions(second_ref, second.state, 20);
+    EXPECT_TRUE(expired.closed_sequences.empty());
+    ASSERT_TRUE(expired.state);
+    EXPECT_TRUE(expired.state.value()->open_sequence.empty());
+    
+    // Two observations continued in the same tick each replace their earlier version
+    auto d = make_entry(30, "d");
+    auto e = make_entry(30, "e");
+    history_game::datamodel::memory::PerceptionBuffer pair_buffer({ d, e });
+    auto pair_ref = history_game::datamodel::memory::PerceptionBuffer::storage::make_entity(std::move(pair_buffer));
+    auto opened = history_game::systems::memory::segmentNewPerceptions(pair_ref, expired.state, 30);
+    ASSERT_TRUE(opened.state);
+    ASSERT_EQ(opened.state.value()->open_sequence.size(), 2);
+    
+    history_game::datamodel::memory::MemoryEntry d_again(31, identity_ref, history_game::datamodel::action::action_type::Observe{}, targets.at("d"));
+    history_game::datamodel::memory::MemoryEntry e_again(31, identity_ref, history_game::datamodel::action::action_type::Observe{}, targets.at("e"));
+    std::vector<history_game::datamodel::memory::MemoryEntry::ref_type> continued = {
+        history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(d_again)),
+        history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(e_again))
+    };
+    auto continued_ref = history_game::systems::memory::updatePerceptionBuffer(pair_ref, continued);
+    ASSERT_EQ(continued_ref->recent_perceptions.size(), 2);
+    
+    auto extended = history_game::systems::memory::segmentNewPerceptions(continued_ref, opened.state, 31);
+    ASSERT_TRUE(extended.state);
+    const auto& open_sequence = extended.state.value()->open_sequence;
+    ASSERT_EQ(open_sequence.size(), 2);
+    EXPECT_EQ(open_sequence[0]->lastTimestamp(), 31);
+    EXPECT_EQ(open_sequence[1]->lastTimestamp(), 31);
+    EXPECT_NE(
+        history_game::systems::memory::perception_admission_system::getTargetHandle(open_sequence[0]),
+        history_game::systems::memory::perception_admission_system::getTargetHandle(open_sequence[1]));
+}
+
+// Test that fingerprints match sequences by shape and the store finds similar episodes
+TEST(MemorySystemTest, SequenceFingerprintSimilarity) {
+    history_game::datamodel::entity::EntityRegistry registry;
+    history_game::datamodel::entity::Entity entity("npc", history_game::datamodel::world::Position(0.0f, 0.0f), registry);
+    auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
+    
+    history_game::datamodel::npc::NPCIdentity identity(entity_ref);
+    auto identity_ref = history_game::datamodel::npc::NPCIdentity::storage::make_entity(std::move(identity));
+    
+    auto make_step = [&](auto action, const std::string& target_id, uint32_t delay) {
+        history_game::datamodel::entity::Entity target(target_id, history_game::datamodel::world::Position(1.0f, 0.0f), registry);
+        auto target_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(target));
+        history_game::datamodel::memory::MemoryEntry entry(0, identity_ref, action, target_ref);
+        return history_game::datamodel::action::ActionStep(
+            history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(entry)), delay);
+    };
+    
+    // The same routine around two different places, with slightly different pacing
+    auto make_routine = [&](const std::string& place, uint32_t pause) {
+        std::vector<history_game::datamodel::action::ActionStep> steps;
+        steps.push_back(make_step(history_game::datamodel::action::action_type::Observe{}, place, 0));
+        steps.push_back(make_step(history_game::datamodel::action::action_type::Move{}, place, 1));
+        steps.push_back(make_step(history_game::datamodel::action::action_type::Rest{}, place, pause));
+        steps.push_back(make_step(history_game::datamodel::action::action_type::Gesture{}, place, 1));
+        history_game::datamodel::action::ActionSequence sequence("routine_" + place, std::move(steps));
+        return history_game::datamodel::action::ActionSequence::storage::make_entity(std::move(sequence));
+    };
+    
+    auto home = make_routine("home", 2);
+    auto field = make_routine("field", 3);
+    
+    std::vector<history_game::datamodel::action::ActionStep> other_steps;
+    other_steps.push_back(make_step(history_game::datamodel::action::action_type::Build{}, "site", 0));
+    other_steps.push_back(make_step(history_game::datamodel::action::action_type::Plant{}, "site", 8));
+    other_steps.push_back(make_step(history_game::datamodel::action::action_type::Bury{}, "site", 1));
+    history_game::datamodel::action::ActionSequence other_sequence("other", std::move(other_steps));
+    auto other = history_game::datamodel::action::ActionSequence::storage::make_entity(std::move(other_sequence));
+    
+    // Delays of 2 and 3 ticks fall in the same bucket, so the routines share a fingerprint
+    auto home_fingerprint = history_game::datamodel::action::sequence_fingerprint_system::computeFingerprint(home);
+    auto field_fingerprint = history_game::datamodel::action::sequence_fingerprint_system::computeFingerprint(field);
+    auto other_fingerprint = history_game::datamodel::action::sequence_fingerprint_system::computeFingerprint(other);
+    EXPECT_EQ(home_fingerprint.exact, field_fingerprint.exact);
+    EXPECT_NE(home_fingerprint.exact, other_fingerprint.exact);
+    EXPECT_LT(history_game::datamodel::action::sequence_fingerprint_system::estimateSimilarity(home_fingerprint, other_fingerprint), 0.5f);
+    
+    history_game::datamodel::memory::MemoryEpisode episode(0, 5, home, {}, 1);
+    auto episode_ref = history_game::datamodel::memory::MemoryEpisode::storage::make_entity(std::move(episode));
+    auto store = history_game::datamodel::memory::episode_store_system::insert({}, episode_ref);
+    
+    // The field routine is not the same sequence, but it is similar enough
+    EXPECT_FALSE(history_game::datamodel::memory::episode_store_system::find(store, field));
+    auto similar = history_game::systems::memory::findSimilarEpisode(store, field);
+    ASSERT_TRUE(similar);
+    EXPECT_EQ(similar.value(), episode_ref);
+    
+    // An unrelated sequence finds nothing
+    EXPECT_FALSE(history_game::systems::memory::findSimilarEpisode(store, other));
+}
+
+TEST(MemorySystemTest, SequenceTrieSharing) {
+    history_game::datamodel::entity::EntityRegistry registry;
+    history_game::datamodel::entity::Entity well("well", history_game::datamodel::world::Position(1.0f, 0.0f), registry);
+    auto well_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(well));
+    
+    auto make_identity = [&](const std::string& id) {
+        history_game::datamodel::entity::Entity entity(id, history_game::datamodel::world::Position(0.0f, 0.0f), registry);
+        history_game::datamodel::npc::NPCIdentity identity(
+            history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity)));
+        return history_game::datamodel::npc::NPCIdentity::storage::make_entity(std::move(identity));
+    };
+    
+    // Two villagers remember going to the well and resting there
+    auto make_sequence = [&](const history_game::datamodel::npc::NPCIdentity::ref_type& actor, uint64_t time, size_t length) {
+        std::vector<history_game::datamodel::memory::MemoryEntry::ref_type> entries;
+        history_game::datamodel::memory::MemoryEntry move(time, actor, history_game::datamodel::action::action_type::Move{}, well_ref);
+        entries.push_back(history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(move)));
+        if (length > 1) {
+            history_game::datamodel::memory::MemoryEntry rest(time + 1, actor, history_game::datamodel::action::action_type::Rest{}, well_ref);
+            entries.push_back(history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(rest)));
+        }
+        return history_game::systems::memory::createActionSequence(entries, "seq_" + actor->entity->id);
+    };
+    
+    auto alice = make_identity("alice");
+    auto bob = make_identity("bob");
+    
+    history_game::systems::memory::SequenceTrie trie;
+    auto alice_sequence = make_sequence(alice, 10, 2);
+    auto bob_sequence = make_sequence(bob, 20, 2);
+    trie.intern(alice_sequence, alice->entity->handle);
+    trie.intern(bob_sequence, bob->entity->handle);
+    
+    // Both follow the same path, but each keeps its own entries
+    EXPECT_EQ(trie.sequenceCount(), 1);
+    EXPECT_EQ(trie.nodeCount(), 3);
+    EXPECT_EQ(trie.countPerformers(alice_sequence), 2);
+    EXPECT_EQ(bob_sequence->steps.front().memory->actorHandle(), bob->entity->handle);
+    
+    // Recording the same behavior again does not count a new performer
+    trie.intern(make_sequence(alice, 30, 2), alice->entity->handle);
+    EXPECT_EQ(trie.countPerformers(alice_sequence), 2);
+    
+    // A prefix counts everyone whose sequence starts with it
+    auto prefix = make_sequence(bob, 40, 1);
+    EXPECT_EQ(trie.countPerformers(prefix), 2);
+    EXPECT_EQ(trie.sequenceCount(), 1);
+    
+    // Nobody did anything else
+    history_game::datamodel::memory::MemoryEntry gesture(50, bob, history_game::datamodel::action::action_type::Gesture{}, well_ref);
+    std::vector<history_game::datamodel::memory::MemoryEntry::ref_type> other_entries;
+    other_entries.push_back(history_game::datamodel::memory::MemoryEntry::storage::make_entity(std::move(gesture)));
+    auto other = history_game::systems::memory::createActionSequence(other_entries, "other");
+    EXPECT_EQ(trie.countPerformers(other), 0);
+    
+    // Only episodes an NPC interned can be released
+    EXPECT_FALSE(trie.release(prefix, bob->entity->handle));
+    EXPECT_FALSE(trie.release(other, bob->entity->handle));
+    
+    // Bob forgets the behavior, Alice still remembers it twice
+    EXPECT_TRUE(trie.release(make_sequence(bob, 60, 2), bob->entity->handle));
+    EXPECT_EQ(trie.countPerformers(alice_sequence), 1);
+    EXPECT_FALSE(trie.release(bob_sequence, bob->entity->handle));
+    EXPECT_TRUE(trie.release(alice_sequence, alice->entity->handle));
+    EXPECT_EQ(trie.countPerformers(alice_sequence), 1);
+    EXPECT_EQ(trie.nodeCount(), 3);
+    
+    // Once nobody remembers it the path is gone
+    EXPECT_TRUE(trie.release(alice_sequence, alice->entity->handle));
+    EXPECT_EQ(trie.countPerformers(prefix), 0);
+    EXPECT_EQ(trie.nodeCount(), 1);
+    EXPECT_EQ(trie.sequenceCount(), 0);
+    
+    // Removed nodes are reused
+    auto again = make_sequence(bob, 70, 2);
+    trie.intern(again, bob->entity->handle);
+    EXPECT_EQ(trie.nodeCount(), 3);
+    EXPECT_EQ(trie.countPerformers(again), 1);
+}
+
+// Test that interactions are applied to relationships in batches and decay lazily
+TEST(MemorySystemTest, RelationshipUpdates) {
+    history_game::datamodel::entity::EntityRegistry registry;
+    history_game::datamodel::memory::PerceptionBuffer empty_buffer({});
+    auto empty_perception = history_game::datamodel::memory::PerceptionBuffer::storage::make_entity(std::move(empty_buffer));
+    
+    // An NPC resting next to an idle observer
+    std::vector<history_game::datamodel::npc::NPC::ref_type> npcs;
+    for (int i = 0; i < 2; ++i) {
+        history_game::datamodel::entity::Entity entity("npc_" + std::to_string(i), history_game::datamodel::world::Position(2.0f * i, 0.0f), registry);
+        auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
+        
+        std::optional<history_game::datamodel::npc::NPCIdentity::ref_type> identity_ref;
+        if (i == 1) {
+            history_game::datamodel::npc::NPCIdentity identity(entity_ref, history_game::datamodel::action::action_type::Rest{});
+            identity_ref.emplace(history_game::datamodel::npc::NPCIdentity::storage::make_entity(std::move(identity)));
+        } else {
+            history_game::datamodel::npc::NPCIdentity identity(entity_ref);
+            identity_ref.emplace(history_game::datamodel::npc::NPCIdentity::storage::make_entity(std::move(identity)));
+        }
+        
+        history_game::datamodel::npc::NPC npc(identity_ref.value(), {}, empty_perception, {}, {}, {});
+        npcs.push_back(history_game::datamodel::npc::NPC::storage::make_entity(std::move(npc)));
+    }
+    const auto& rester = npcs[1]->getIdentity()->entity;
+    
+    history_game::datamodel::world::SimulationClock clock(5, 0, 100);
+    auto clock_ref = history_game::datamodel::world::SimulationClock::storage::make_entity(std::move(clock));
+    history_game::datamodel::world::World world(clock_ref, npcs, {});
+    auto world_ref = history_game::datamodel::world::World::storage::make_entity(std::move(world));
+    
+    auto world_after_actions = history_game::systems::action::executeAllActions(world_ref);
+    auto world_with_perceptions = history_game::systems::memory::processPerceptions(
+        world_after_actions, history_game::datamodel::relationship::RelationshipDecay(), 10.0f);
+    
+    // Interactions are only applied at the end of a batch
+    history_game::systems::relationship::RelationshipUpdater batched;
+    auto unchanged = batched.update(world_with_perceptions);
+    EXPECT_EQ(unchanged, world_with_perceptions);
+    EXPECT_EQ(batched.pendingCount(), 2);
+    
+    // A batch of one tick applies them right away
+    history_game::systems::relationship::RelationshipUpdater updater(
+        history_game::systems::relationship::RelationshipParameters(0.02f, 0.05f, 0.1f, 5.0f, 1));
+    auto updated = updater.update(world_with_perceptions);
+    EXPECT_EQ(updater.pendingCount(), 0);
+    
+    auto observed = history_game::datamodel::relationship::relationship_system::findRelationship(
+        updated->getNPCs()[0]->getRelationships(), rester);
+    ASSERT_TRUE(observed);
+    EXPECT_FLOAT_EQ(observed.value()->familiarity, 0.02f);
+    EXPECT_EQ(observed.value()->last_interaction, 5);
+    EXPECT_EQ(observed.value()->interaction_count, 1);
+    
+    // The resting NPC gets to know the place it rests in
+    EXPECT_TRUE(history_game::datamodel::relationship::relationship_system::findLocationRelationship(
+        updated->getNPCs()[1]->getRelationships(), rester->position));
+    
+    // And the idle NPC it saw, through its own observation of it
+    auto seen = history_game::datamodel::relationship::relationship_system::findRelationship(
+        updated->getNPCs()[1]->getRelationships(), npcs[0]->getIdentity()->entity);
+    ASSERT_TRUE(seen);
+    EXPECT_FLOAT_EQ(seen.value()->familiarity, 0.02f);
+    EXPECT_TRUE(seen.value()->affective_traces.empty());
+    uint64_t created = updater.createdCount();
+    
+    // Interacting again updates the existing relationships
+    auto again = updater.update(updated);
+    EXPECT_EQ(updater.createdCount(), created);
+    EXPECT_GT(updater.updatedCount(), 0);
+    
+    auto reobserved = history_game::datamodel::relationship::relationship_system::findRelationship(
+        again->getNPCs()[0]->getRelationships(), rester);
+    ASSERT_TRUE(reobserved);
+    EXPECT_FLOAT_EQ(reobserved.value()->familiarity, 0.04f);
+    EXPECT_EQ(reobserved.value()->interaction_count, 2);
+    EXPECT_EQ(again->getNPCs()[0]->getRelationships().size(), updated->getNPCs()[0]->getRelationships().size());
+    
+    // Familiarity fades when read long after the last interaction
+    EXPECT_FLOAT_EQ(
+        history_game::datamodel::relationship::relationship_system::getFamiliarity(
+            *reobserved.value(), 5 + 2000, updater.parameters().decay),
+        0.02f);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <history_game/systems/perception/convergence_detector.h>
+#include <history_game/datamodel/entity/entity.h>
+#include <history_game/datamodel/npc/npc.h>
+#include <history_game/datamodel/memory/memory_entry.h>
+#include <history_game/datamodel/action/action_type.h>
+#include <history_game/datamodel/world/position.h>
+#include <history_game/datamodel/world/world.h>
+#include <history_game/datamodel/world/simulation_clock.h>
+
+// Use namespaces to avoid repetition, but only up to two levels
+using namespace history_game::datamodel;
+// Don't use systems namespace due to name conflicts
+
+// Test convergence detection over space-time windows
+TEST(ConvergenceDetectorTest, DetectsConvergence) {
+    entity::EntityRegistry registry;
+    auto perception = memory::PerceptionBuffer::storage::make_entity(memory::PerceptionBuffer({}));
+
+    // The detector finds where actors are through the world their events are in
+    std::vector<npc::NPC::ref_type> actors;
+    auto make_event = [&](const std::string& id, float x, float y, uint64_t tick, auto action_type) {
+        entity::Entity entity(id, world::Position(x, y), registry);
+        npc::NPCIdentity identity(entity::Entity::storage::make_entity(std::move(entity)));
+        auto identity_ref = npc::NPCIdentity::storage::make_entity(std::move(identity));
+        actors.push_back(npc::NPC::storage::make_entity(npc::NPC(identity_ref, {}, perception, {}, {}, {})));
+        memory::MemoryEntry entry(tick, identity_ref, action_type);
+        return memory::MemoryEntry::storage::make_entity(std::move(entry));
+    };
+    auto make_world = [&](std::vector<memory::MemoryEntry::ref_type> events, uint64_t tick) {
+        auto clock = world::SimulationClock::storage::make_entity(tick, 0, 100);
+        world::World current(clock, std::move(actors), {}, std::move(events));
+        actors.clear();
+        return current;
+    };
+
+    // Cells of 10 units, actions count for 5 ticks, 3 NPCs make a convergence
+    history_game::systems::perception::ConvergenceDetector detector(
+        history_game::systems::perception::ConvergenceParams(10.0f, 5, 3));
+
+    // Two NPCs rest near each other; a third rests far away
+    std::vector<memory::MemoryEntry::ref_type> tick1;
+    tick1.push_back(make_event("a", 1.0f, 1.0f, 1, action::action_type::Rest{}));
+    tick1.push_back(make_event("b", 2.0f, 3.0f, 1, action::action_type::Rest{}));
+    tick1.push_back(make_event("c", 50.0f, 50.0f, 1, action::action_type::Rest{}));
+    EXPECT_TRUE(detector.observe(make_world(tick1, 1), 1).empty());
+
+    // A third NPC joins them a few ticks later, within the window
+    std::vector<memory::MemoryEntry::ref_type> tick3;
+    tick3.push_back(make_event("d", 4.0f, 8.0f, 3, action::action_type::Rest{}));
+    tick3.push_back(make_event("e", 5.0f, 5.0f, 3, action::action_type::Gesture{}));
+    auto convergences = detector.observe(make_world(tick3, 3), 3);
+    ASSERT_EQ(convergences.size(), 1);
+    EXPECT_EQ(convergences[0].participants, 3);
+    EXPECT_EQ(convergences[0].cell_x, 0);
+    EXPECT_EQ(convergences[0].cell_y, 0);
+    EXPECT_TRUE(std::holds_alternative<action::action_type::Rest>(convergences[0].action));
+    EXPECT_EQ(detector.activeCount(), 1);
+
+    // Another NPC resting there does not raise the same convergence again
+    std::vector<memory::MemoryEntry::ref_type> tick4;
+    tick4.push_back(make_event("f", 6.0f, 6.0f, 4, action::action_type::Rest{}));
+    EXPECT_TRUE(detector.observe(make_world(tick4, 4), 4).empty());
+
+    // Once the first actions leave the window the convergence ends
+    EXPECT_TRUE(detector.observe(make_world({}, 8), 8).empty());
+    EXPECT_EQ(detector.activeCount(), 0);
+
+    // And it can be raised again
+    std::vector<memory::MemoryEntry::ref_type> tick9;
+    tick9.push_back(make_event("a", 1.0f, 1.0f, 9, action::action_type::Rest{}));
+    tick9.push_back(make_event("b", 2.0f, 3.0f, 9, action::action_type::Rest{}));
+    tick9.push_back(make_event("c", 3.0f, 3.0f, 9, action::action_type::Rest{}));
+    EXPECT_EQ(detector.observe(make_world(tick9, 9), 9).size(), 1);
+    EXPECT_EQ(detector.totalConvergences(), 2);
+}
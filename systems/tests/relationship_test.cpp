@@ -0,0 +1,110 @@
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <history_game/systems/relationship/social_graph.h>
+#include <history_game/datamodel/entity/entity.h>
+#include <history_game/datamodel/memory/perception_buffer.h>
+#include <history_game/datamodel/npc/npc.h>
+#include <history_game/datamodel/npc/npc_identity.h>
+#include <history_game/datamodel/relationship/relationship.h>
+#include <history_game/datamodel/world/position.h>
+#include <history_game/datamodel/world/world.h>
+#include <history_game/datamodel/world/simulation_clock.h>
+
+// Don't use "using namespace" for the ambiguous namespaces
+
+// Test the population-wide social graph and its analytics
+TEST(RelationshipSystemTest, SocialGraph) {
+    history_game::datamodel::entity::EntityRegistry registry;
+    history_game::datamodel::memory::PerceptionBuffer empty_buffer({});
+    auto empty_perception = history_game::datamodel::memory::PerceptionBuffer::storage::make_entity(std::move(empty_buffer));
+    
+    std::vector<history_game::datamodel::npc::NPCIdentity::ref_type> identities;
+    for (int i = 0; i < 5; ++i) {
+        history_game::datamodel::entity::Entity entity("npc_" + std::to_string(i), history_game::datamodel::world::Position(1.0f * i, 0.0f), registry);
+        auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
+        identities.push_back(history_game::datamodel::npc::NPCIdentity::storage::make_entity(
+            history_game::datamodel::npc::NPCIdentity(entity_ref)));
+    }
+    
+    auto know = [&](int target, float familiarity) {
+        history_game::datamodel::relationship::Relationship relationship(
+            identities[target]->entity, familiarity,
+            { history_game::datamodel::relationship::AffectiveTrace(history_game::datamodel::npc::drive::Belonging{}, 0.5f) },
+            10, 1);
+        return history_game::datamodel::relationship::Relationship::storage::make_entity(std::move(relationship));
+    };
+    auto make_npc = [&](int i, std::vector<history_game::datamodel::relationship::Relationship::ref_type> relationships) {
+        history_game::datamodel::npc::NPC npc(identities[i], {}, empty_perception, {}, {}, std::move(relationships));
+        return history_game::datamodel::npc::NPC::storage::make_entity(std::move(npc));
+    };
+    auto make_world = [&](std::vector<history_game::datamodel::npc::NPC::ref_type> npcs) {
+        history_game::datamodel::world::SimulationClock clock(10, 0, 100);
+        auto clock_ref = history_game::datamodel::world::SimulationClock::storage::make_entity(std::move(clock));
+        history_game::datamodel::world::World world(clock_ref, std::move(npcs), {});
+        return history_game::datamodel::world::World::storage::make_entity(std::move(world));
+    };
+    
+    // A triangle of 0, 1 and 2, and a pair of 3 and 4
+    std::vector<history_game::datamodel::npc::NPC::ref_type> npcs;
+    npcs.push_back(make_npc(0, { know(1, 0.8f), know(2, 0.6f) }));
+    npcs.push_back(make_npc(1, { know(2, 0.7f) }));
+    npcs.push_back(make_npc(2, { know(0, 0.9f) }));
+    npcs.push_back(make_npc(3, { know(4, 0.5f) }));
+    npcs.push_back(make_npc(4, {}));
+    auto world = make_world(npcs);
+    
+    history_game::systems::relationship::SocialGraph graph(
+        history_game::datamodel::relationship::RelationshipDecay(), 2);
+    graph.sync(world);
+    EXPECT_EQ(graph.nodeCount(), 5);
+    EXPECT_EQ(graph.edgeCount(), 5);
+    EXPECT_EQ(graph.rereadCount(), 5);
+    
+    auto degrees = graph.getDegrees();
+    EXPECT_EQ(degrees.out[0], 2);
+    EXPECT_EQ(degrees.in[2], 2);
+    EXPECT_EQ(degrees.in[3], 0);
+    EXPECT_FLOAT_EQ(degrees.strength[2], 0.6f + 0.7f);
+    
+    auto components = graph.getConnectedComponents();
+    EXPECT_EQ(history_game::systems::relationship::social_graph_system::countLabels(components), 2);
+    EXPECT_EQ(components[2], 0);
+    EXPECT_EQ(components[4], 3);
+    
+    auto communities = graph.getCommunities();
+    EXPECT_EQ(history_game::systems::relationship::social_graph_system::countLabels(communities), 2);
+    EXPECT_EQ(communities[0], communities[1]);
+    EXPECT_EQ(communities[3], communities[4]);
+    EXPECT_NE(communities[0], communities[3]);
+    
+    auto affect = graph.getIncomingAffect(history_game::datamodel::npc::drive::Belonging{});
+    EXPECT_FLOAT_EQ(affect[2], 1.0f);
+    
+    // Only the NPC whose relationships changed is read again
+    std::vector<history_game::datamodel::npc::NPC::ref_type> next_npcs(npcs.begin(), npcs.end() - 1);
+    next_npcs.push_back(make_npc(4, { know(0, 0.4f) }));
+    graph.sync(make_world(next_npcs));
+    EXPECT_EQ(graph.rereadCount(), 1);
+    EXPECT_EQ(graph.edgeCount(), 6);
+    EXPECT_EQ(history_game::systems::relationship::social_graph_system::countLabels(graph.getConnectedComponents()), 1);
+}
+
+// Test that the graph's workers are reused across runs
+TEST(RelationshipSystemTest, WorkerPoolReuse) {
+    history_game::systems::relationship::social_graph_system::WorkerPool workers(4);
+    EXPECT_EQ(workers.size(), 4);
+    
+    for (size_t count : {0, 1, 3, 4, 100, 1000}) {
+        std::vector<int> visits(count, 0);
+        workers.parallelFor(count, [&](size_t begin, size_t end, size_t worker) {
+            EXPECT_LT(worker, workers.size());
+            for (size_t i = begin; i < end; ++i) {
+                visits[i]++;
+            }
+        });
+        for (int visit : visits) {
+            EXPECT_EQ(visit, 1);
+        }
+    }
+}
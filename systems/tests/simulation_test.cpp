@@ -0,0 +1,72 @@
+#include <string>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <history_game/systems/simulation/world_reclaimer.h>
+#include <history_game/systems/simulation/simulation_runner.h>
+#include <history_game/datamodel/entity/entity_registry.h>
+#include <history_game/datamodel/object/object.h>
+#include <history_game/datamodel/pool/pool_stats.h>
+#include <history_game/datamodel/world/world.h>
+#include <history_game/datamodel/world/simulation_clock.h>
+
+// Don't use "using namespace" for the ambiguous namespaces
+
+// Test that retired worlds are freed, whichever thread frees them
+TEST(SimulationTest, WorldReclaimer) {
+    auto live_worlds = [] {
+        for (const auto& stats : history_game::datamodel::pool::pool_system::getStats()) {
+            if (std::string(stats.name) == "World") {
+                return stats.live;
+            }
+        }
+        return uint64_t(0);
+    };
+    auto make_world = [] {
+        history_game::datamodel::world::SimulationClock clock(10, 0, 100);
+        auto clock_ref = history_game::datamodel::world::SimulationClock::storage::make_entity(std::move(clock));
+        history_game::datamodel::world::World world(clock_ref, {}, {});
+        return history_game::datamodel::world::World::storage::make_entity(std::move(world));
+    };
+
+    history_game::systems::simulation::WorldReclaimer reclaimer;
+    uint64_t before = live_worlds();
+    {
+        // Two ticks' worth of retired versions
+        reclaimer.retire(make_world());
+        reclaimer.retire(make_world());
+        reclaimer.advanceEpoch();
+        reclaimer.retire(make_world());
+    }
+    EXPECT_EQ(reclaimer.retiredCount(), 3);
+
+    reclaimer.drain();
+    EXPECT_EQ(reclaimer.reclaimedCount(), 3);
+    EXPECT_EQ(reclaimer.batchCount(), 2);
+    EXPECT_EQ(live_worlds(), before);
+}
+
+// Test that the handles of the entities leaving the world are released
+TEST(SimulationTest, ReleaseDeparted) {
+    history_game::datamodel::entity::EntityRegistry registry;
+    auto make_object = [&](const std::string& id) {
+        history_game::datamodel::entity::Entity entity(id, history_game::datamodel::world::Position(0.0f, 0.0f), registry);
+        auto entity_ref = history_game::datamodel::entity::Entity::storage::make_entity(std::move(entity));
+        auto creator = history_game::datamodel::npc::NPCIdentity::storage::make_entity(
+            history_game::datamodel::npc::NPCIdentity(entity_ref));
+        return history_game::datamodel::object::WorldObject::storage::make_entity(
+            history_game::datamodel::object::WorldObject(entity_ref, history_game::datamodel::object::object_category::Food{}, creator));
+    };
+    history_game::datamodel::world::SimulationClock clock(10, 0, 100);
+    auto clock_ref = history_game::datamodel::world::SimulationClock::storage::make_entity(std::move(clock));
+
+    auto eaten = make_object("eaten");
+    auto kept = make_object("kept");
+    history_game::datamodel::world::World before(clock_ref, {}, {eaten, kept});
+    history_game::datamodel::world::World after(clock_ref, {}, {kept});
+    EXPECT_EQ(registry.liveCount(), 2);
+
+    history_game::systems::simulation::releaseDeparted(before, after, registry);
+    EXPECT_EQ(registry.liveCount(), 1);
+    EXPECT_FALSE(registry.isLive(eaten->entity->handle));
+    EXPECT_TRUE(registry.isLive(kept->entity->handle));
+}